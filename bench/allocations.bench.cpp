@@ -0,0 +1,133 @@
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "common.h"
+
+using namespace wincalc;
+
+// Allocations per call of the main Glazing_System queries.  Needs a library built with
+// WINCALC_ENABLE_ALLOCATION_PROFILING, otherwise these benchmarks are skipped.  Run them on
+// their own with --benchmark_filter=Allocations.  The allocations and allocated_bytes counters
+// are per call, and allocations/<stage> splits them by instrumentation stage.  Stages include
+// the stages nested in them.  Only the call is counted, not building the system.
+
+namespace
+{
+    struct Allocation_Totals
+    {
+        instrumentation::Allocations allocations;
+        instrumentation::Statistics statistics;
+    };
+
+    bool allocation_profiling(benchmark::State & state)
+    {
+        if(!instrumentation::allocation_profiling_enabled())
+        {
+            state.SkipWithError("wincalc was built without WINCALC_ENABLE_ALLOCATION_PROFILING");
+            return false;
+        }
+        return true;
+    }
+
+    template<typename Call>
+    void count_allocations(Allocation_Totals & totals, Call && call)
+    {
+        auto start_statistics = instrumentation::thread_statistics();
+        auto start = instrumentation::thread_allocations();
+        call();
+        auto end = instrumentation::thread_allocations();
+        auto recorded = instrumentation::thread_statistics();
+        recorded -= start_statistics;
+        totals.allocations.count += end.count - start.count;
+        totals.allocations.bytes += end.bytes - start.bytes;
+        totals.statistics += recorded;
+    }
+
+    void report_allocations(benchmark::State & state, Allocation_Totals const & totals)
+    {
+        state.counters["allocations"] = benchmark::Counter(
+          static_cast<double>(totals.allocations.count), benchmark::Counter::kAvgIterations);
+        state.counters["allocated_bytes"] = benchmark::Counter(
+          static_cast<double>(totals.allocations.bytes), benchmark::Counter::kAvgIterations);
+        for(size_t i = 0; i < instrumentation::stage_count; ++i)
+        {
+            auto stage = static_cast<instrumentation::Stage>(i);
+            auto allocations = totals.statistics[stage].allocations;
+            if(allocations > 0)
+            {
+                state.counters["allocations/" + std::string(instrumentation::name(stage))] =
+                  benchmark::Counter(static_cast<double>(allocations),
+                                     benchmark::Counter::kAvgIterations);
+            }
+        }
+    }
+}   // namespace
+
+static void BM_Allocations_U_Double_Clear(benchmark::State & state)
+{
+    if(!allocation_profiling(state))
+    {
+        return;
+    }
+    Allocation_Totals totals;
+    for(auto _ : state)
+    {
+        Glazing_System system(bench::nfrc_standard(),
+                              bench::double_clear_layers(),
+                              bench::air_gap(),
+                              1.0,
+                              1.0,
+                              90,
+                              nfrc_u_environments());
+        count_allocations(totals, [&system]() { benchmark::DoNotOptimize(system.u()); });
+    }
+    report_allocations(state, totals);
+}
+BENCHMARK(BM_Allocations_U_Double_Clear)->Unit(benchmark::kMillisecond);
+
+static void BM_Allocations_SHGC_Double_Clear(benchmark::State & state)
+{
+    if(!allocation_profiling(state))
+    {
+        return;
+    }
+    Allocation_Totals totals;
+    for(auto _ : state)
+    {
+        Glazing_System system(bench::nfrc_standard(),
+                              bench::double_clear_layers(),
+                              bench::air_gap(),
+                              1.0,
+                              1.0,
+                              90,
+                              nfrc_shgc_environments());
+        count_allocations(totals, [&system]() { benchmark::DoNotOptimize(system.shgc()); });
+    }
+    report_allocations(state, totals);
+}
+BENCHMARK(BM_Allocations_SHGC_Double_Clear)->Unit(benchmark::kMillisecond);
+
+static void BM_Allocations_Optical_Method_Results_Double_Clear(benchmark::State & state,
+                                                               std::string const & method)
+{
+    if(!allocation_profiling(state))
+    {
+        return;
+    }
+    Glazing_System system(bench::nfrc_standard(), bench::double_clear_layers(), bench::air_gap());
+    Allocation_Totals totals;
+    for(auto _ : state)
+    {
+        count_allocations(totals, [&system, &method]() {
+            benchmark::DoNotOptimize(system.optical_method_results(method));
+        });
+    }
+    report_allocations(state, totals);
+}
+BENCHMARK_CAPTURE(BM_Allocations_Optical_Method_Results_Double_Clear, SOLAR, std::string("SOLAR"))
+  ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Allocations_Optical_Method_Results_Double_Clear,
+                  PHOTOPIC,
+                  std::string("PHOTOPIC"))
+  ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,28 @@
+#include <benchmark/benchmark.h>
+
+#include "common.h"
+
+// Loading a Klems BSDF XML file through OpticsParser compared with the load_bsdf_xml_file fast
+// path.  state.range(0) is the number of threads for the fast path, zero is one per core.
+
+static void BM_BSDF_XML_Optics_Parser(benchmark::State & state)
+{
+    auto path = bench::test_path("products/2011-SA1.XML");
+    for(auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+          wincalc::convert_to_solid_layer(OpticsParser::parseBSDFXMLFile(path)));
+    }
+}
+BENCHMARK(BM_BSDF_XML_Optics_Parser)->Unit(benchmark::kMillisecond);
+
+static void BM_BSDF_XML_Fast(benchmark::State & state)
+{
+    auto path = bench::test_path("products/2011-SA1.XML");
+    for(auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+          wincalc::load_bsdf_xml_file(path, static_cast<size_t>(state.range(0))));
+    }
+}
+BENCHMARK(BM_BSDF_XML_Fast)->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond);
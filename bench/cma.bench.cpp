@@ -0,0 +1,107 @@
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "common.h"
+
+using namespace wincalc;
+
+namespace
+{
+    struct CMA_Inputs
+    {
+        thmxParser::ThmxFileContents top_frame;
+        thmxParser::ThmxFileContents bottom_frame;
+        thmxParser::ThmxFileContents jamb_frame;
+        double spacer_keff;
+        CMA_Frame_Set frames;
+    };
+
+    CMA_Inputs & cma_inputs()
+    {
+        static CMA_Inputs inputs = []() {
+            auto head = bench::test_path("products/sample-head_CMA.thmx");
+            auto sill = bench::test_path("products/sample-sill_CMA.thmx");
+            auto jamb = bench::test_path("products/sample-jamb_CMA.thmx");
+            auto spacer = bench::test_path("products/Spacer_CMA.thmx");
+            CMA_Frame_Library library;
+            return CMA_Inputs{
+              thmxParser::parseFile(head),
+              thmxParser::parseFile(sill),
+              thmxParser::parseFile(jamb),
+              get_spacer_keff(thmxParser::parseFile(spacer)),
+              cma_single_vision_frames(library.frame(head),
+                                       library.frame(sill),
+                                       library.frame(jamb),
+                                       library.frame(jamb))};
+        }();
+        return inputs;
+    }
+}   // namespace
+
+static void BM_CMA_Single_Vision_From_THMX(benchmark::State & state)
+{
+    auto & inputs = cma_inputs();
+    for(auto _ : state)
+    {
+        auto window = get_cma_window_single_vision(inputs.top_frame,
+                                                   inputs.bottom_frame,
+                                                   inputs.jamb_frame,
+                                                   inputs.jamb_frame,
+                                                   1.2,
+                                                   1.5);
+        benchmark::DoNotOptimize(calc_cma(window, 1.258, 0.341, 0.535, inputs.spacer_keff));
+    }
+}
+BENCHMARK(BM_CMA_Single_Vision_From_THMX);
+
+static void BM_CMA_Single_Vision_From_Library(benchmark::State & state)
+{
+    auto & inputs = cma_inputs();
+    for(auto _ : state)
+    {
+        auto window = inputs.frames.window(1.2, 1.5);
+        benchmark::DoNotOptimize(calc_cma(window, 1.258, 0.341, 0.535, inputs.spacer_keff));
+    }
+}
+BENCHMARK(BM_CMA_Single_Vision_From_Library);
+
+// state.range(0) glazings x 3 spacers x 10 sizes
+static void BM_CMA_Table(benchmark::State & state)
+{
+    auto & inputs = cma_inputs();
+    std::vector<CMA_Glazing> glazings;
+    for(int64_t i = 0; i < state.range(0); ++i)
+    {
+        auto fraction = static_cast<double>(i) / static_cast<double>(state.range(0));
+        glazings.push_back(
+          CMA_Glazing{0.8 + 2.0 * fraction, 0.2 + 0.5 * fraction, 0.3 + 0.5 * fraction});
+    }
+    std::vector<double> spacer_keffs{inputs.spacer_keff, 0.1, 1.0};
+    std::vector<CMA_Window_Size> sizes;
+    for(int i = 0; i < 10; ++i)
+    {
+        sizes.push_back(CMA_Window_Size{0.6 + 0.15 * i, 0.9 + 0.2 * i});
+    }
+
+    for(auto _ : state)
+    {
+        benchmark::DoNotOptimize(calc_cma_table(inputs.frames, glazings, spacer_keffs, sizes));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(glazings.size()
+                                                                      * spacer_keffs.size()
+                                                                      * sizes.size()));
+}
+BENCHMARK(BM_CMA_Table)->Arg(10)->Arg(100);
+
+static void BM_CMA_Glazing_Double_Clear(benchmark::State & state)
+{
+    for(auto _ : state)
+    {
+        Glazing_System system(
+          bench::nfrc_standard(), bench::double_clear_layers(), bench::air_gap());
+        benchmark::DoNotOptimize(system.cma_glazing());
+    }
+}
+BENCHMARK(BM_CMA_Glazing_Double_Clear)->Unit(benchmark::kMillisecond);
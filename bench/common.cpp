@@ -0,0 +1,100 @@
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+
+#include "common.h"
+
+namespace bench
+{
+    std::string test_path(std::string const & relative_path)
+    {
+        char const * environment_dir = std::getenv("WINCALC_TEST_DIR");
+        std::filesystem::path path(environment_dir ? environment_dir : WINCALC_TEST_DIR);
+        path /= relative_path;
+        return path.string();
+    }
+
+    window_standards::Optical_Standard const & nfrc_standard()
+    {
+        static const auto standard =
+          window_standards::load_optical_standard(test_path("standards/W5_NFRC_2003.std"));
+        return standard;
+    }
+
+    std::shared_ptr<OpticsParser::ProductData> parsed_product(std::string const & file_name)
+    {
+        static std::map<std::string, std::shared_ptr<OpticsParser::ProductData>> products;
+        auto itr = products.find(file_name);
+        if(itr == products.end())
+        {
+            OpticsParser::Parser parser;
+            itr = products
+                    .emplace(file_name, parser.parseJSONFile(test_path("products/" + file_name)))
+                    .first;
+        }
+        return itr->second;
+    }
+
+    wincalc::Product_Data_Optical_Thermal const & converted_product(std::string const & file_name)
+    {
+        static std::map<std::string, wincalc::Product_Data_Optical_Thermal> products;
+        auto itr = products.find(file_name);
+        if(itr == products.end())
+        {
+            itr = products
+                    .emplace(file_name, wincalc::convert_to_solid_layer(parsed_product(file_name)))
+                    .first;
+        }
+        return itr->second;
+    }
+
+    std::vector<wincalc::Product_Data_Optical_Thermal> const & double_clear_layers()
+    {
+        static const std::vector<wincalc::Product_Data_Optical_Thermal> layers{
+          converted_product("CLEAR_3.json"), converted_product("CLEAR_3.json")};
+        return layers;
+    }
+
+    std::vector<wincalc::Engine_Gap_Info> const & air_gap()
+    {
+        static const std::vector<wincalc::Engine_Gap_Info> gaps{
+          wincalc::Engine_Gap_Info(Gases::GasDef::Air, 0.0127)};
+        return gaps;
+    }
+
+    std::vector<wincalc::Product_Data_Optical_Thermal> const & venetian_layers()
+    {
+        static const std::vector<wincalc::Product_Data_Optical_Thermal> layers{
+          wincalc::create_venetian_blind(wincalc::Venetian_Geometry{45, 0.05, 0.07, 0.03},
+                                         parsed_product("igsdb_12852.json")),
+          converted_product("CLEAR_3.json")};
+        return layers;
+    }
+
+    std::vector<wincalc::Product_Data_Optical_Thermal> const & woven_layers()
+    {
+        static const std::vector<wincalc::Product_Data_Optical_Thermal> layers{
+          wincalc::create_woven_shade(wincalc::Woven_Geometry{0.002, 0.003, 0.002},
+                                      parsed_product("igsdb_12852.json")),
+          converted_product("CLEAR_3.json")};
+        return layers;
+    }
+
+    std::vector<wincalc::Product_Data_Optical_Thermal> const & perforated_layers()
+    {
+        static const std::vector<wincalc::Product_Data_Optical_Thermal> layers{
+          wincalc::create_perforated_screen(
+            wincalc::Perforated_Geometry{
+              0.02, 0.03, 0.002, 0.003, wincalc::Perforated_Geometry::Type::RECTANGULAR},
+            parsed_product("igsdb_12852.json")),
+          converted_product("CLEAR_3.json")};
+        return layers;
+    }
+
+    SingleLayerOptics::CBSDFHemisphere const & quarter_basis()
+    {
+        static const auto basis =
+          SingleLayerOptics::CBSDFHemisphere::create(SingleLayerOptics::BSDFBasis::Quarter);
+        return basis;
+    }
+}   // namespace bench
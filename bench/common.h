@@ -0,0 +1,40 @@
+#ifndef WINCALC_BENCH_COMMON_H_
+#define WINCALC_BENCH_COMMON_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "wincalc/wincalc.h"
+
+// Shared inputs for the benchmarks.  Everything is loaded from test/products and
+// test/standards once, the first time it is used, so loading never counts towards the time of
+// a benchmark.
+namespace bench
+{
+    // Path of a file in the test data directory.  The directory is WINCALC_TEST_DIR from the
+    // environment if set, otherwise the test directory of the source tree.
+    std::string test_path(std::string const & relative_path);
+
+    window_standards::Optical_Standard const & nfrc_standard();
+
+    std::shared_ptr<OpticsParser::ProductData> parsed_product(std::string const & file_name);
+    wincalc::Product_Data_Optical_Thermal const & converted_product(std::string const & file_name);
+
+    // CLEAR_3 / 12.7 mm air / CLEAR_3
+    std::vector<wincalc::Product_Data_Optical_Thermal> const & double_clear_layers();
+    std::vector<wincalc::Engine_Gap_Info> const & air_gap();
+
+    // Shade made from igsdb_12852 in front of CLEAR_3, the same systems as the user shade tests
+    std::vector<wincalc::Product_Data_Optical_Thermal> const & venetian_layers();
+    std::vector<wincalc::Product_Data_Optical_Thermal> const & woven_layers();
+    std::vector<wincalc::Product_Data_Optical_Thermal> const & perforated_layers();
+
+    SingleLayerOptics::CBSDFHemisphere const & quarter_basis();
+
+    // Registers the benchmarks that depend on the contents of the test data, e.g. one
+    // benchmark per optical method of the standard.  Called by main before running.
+    void register_optical_method_benchmarks();
+}   // namespace bench
+
+#endif
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "common.h"
+
+using namespace wincalc;
+
+// Thermal benchmarks build a new system from already converted layers in every iteration so
+// nothing cached by a previous iteration is reused.  Building the system is cheap compared to
+// solving it.
+
+static void BM_U_Double_Clear(benchmark::State & state)
+{
+    for(auto _ : state)
+    {
+        Glazing_System system(bench::nfrc_standard(),
+                              bench::double_clear_layers(),
+                              bench::air_gap(),
+                              1.0,
+                              1.0,
+                              90,
+                              nfrc_u_environments());
+        benchmark::DoNotOptimize(system.u());
+    }
+}
+BENCHMARK(BM_U_Double_Clear)->Unit(benchmark::kMillisecond);
+
+static void BM_SHGC_Double_Clear(benchmark::State & state)
+{
+    for(auto _ : state)
+    {
+        Glazing_System system(bench::nfrc_standard(),
+                              bench::double_clear_layers(),
+                              bench::air_gap(),
+                              1.0,
+                              1.0,
+                              90,
+                              nfrc_shgc_environments());
+        benchmark::DoNotOptimize(system.shgc());
+    }
+}
+BENCHMARK(BM_SHGC_Double_Clear)->Unit(benchmark::kMillisecond);
+
+static void BM_Thermal_Report_Double_Clear(benchmark::State & state)
+{
+    for(auto _ : state)
+    {
+        Glazing_System system(
+          bench::nfrc_standard(), bench::double_clear_layers(), bench::air_gap());
+        benchmark::DoNotOptimize(system.thermal_report());
+    }
+}
+BENCHMARK(BM_Thermal_Report_Double_Clear)->Unit(benchmark::kMillisecond);
+
+static void BM_Deflection_Double_Clear(benchmark::State & state)
+{
+    for(auto _ : state)
+    {
+        Glazing_System system(
+          bench::nfrc_standard(), bench::double_clear_layers(), bench::air_gap());
+        system.enable_deflection(true);
+        benchmark::DoNotOptimize(
+          system.calc_deflection_properties(Tarcog::ISO15099::System::Uvalue));
+    }
+}
+BENCHMARK(BM_Deflection_Double_Clear)->Unit(benchmark::kMillisecond);
+
+static void BM_Color_Double_Clear(benchmark::State & state)
+{
+    Glazing_System system(
+      bench::nfrc_standard(), bench::double_clear_layers(), bench::air_gap());
+    for(auto _ : state)
+    {
+        benchmark::DoNotOptimize(system.color());
+    }
+}
+BENCHMARK(BM_Color_Double_Clear)->Unit(benchmark::kMillisecond);
+
+static void BM_Thermal_IR_Clear(benchmark::State & state)
+{
+    auto const & layer = bench::converted_product("CLEAR_3.json");
+    for(auto _ : state)
+    {
+        benchmark::DoNotOptimize(calc_thermal_ir(bench::nfrc_standard(), layer));
+    }
+}
+BENCHMARK(BM_Thermal_IR_Clear)->Unit(benchmark::kMillisecond);
+
+namespace bench
+{
+    void register_optical_method_benchmarks()
+    {
+        // Methods that optical_method_results refuses to calculate
+        const std::vector<std::string> excluded{"THERMAL IR",
+                                                "COLOR_TRISTIMX",
+                                                "COLOR_TRISTIMY",
+                                                "COLOR_TRISTIMZ",
+                                                "CRI_X",
+                                                "CRI_Y",
+                                                "CRI_Z"};
+        for(auto const & method : nfrc_standard().methods)
+        {
+            auto const & name = method.first;
+            if(std::find(excluded.begin(), excluded.end(), name) != excluded.end())
+            {
+                continue;
+            }
+            benchmark::RegisterBenchmark(("BM_Optical_Method_Results_Double_Clear/" + name).c_str(),
+                                         [name](benchmark::State & state) {
+                                             Glazing_System system(nfrc_standard(),
+                                                                   double_clear_layers(),
+                                                                   air_gap());
+                                             for(auto _ : state)
+                                             {
+                                                 benchmark::DoNotOptimize(
+                                                   system.optical_method_results(name));
+                                             }
+                                         })
+              ->Unit(benchmark::kMillisecond);
+        }
+    }
+}   // namespace bench
@@ -0,0 +1,36 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "common.h"
+
+// Google Benchmark main with JSON as the default output format so results from different
+// versions can be compared by tools.  Any --benchmark_format argument overrides the default,
+// and --benchmark_out=<file> writes JSON to a file as usual.
+int main(int argc, char * argv[])
+{
+    std::string json_format("--benchmark_format=json");
+    std::vector<char *> arguments(argv, argv + argc);
+    bool format_given = false;
+    for(int i = 1; i < argc; ++i)
+    {
+        format_given = format_given || std::strncmp(argv[i], "--benchmark_format", 18) == 0;
+    }
+    if(!format_given)
+    {
+        arguments.insert(arguments.begin() + 1, &json_format[0]);
+    }
+    int argument_count = static_cast<int>(arguments.size());
+
+    bench::register_optical_method_benchmarks();
+    benchmark::Initialize(&argument_count, arguments.data());
+    if(benchmark::ReportUnrecognizedArguments(argument_count, arguments.data()))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "common.h"
+
+using namespace wincalc;
+
+// Shade systems use the quarter BSDF basis, the same as the user shade tests
+
+namespace
+{
+    using Layers = std::vector<Product_Data_Optical_Thermal>;
+
+    std::shared_ptr<Glazing_System> shade_system(Layers const & layers,
+                                                 Environments const & environment)
+    {
+        return std::make_shared<Glazing_System>(bench::nfrc_standard(),
+                              layers,
+                              bench::air_gap(),
+                              1.0,
+                              1.0,
+                              90,
+                              environment,
+                              bench::quarter_basis());
+    }
+
+    void shade_u(benchmark::State & state, Layers const & (*layers)())
+    {
+        for(auto _ : state)
+        {
+            auto system = shade_system(layers(), nfrc_u_environments());
+            benchmark::DoNotOptimize(system->u());
+        }
+    }
+
+    void shade_shgc(benchmark::State & state, Layers const & (*layers)())
+    {
+        for(auto _ : state)
+        {
+            auto system = shade_system(layers(), nfrc_shgc_environments());
+            benchmark::DoNotOptimize(system->shgc());
+        }
+    }
+
+    void shade_solar(benchmark::State & state, Layers const & (*layers)())
+    {
+        auto system = shade_system(layers(), nfrc_u_environments());
+        for(auto _ : state)
+        {
+            benchmark::DoNotOptimize(system->optical_method_results("SOLAR"));
+        }
+    }
+}   // namespace
+
+BENCHMARK_CAPTURE(shade_u, Venetian, bench::venetian_layers)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(shade_u, Woven, bench::woven_layers)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(shade_u, Perforated, bench::perforated_layers)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(shade_shgc, Venetian, bench::venetian_layers)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(shade_shgc, Woven, bench::woven_layers)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(shade_shgc, Perforated, bench::perforated_layers)
+  ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(shade_solar, Venetian, bench::venetian_layers)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(shade_solar, Woven, bench::woven_layers)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(shade_solar, Perforated, bench::perforated_layers)
+  ->Unit(benchmark::kMillisecond);
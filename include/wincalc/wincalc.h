@@ -6,5 +6,13 @@
 #include "../../src/cma.h"
 #include "../../src/thermal_ir.h"
 #include "../../src/shade_factories.h"
+#include "../../src/product_library.h"
+#include "../../src/bulk_import.h"
+#include "../../src/bsdf_xml.h"
+#include "../../src/result_columns.h"
+#include "../../src/optical_standard_cache.h"
+#include "../../src/cma_pipeline.h"
+#include "../../src/instrumentation.h"
+#include "../../src/trace.h"
 
 #endif
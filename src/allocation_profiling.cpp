@@ -0,0 +1,81 @@
+#include <cstdlib>
+#include <new>
+
+#include "instrumentation.h"
+
+// Replacements of the global operator new and delete that count the allocations of each
+// thread, see instrumentation.h.  The standard nothrow forms call these.  The over-aligned
+// forms are not replaced and keep their own matching new and delete.
+
+namespace wincalc::instrumentation
+{
+    namespace
+    {
+        // Plain thread_local integers need no construction or destruction so they can be used
+        // by allocations made while a thread starts or exits
+        thread_local uint64_t allocation_count = 0;
+        thread_local uint64_t allocated_bytes = 0;
+    }   // namespace
+
+    bool allocation_profiling_enabled()
+    {
+#ifdef WINCALC_ENABLE_ALLOCATION_PROFILING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    Allocations thread_allocations()
+    {
+        return Allocations{allocation_count, allocated_bytes};
+    }
+
+#ifdef WINCALC_ENABLE_ALLOCATION_PROFILING
+    namespace
+    {
+        void * counted_allocation(std::size_t size)
+        {
+            ++allocation_count;
+            allocated_bytes += size;
+            if(void * memory = std::malloc(size == 0 ? 1 : size))
+            {
+                return memory;
+            }
+            throw std::bad_alloc();
+        }
+    }   // namespace
+#endif
+}   // namespace wincalc::instrumentation
+
+#ifdef WINCALC_ENABLE_ALLOCATION_PROFILING
+void * operator new(std::size_t size)
+{
+    return wincalc::instrumentation::counted_allocation(size);
+}
+
+void * operator new[](std::size_t size)
+{
+    return wincalc::instrumentation::counted_allocation(size);
+}
+
+void operator delete(void * memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void * memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void * memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void * memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+#endif
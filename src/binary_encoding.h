@@ -0,0 +1,169 @@
+#ifndef WINCALC_BINARY_ENCODING_H_
+#define WINCALC_BINARY_ENCODING_H_
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Helpers shared by the binary file formats.  Values are written in the byte order of the
+// machine, each format records a byte order mark in its header.
+namespace wincalc
+{
+    namespace binary_encoding
+    {
+        // 64-bit FNV-1a
+        inline uint64_t fnv1a(char const * data, size_t size)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for(size_t i = 0; i < size; ++i)
+            {
+                hash ^= static_cast<unsigned char>(data[i]);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        struct Encoder
+        {
+            std::vector<char> data;
+
+            template<typename T>
+            void put(T value)
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "Can only encode POD values");
+                char bytes[sizeof(T)];
+                std::memcpy(bytes, &value, sizeof(T));
+                data.insert(data.end(), bytes, bytes + sizeof(T));
+            }
+
+            void put_bool(bool value)
+            {
+                put<uint8_t>(value ? 1 : 0);
+            }
+
+            void put_string(std::string const & value)
+            {
+                put<uint32_t>(static_cast<uint32_t>(value.size()));
+                data.insert(data.end(), value.begin(), value.end());
+            }
+
+            void put_optional(std::optional<double> const & value)
+            {
+                put_bool(value.has_value());
+                if(value.has_value())
+                {
+                    put<double>(value.value());
+                }
+            }
+
+            void put_vector(std::vector<double> const & values)
+            {
+                put<uint64_t>(values.size());
+                for(auto value : values)
+                {
+                    put<double>(value);
+                }
+            }
+
+            void put_matrix(std::vector<std::vector<double>> const & matrix)
+            {
+                put<uint64_t>(matrix.size());
+                for(auto const & row : matrix)
+                {
+                    put_vector(row);
+                }
+            }
+        };
+
+        struct Decoder
+        {
+            char const * data;
+            size_t size;
+            char const * description;
+            size_t position = 0;
+
+            // description is used in error messages, e.g. "Product library record"
+            Decoder(char const * data, size_t size, char const * description) :
+                data(data), size(size), description(description)
+            {}
+
+            void require(size_t count)
+            {
+                if(count > size - position)
+                {
+                    std::stringstream msg;
+                    msg << description << " is truncated: needed " << count
+                        << " bytes at offset " << position << " of " << size;
+                    throw std::runtime_error(msg.str());
+                }
+            }
+
+            template<typename T>
+            T get()
+            {
+                require(sizeof(T));
+                T value;
+                std::memcpy(&value, data + position, sizeof(T));
+                position += sizeof(T);
+                return value;
+            }
+
+            bool get_bool()
+            {
+                return get<uint8_t>() != 0;
+            }
+
+            std::string get_string()
+            {
+                auto length = get<uint32_t>();
+                require(length);
+                std::string value(data + position, length);
+                position += length;
+                return value;
+            }
+
+            std::optional<double> get_optional()
+            {
+                if(get_bool())
+                {
+                    return get<double>();
+                }
+                return std::optional<double>();
+            }
+
+            std::vector<double> get_vector()
+            {
+                auto count = get<uint64_t>();
+                if(count > (size - position) / sizeof(double))
+                {
+                    require(size - position + 1);
+                }
+                std::vector<double> values(count);
+                if(count > 0)
+                {
+                    std::memcpy(values.data(), data + position, count * sizeof(double));
+                }
+                position += count * sizeof(double);
+                return values;
+            }
+
+            std::vector<std::vector<double>> get_matrix()
+            {
+                auto rows = get<uint64_t>();
+                std::vector<std::vector<double>> matrix;
+                for(uint64_t i = 0; i < rows; ++i)
+                {
+                    matrix.push_back(get_vector());
+                }
+                return matrix;
+            }
+        };
+    }   // namespace binary_encoding
+}   // namespace wincalc
+
+#endif
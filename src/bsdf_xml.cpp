@@ -0,0 +1,398 @@
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string_view>
+#include <utility>
+
+#include "bsdf_xml.h"
+#include "util.h"
+
+namespace wincalc
+{
+    namespace
+    {
+        const size_t klems_full_size = 145;
+        const std::string_view klems_full_name = "LBNL/Klems Full";
+
+        struct Element
+        {
+            std::string_view attributes;
+            std::string_view content;
+            // Offset just past the closing tag
+            size_t end;
+        };
+
+        std::string_view trim(std::string_view text)
+        {
+            while(!text.empty() && std::isspace(static_cast<unsigned char>(text.front())))
+            {
+                text.remove_prefix(1);
+            }
+            while(!text.empty() && std::isspace(static_cast<unsigned char>(text.back())))
+            {
+                text.remove_suffix(1);
+            }
+            return text;
+        }
+
+        bool ends_tag_name(std::string_view xml, size_t position)
+        {
+            return position < xml.size()
+                   && (xml[position] == '>' || xml[position] == '/'
+                       || std::isspace(static_cast<unsigned char>(xml[position])));
+        }
+
+        // Finds the first element with the given name.  Elements with the same name are not
+        // nested in BSDF XML so the first matching closing tag ends the element.
+        std::optional<Element> find_element(std::string_view xml, std::string_view name)
+        {
+            size_t position = 0;
+            while((position = xml.find(name, position)) != std::string_view::npos)
+            {
+                auto after_name = position + name.size();
+                if(position == 0 || xml[position - 1] != '<' || !ends_tag_name(xml, after_name))
+                {
+                    position = after_name;
+                    continue;
+                }
+
+                auto tag_end = xml.find('>', after_name);
+                if(tag_end == std::string_view::npos)
+                {
+                    std::stringstream msg;
+                    msg << "Unterminated <" << name << "> tag in BSDF XML";
+                    throw std::runtime_error(msg.str());
+                }
+                auto attributes = xml.substr(after_name, tag_end - after_name);
+                if(!attributes.empty() && attributes.back() == '/')
+                {
+                    return Element{attributes, std::string_view(), tag_end + 1};
+                }
+
+                auto close = tag_end;
+                while((close = xml.find(name, close)) != std::string_view::npos)
+                {
+                    if(close >= 2 && xml[close - 1] == '/' && xml[close - 2] == '<'
+                       && ends_tag_name(xml, close + name.size()))
+                    {
+                        break;
+                    }
+                    close += name.size();
+                }
+                if(close == std::string_view::npos)
+                {
+                    std::stringstream msg;
+                    msg << "Missing </" << name << "> in BSDF XML";
+                    throw std::runtime_error(msg.str());
+                }
+                auto content = xml.substr(tag_end + 1, close - 2 - (tag_end + 1));
+                auto element_end = xml.find('>', close);
+                return Element{attributes,
+                               content,
+                               element_end == std::string_view::npos ? xml.size()
+                                                                      : element_end + 1};
+            }
+            return std::nullopt;
+        }
+
+        Element required_element(std::string_view xml, std::string_view name)
+        {
+            auto element = find_element(xml, name);
+            if(!element.has_value())
+            {
+                std::stringstream msg;
+                msg << "Missing <" << name << "> in BSDF XML";
+                throw std::runtime_error(msg.str());
+            }
+            return element.value();
+        }
+
+        std::optional<std::string_view> attribute(std::string_view attributes,
+                                                  std::string_view name)
+        {
+            auto position = attributes.find(name);
+            while(position != std::string_view::npos)
+            {
+                auto equals = position + name.size();
+                while(equals < attributes.size()
+                      && std::isspace(static_cast<unsigned char>(attributes[equals])))
+                {
+                    ++equals;
+                }
+                if(equals + 1 < attributes.size() && attributes[equals] == '=')
+                {
+                    auto quote = attributes.find_first_of("\"'", equals + 1);
+                    if(quote != std::string_view::npos)
+                    {
+                        auto close = attributes.find(attributes[quote], quote + 1);
+                        if(close != std::string_view::npos)
+                        {
+                            return attributes.substr(quote + 1, close - quote - 1);
+                        }
+                    }
+                }
+                position = attributes.find(name, position + name.size());
+            }
+            return std::nullopt;
+        }
+
+        double parse_double(std::string_view text, std::string_view name)
+        {
+            std::string value(trim(text));
+            char * end = nullptr;
+            double result = std::strtod(value.c_str(), &end);
+            if(value.empty() || end != value.c_str() + value.size())
+            {
+                std::stringstream msg;
+                msg << "Invalid value for <" << name << "> in BSDF XML: " << value;
+                throw std::runtime_error(msg.str());
+            }
+            return result;
+        }
+
+        std::optional<double> optional_double(std::string_view xml, std::string_view name)
+        {
+            auto element = find_element(xml, name);
+            if(!element.has_value())
+            {
+                return std::nullopt;
+            }
+            return parse_double(element->content, name);
+        }
+
+        double length_conversion(std::optional<std::string_view> unit)
+        {
+            // Same units and default as convert_to_solid_layer
+            if(!unit.has_value())
+            {
+                return 1.0 / 1000.0;
+            }
+            auto lower = to_lower(std::string(trim(unit.value())));
+            if(lower == "meter" || lower == "meters")
+            {
+                return 1.0;
+            }
+            if(lower == "millimeter")
+            {
+                return 1.0 / 1000.0;
+            }
+            std::stringstream msg;
+            msg << "Unsupported thickness unit: " << unit.value()
+                << " Currently only meter and millimeter are supported.";
+            throw std::runtime_error(msg.str());
+        }
+
+        void validate_basis(std::string_view basis)
+        {
+            if(trim(basis) != klems_full_name)
+            {
+                throw std::runtime_error(
+                  "Only \"LBNL/Klems Full\" is currently supported for a BSDF angle basis.");
+            }
+        }
+
+        // Reads the numbers straight out of the file contents into the rows of the matrix.
+        // Values are separated by commas and/or whitespace.
+        std::vector<std::vector<double>> parse_matrix(std::string_view text)
+        {
+            std::vector<std::vector<double>> matrix(klems_full_size);
+            for(auto & row : matrix)
+            {
+                row.reserve(klems_full_size);
+            }
+            size_t count = 0;
+
+            char const * position = text.data();
+            char const * end = position + text.size();
+            while(true)
+            {
+                while(position < end
+                      && (*position == ',' || std::isspace(static_cast<unsigned char>(*position))))
+                {
+                    ++position;
+                }
+                if(position == end)
+                {
+                    break;
+                }
+                // The contents always end in the closing tag so strtod cannot run off the end
+                // of the buffer.
+                char * next = nullptr;
+                double value = std::strtod(position, &next);
+                if(next == position || next > end)
+                {
+                    throw std::runtime_error("Invalid number in BSDF scattering data");
+                }
+                if(count == klems_full_size * klems_full_size)
+                {
+                    throw std::runtime_error(
+                      "Only \"LBNL/Klems Full\" is currently supported for a BSDF angle basis.");
+                }
+                matrix[count / klems_full_size].push_back(value);
+                ++count;
+                position = next;
+            }
+
+            if(count != klems_full_size * klems_full_size)
+            {
+                throw std::runtime_error(
+                  "Only \"LBNL/Klems Full\" is currently supported for a BSDF angle basis.");
+            }
+            return matrix;
+        }
+
+        // Solar tf, tb, rf, rb then visible tf, tb, rf, rb
+        const std::array<std::string_view, 4> directions{
+          "Transmission Front", "Transmission Back", "Reflection Front", "Reflection Back"};
+        const std::array<std::string_view, 2> bands{"Solar", "Visible"};
+
+        struct Scattering_Block
+        {
+            size_t index;
+            std::string_view data;
+        };
+
+        std::vector<Scattering_Block> find_scattering_blocks(std::string_view xml)
+        {
+            std::vector<Scattering_Block> blocks;
+            std::array<bool, 8> found{};
+            size_t position = 0;
+            while(auto wavelength_data = find_element(xml.substr(position), "WavelengthData"))
+            {
+                position += wavelength_data->end;
+                auto data = wavelength_data->content;
+
+                auto wavelength = trim(required_element(data, "Wavelength").content);
+                size_t band = 0;
+                while(band < bands.size() && wavelength != bands[band])
+                {
+                    ++band;
+                }
+                if(band == bands.size())
+                {
+                    // Other bands, e.g. infrared, are not used
+                    continue;
+                }
+
+                auto block = required_element(data, "WavelengthDataBlock").content;
+                auto direction_name =
+                  trim(required_element(block, "WavelengthDataDirection").content);
+                size_t direction = 0;
+                while(direction < directions.size() && direction_name != directions[direction])
+                {
+                    ++direction;
+                }
+                if(direction == directions.size())
+                {
+                    std::stringstream msg;
+                    msg << "Unknown BSDF data direction: " << direction_name;
+                    throw std::runtime_error(msg.str());
+                }
+                validate_basis(required_element(block, "ColumnAngleBasis").content);
+                validate_basis(required_element(block, "RowAngleBasis").content);
+
+                auto index = band * directions.size() + direction;
+                if(found[index])
+                {
+                    std::stringstream msg;
+                    msg << "Duplicate " << bands[band] << " " << direction_name << " BSDF data";
+                    throw std::runtime_error(msg.str());
+                }
+                found[index] = true;
+                blocks.push_back(
+                  Scattering_Block{index, required_element(block, "ScatteringData").content});
+            }
+
+            for(size_t i = 0; i < found.size(); ++i)
+            {
+                if(!found[i])
+                {
+                    std::stringstream msg;
+                    msg << "Missing " << bands[i / directions.size()] << " "
+                        << directions[i % directions.size()] << " BSDF data";
+                    throw std::runtime_error(msg.str());
+                }
+            }
+            return blocks;
+        }
+    }   // namespace
+
+    Product_Data_Optical_Thermal load_bsdf_xml_string(std::string const & contents,
+                                                      size_t number_of_threads)
+    {
+        std::string_view xml(contents);
+
+        auto material = required_element(xml, "Material").content;
+        auto thickness_element = required_element(material, "Thickness");
+        double thickness = parse_double(thickness_element.content, "Thickness")
+                           * length_conversion(attribute(thickness_element.attributes, "unit"));
+        auto conductivity = optional_double(material, "ThermalConductivity");
+        auto ir_transmittance = optional_double(material, "TIR");
+        auto emissivity_front = optional_double(material, "EmissivityFront");
+        auto emissivity_back = optional_double(material, "EmissivityBack");
+        auto permeability_factor = optional_double(material, "PermeabilityFactor");
+
+        auto angle_basis_name = find_element(xml, "AngleBasisName");
+        if(angle_basis_name.has_value())
+        {
+            validate_basis(angle_basis_name->content);
+        }
+
+        auto blocks = find_scattering_blocks(xml);
+        std::vector<std::vector<std::vector<double>>> matrices(blocks.size());
+        parallel_for(blocks.size(),
+                     thread_count(number_of_threads, blocks.size()),
+                     [&blocks, &matrices](size_t begin, size_t end) {
+                         for(size_t i = begin; i < end; ++i)
+                         {
+                             matrices[blocks[i].index] = parse_matrix(blocks[i].data);
+                         }
+                     });
+
+        auto optical = std::make_shared<Product_Data_Dual_Band_Optical_BSDF>(
+          std::move(matrices[0]),
+          std::move(matrices[1]),
+          std::move(matrices[2]),
+          std::move(matrices[3]),
+          std::move(matrices[4]),
+          std::move(matrices[5]),
+          std::move(matrices[6]),
+          std::move(matrices[7]),
+          SingleLayerOptics::CBSDFHemisphere::create(SingleLayerOptics::BSDFBasis::Full),
+          thickness,
+          ir_transmittance,
+          ir_transmittance,
+          emissivity_front,
+          emissivity_back,
+          permeability_factor.value_or(0));
+
+        auto thermal = std::make_shared<Product_Data_Thermal>(conductivity, thickness, false);
+        // BSDF XML files do not have density or Young's modulus so, as in convert_thermal,
+        // these are left unset.
+        thermal->density = std::nullopt;
+        thermal->youngs_modulus = std::nullopt;
+
+        return Product_Data_Optical_Thermal(optical, thermal);
+    }
+
+    Product_Data_Optical_Thermal load_bsdf_xml_file(std::string const & path,
+                                                    size_t number_of_threads)
+    {
+        std::ifstream input(path, std::ios::binary);
+        if(!input)
+        {
+            std::stringstream msg;
+            msg << "Unable to open " << path;
+            throw std::runtime_error(msg.str());
+        }
+        std::string contents;
+        input.seekg(0, std::ios::end);
+        contents.resize(static_cast<size_t>(input.tellg()));
+        input.seekg(0, std::ios::beg);
+        input.read(&contents[0], static_cast<std::streamsize>(contents.size()));
+        return load_bsdf_xml_string(contents, number_of_threads);
+    }
+}   // namespace wincalc
@@ -0,0 +1,26 @@
+#ifndef WINCALC_BSDF_XML_H_
+#define WINCALC_BSDF_XML_H_
+
+#include <string>
+
+#include "product_data.h"
+
+namespace wincalc
+{
+    // Fast path for loading dual band Klems full basis BSDF XML files, e.g. shades exported
+    // from WINDOW or produced by genBSDF.  Gives the same result as
+    //     convert_to_solid_layer(OpticsParser::parseBSDFXMLFile(path))
+    // but only reads the elements wincalc uses.  The numbers in each scattering data block are
+    // read directly from the file contents into the rows of its matrix, the blocks are parsed
+    // in parallel and the matrices are moved into the product without copying.
+    //
+    // Only the LBNL/Klems Full basis is supported and each of the eight solar and visible
+    // transmission and reflection blocks must be present exactly once.
+    // number_of_threads = 0 uses one thread per core, at most one per block.
+    Product_Data_Optical_Thermal load_bsdf_xml_file(std::string const & path,
+                                                    size_t number_of_threads = 0);
+    Product_Data_Optical_Thermal load_bsdf_xml_string(std::string const & contents,
+                                                      size_t number_of_threads = 0);
+}   // namespace wincalc
+
+#endif
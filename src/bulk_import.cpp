@@ -0,0 +1,413 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+#include "bulk_import.h"
+#include "convert_optics_parser.h"
+#include "util.h"
+
+namespace wincalc
+{
+    Json_Array_Reader::Json_Array_Reader(std::istream & input, size_t buffer_size) :
+        input(input), buffer(std::max(buffer_size, size_t(1)))
+    {}
+
+    bool Json_Array_Reader::get(char & c)
+    {
+        if(position == available)
+        {
+            input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            available = static_cast<size_t>(input.gcount());
+            position = 0;
+            if(available == 0)
+            {
+                return false;
+            }
+        }
+        c = buffer[position++];
+        return true;
+    }
+
+    bool Json_Array_Reader::skip_whitespace(char & c)
+    {
+        while(get(c))
+        {
+            if(!std::isspace(static_cast<unsigned char>(c)))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool Json_Array_Reader::next(std::string & element)
+    {
+        if(finished)
+        {
+            return false;
+        }
+
+        char c;
+        if(!started)
+        {
+            if(!skip_whitespace(c) || c != '[')
+            {
+                throw std::runtime_error("Input is not a JSON array");
+            }
+            started = true;
+            if(!skip_whitespace(c))
+            {
+                throw std::runtime_error("JSON array is not terminated");
+            }
+            if(c == ']')
+            {
+                finished = true;
+                return false;
+            }
+        }
+        else if(!skip_whitespace(c))
+        {
+            throw std::runtime_error("JSON array is not terminated");
+        }
+
+        element.clear();
+        size_t depth = 0;
+        bool in_string = false;
+        bool escaped = false;
+        while(true)
+        {
+            if(in_string)
+            {
+                element.push_back(c);
+                if(escaped)
+                {
+                    escaped = false;
+                }
+                else if(c == '\\')
+                {
+                    escaped = true;
+                }
+                else if(c == '"')
+                {
+                    in_string = false;
+                }
+            }
+            else if(c == '"')
+            {
+                element.push_back(c);
+                in_string = true;
+            }
+            else if(c == '{' || c == '[')
+            {
+                element.push_back(c);
+                ++depth;
+            }
+            else if(c == '}' || c == ']')
+            {
+                if(depth == 0)
+                {
+                    if(c == '}')
+                    {
+                        std::stringstream msg;
+                        msg << "Unexpected } in element " << elements << " of JSON array";
+                        throw std::runtime_error(msg.str());
+                    }
+                    finished = true;
+                    break;
+                }
+                element.push_back(c);
+                --depth;
+            }
+            else if(c == ',' && depth == 0)
+            {
+                break;
+            }
+            else
+            {
+                element.push_back(c);
+            }
+
+            if(!get(c))
+            {
+                throw std::runtime_error("JSON array is not terminated");
+            }
+        }
+
+        while(!element.empty() && std::isspace(static_cast<unsigned char>(element.back())))
+        {
+            element.pop_back();
+        }
+        if(element.empty())
+        {
+            std::stringstream msg;
+            msg << "Empty element " << elements << " in JSON array";
+            throw std::runtime_error(msg.str());
+        }
+        ++elements;
+        return true;
+    }
+
+    size_t Json_Array_Reader::count() const
+    {
+        return elements;
+    }
+
+    namespace
+    {
+        std::string error_message(std::exception_ptr const & error)
+        {
+            try
+            {
+                std::rethrow_exception(error);
+            }
+            catch(std::exception const & e)
+            {
+                return e.what();
+            }
+            catch(...)
+            {
+                return "Unknown error";
+            }
+        }
+    }   // namespace
+
+    Bulk_Import_Summary import_igsdb_json(std::istream & input,
+                                          Bulk_Import_Callback const & on_product,
+                                          Bulk_Import_Error_Callback const & on_error,
+                                          Bulk_Import_Options const & options)
+    {
+        auto number_of_threads =
+          thread_count(options.number_of_threads, std::numeric_limits<size_t>::max());
+        auto queue_size = options.queue_size == 0 ? 2 * number_of_threads : options.queue_size;
+
+        struct Work
+        {
+            size_t index;
+            std::string json;
+        };
+
+        // Elements read but not yet picked up by a worker
+        std::mutex queue_mutex;
+        std::condition_variable queue_not_full;
+        std::condition_variable queue_not_empty;
+        std::deque<Work> queue;
+        bool reading_done = false;
+
+        // Results are passed to the callbacks in input order, one at a time
+        std::mutex emit_mutex;
+        std::condition_variable emit_turn;
+        size_t next_to_emit = 0;
+        Bulk_Import_Summary summary;
+        std::exception_ptr error;
+
+        std::atomic<bool> stop{false};
+        auto request_stop = [&]() {
+            stop = true;
+            // Take each lock so no thread can miss the notification between checking stop and
+            // starting to wait.
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+            }
+            {
+                std::lock_guard<std::mutex> lock(emit_mutex);
+            }
+            queue_not_full.notify_all();
+            queue_not_empty.notify_all();
+            emit_turn.notify_all();
+        };
+
+        auto worker = [&]() {
+            while(true)
+            {
+                Work work;
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex);
+                    queue_not_empty.wait(
+                      lock, [&]() { return !queue.empty() || reading_done || stop; });
+                    if(stop || queue.empty())
+                    {
+                        return;
+                    }
+                    work = std::move(queue.front());
+                    queue.pop_front();
+                }
+                queue_not_full.notify_one();
+
+                std::shared_ptr<OpticsParser::ProductData> parsed;
+                std::optional<Product_Data_Optical_Thermal> product;
+                std::exception_ptr work_error;
+                try
+                {
+                    parsed = OpticsParser::parseJSONString(work.json);
+                    product = convert_to_solid_layer(parsed);
+                }
+                catch(...)
+                {
+                    work_error = std::current_exception();
+                }
+                // Only the converted product is needed from here on
+                work.json = std::string();
+
+                std::unique_lock<std::mutex> lock(emit_mutex);
+                emit_turn.wait(lock, [&]() { return next_to_emit == work.index || stop; });
+                if(stop)
+                {
+                    return;
+                }
+                try
+                {
+                    if(!work_error)
+                    {
+                        try
+                        {
+                            on_product(work.index, *parsed, product.value());
+                            ++summary.converted;
+                        }
+                        catch(...)
+                        {
+                            work_error = std::current_exception();
+                        }
+                    }
+                    if(work_error)
+                    {
+                        ++summary.failed;
+                        if(!on_error)
+                        {
+                            std::rethrow_exception(work_error);
+                        }
+                        on_error(work.index, error_message(work_error));
+                    }
+                }
+                catch(...)
+                {
+                    error = std::current_exception();
+                    lock.unlock();
+                    request_stop();
+                    return;
+                }
+                ++next_to_emit;
+                lock.unlock();
+                emit_turn.notify_all();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(number_of_threads);
+        try
+        {
+            for(size_t i = 0; i < number_of_threads; ++i)
+            {
+                workers.emplace_back(worker);
+            }
+        }
+        catch(...)
+        {
+            // Starting a thread failed.  The workers already started use this frame so they
+            // are stopped and joined before the exception leaves it.
+            request_stop();
+            for(auto & thread : workers)
+            {
+                thread.join();
+            }
+            throw;
+        }
+
+        std::exception_ptr read_error;
+        try
+        {
+            Json_Array_Reader reader(input);
+            std::string element;
+            while(!stop && reader.next(element))
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_not_full.wait(lock, [&]() { return queue.size() < queue_size || stop; });
+                if(stop)
+                {
+                    break;
+                }
+                queue.push_back(Work{reader.count() - 1, std::move(element)});
+                lock.unlock();
+                queue_not_empty.notify_one();
+                element = std::string();
+            }
+        }
+        catch(...)
+        {
+            read_error = std::current_exception();
+            request_stop();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            reading_done = true;
+        }
+        queue_not_empty.notify_all();
+
+        for(auto & thread : workers)
+        {
+            thread.join();
+        }
+
+        if(read_error)
+        {
+            std::rethrow_exception(read_error);
+        }
+        if(error)
+        {
+            std::rethrow_exception(error);
+        }
+        summary.products = summary.converted + summary.failed;
+        return summary;
+    }
+
+    Bulk_Import_Summary import_igsdb_json_file(std::string const & path,
+                                               Bulk_Import_Callback const & on_product,
+                                               Bulk_Import_Error_Callback const & on_error,
+                                               Bulk_Import_Options const & options)
+    {
+        std::ifstream input(path, std::ios::binary);
+        if(!input)
+        {
+            std::stringstream msg;
+            msg << "Unable to open " << path;
+            throw std::runtime_error(msg.str());
+        }
+        return import_igsdb_json(input, on_product, on_error, options);
+    }
+
+    std::string default_bulk_import_product_id(size_t index,
+                                               OpticsParser::ProductData const & parsed)
+    {
+        if(parsed.productName.empty())
+        {
+            return std::to_string(index);
+        }
+        return parsed.productName;
+    }
+
+    Bulk_Import_Summary import_igsdb_json_to_library(std::string const & path,
+                                                     Product_Library_Writer & writer,
+                                                     Bulk_Import_Error_Callback const & on_error,
+                                                     Bulk_Import_Options const & options,
+                                                     Bulk_Import_Product_Id const & product_id)
+    {
+        return import_igsdb_json_file(
+          path,
+          [&writer, &product_id](size_t index,
+                                 OpticsParser::ProductData const & parsed,
+                                 Product_Data_Optical_Thermal const & product) {
+              writer.add(product_id(index, parsed), product);
+          },
+          on_error,
+          options);
+    }
+}   // namespace wincalc
@@ -0,0 +1,108 @@
+#ifndef WINCALC_BULK_IMPORT_H_
+#define WINCALC_BULK_IMPORT_H_
+
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <OpticsParser.hpp>
+#include "product_data.h"
+#include "product_library.h"
+
+namespace wincalc
+{
+    // Reads the elements of a top level JSON array one at a time without loading the whole
+    // document.  Only the text of the current element is held in memory.  Elements are
+    // returned as raw JSON text and are not otherwise validated.
+    class Json_Array_Reader
+    {
+    public:
+        explicit Json_Array_Reader(std::istream & input, size_t buffer_size = 1 << 16);
+
+        // Sets element to the next element of the array and returns true, or returns false
+        // once the end of the array has been reached.
+        bool next(std::string & element);
+
+        // Number of elements returned so far
+        size_t count() const;
+
+    private:
+        bool get(char & c);
+        bool skip_whitespace(char & c);
+
+        std::istream & input;
+        std::vector<char> buffer;
+        size_t position = 0;
+        size_t available = 0;
+        size_t elements = 0;
+        bool started = false;
+        bool finished = false;
+    };
+
+    struct Bulk_Import_Options
+    {
+        // 0 uses one worker per core
+        size_t number_of_threads = 0;
+        // Maximum number of elements read but not yet converted.  0 uses two per worker.
+        // Together with the number of threads this bounds memory use independent of the size
+        // of the input.
+        size_t queue_size = 0;
+    };
+
+    struct Bulk_Import_Summary
+    {
+        size_t products = 0;
+        size_t converted = 0;
+        size_t failed = 0;
+    };
+
+    // Called once per array element in the order the elements appear in the input.  Calls are
+    // never made concurrently so the callbacks do not need to be thread safe.
+    using Bulk_Import_Callback =
+      std::function<void(size_t index,
+                         OpticsParser::ProductData const & parsed,
+                         Product_Data_Optical_Thermal const & product)>;
+    using Bulk_Import_Error_Callback =
+      std::function<void(size_t index, std::string const & message)>;
+
+    // Converts every product in a JSON array of IGSDB products, e.g. an IGSDB export, the same
+    // way convert_to_solid_layer does.  Elements are parsed and converted on a pool of worker
+    // threads while the input is still being read.
+    //
+    // If on_error is set, elements that cannot be parsed or converted and exceptions thrown
+    // by on_product are reported to it and the import continues.  Otherwise the import stops
+    // at the first error and rethrows it.  Errors in the array structure itself always stop the
+    // import.
+    Bulk_Import_Summary import_igsdb_json(std::istream & input,
+                                          Bulk_Import_Callback const & on_product,
+                                          Bulk_Import_Error_Callback const & on_error = nullptr,
+                                          Bulk_Import_Options const & options = {});
+
+    Bulk_Import_Summary
+      import_igsdb_json_file(std::string const & path,
+                             Bulk_Import_Callback const & on_product,
+                             Bulk_Import_Error_Callback const & on_error = nullptr,
+                             Bulk_Import_Options const & options = {});
+
+    // Returns the ID a product is stored under in a product library
+    using Bulk_Import_Product_Id =
+      std::function<std::string(size_t index, OpticsParser::ProductData const & parsed)>;
+
+    // The product name, or the element index if the product has no name
+    std::string default_bulk_import_product_id(size_t index,
+                                               OpticsParser::ProductData const & parsed);
+
+    // Imports straight into a product library.  Duplicate IDs are errors, see
+    // import_igsdb_json.  The writer is not finished so more products can be added to it.
+    Bulk_Import_Summary
+      import_igsdb_json_to_library(std::string const & path,
+                                   Product_Library_Writer & writer,
+                                   Bulk_Import_Error_Callback const & on_error = nullptr,
+                                   Bulk_Import_Options const & options = {},
+                                   Bulk_Import_Product_Id const & product_id =
+                                     default_bulk_import_product_id);
+}   // namespace wincalc
+
+#endif
@@ -4,8 +4,10 @@
 #include <map>
 #include <sstream>
 #include <iostream>
+#include <filesystem>
 
 #include "util.h"
+#include "instrumentation.h"
 
 namespace wincalc
 {
@@ -49,29 +51,26 @@ namespace wincalc
             auto glazing_option = get_cma_option(result.glazingCase);
             for(auto const & u_result : result.ufactorResults)
             {
-                if(to_lower(u_result.tag) == "frame")
+                auto tag = to_lower(u_result.tag);
+                if(tag != "frame" && tag != "edge")
                 {
-                    for(auto const & projection_result : u_result.projectionResults)
-                    {
-                        if(to_lower(projection_result.lengthType) == "projected in glass plane")
-                        {
-                            u_value = std::stod(projection_result.ufactor);
-                            projected_frame_dimension = projection_result.length;
-                        }
-                        else if(to_lower(projection_result.lengthType) == "total length")
-                        {
-                            wetted_length = projection_result.length;
-                        }
-                    }
+                    continue;
                 }
-                else if(to_lower(u_result.tag) == "edge")
+                for(auto const & projection_result : u_result.projectionResults)
                 {
-                    for(auto const & projection_result : u_result.projectionResults)
+                    auto length_type = to_lower(projection_result.lengthType);
+                    if(tag == "frame" && length_type == "projected in glass plane")
                     {
-                        if(to_lower(projection_result.lengthType) == "projected in glass plane")
-                        {
-                            u_edge = std::stod(projection_result.ufactor);
-                        }
+                        u_value = std::stod(projection_result.ufactor);
+                        projected_frame_dimension = projection_result.length;
+                    }
+                    else if(tag == "frame" && length_type == "total length")
+                    {
+                        wetted_length = projection_result.length;
+                    }
+                    else if(tag == "edge" && length_type == "projected in glass plane")
+                    {
+                        u_edge = std::stod(projection_result.ufactor);
                     }
                 }
             }
@@ -182,6 +181,189 @@ namespace wincalc
         return spacer_width_m / (1 / u_factor.value() - 1 / ho - 1 / hi);
     }
 
+    CMA_Frame_Data get_cma_frame_data(thmxParser::ThmxFileContents const & frame)
+    {
+        std::optional<CMA_Window_Options> options;
+        if(frame.cmaOptions.has_value())
+        {
+            auto const & best_worst_options = frame.cmaOptions.value().bestWorstOptions;
+            auto best_worst_u_factors = get_best_worst_u_factors(frame);
+            options = CMA_Window_Options{best_worst_options.at("Low").spacerConductance,
+                                         best_worst_options.at("High").spacerConductance,
+                                         best_worst_u_factors.best,
+                                         best_worst_u_factors.worst};
+        }
+        return CMA_Frame_Data{get_cma_frame(cma_frame_parameters(frame)), options};
+    }
+
+    namespace
+    {
+        CMA_Window_Options const & window_options(CMA_Frame_Data const & frame)
+        {
+            if(!frame.options.has_value())
+            {
+                throw std::runtime_error("CMA frame has no CMA options");
+            }
+            return frame.options.value();
+        }
+
+        std::string library_key(std::string const & path)
+        {
+            return std::filesystem::absolute(path).lexically_normal().string();
+        }
+    }   // namespace
+
+    std::shared_ptr<CMA_Frame_Data const> CMA_Frame_Library::frame(std::string const & path)
+    {
+        auto key = library_key(path);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto cached = frames.find(key);
+            if(cached != frames.end())
+            {
+                WINCALC_COUNT(CMA_FRAME_LIBRARY_HIT, 1);
+                return cached->second;
+            }
+        }
+        WINCALC_COUNT(CMA_FRAME_LIBRARY_MISS, 1);
+        // Parsed without holding the lock so other files can be loaded at the same time.  If
+        // two threads load the same file the first one added is kept.
+        auto data = std::make_shared<CMA_Frame_Data const>(
+          get_cma_frame_data(thmxParser::parseFile(key)));
+        std::lock_guard<std::mutex> lock(mutex);
+        return frames.emplace(key, data).first->second;
+    }
+
+    double CMA_Frame_Library::spacer_keff(std::string const & path)
+    {
+        auto key = library_key(path);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto cached = spacers.find(key);
+            if(cached != spacers.end())
+            {
+                WINCALC_COUNT(CMA_FRAME_LIBRARY_HIT, 1);
+                return cached->second;
+            }
+        }
+        WINCALC_COUNT(CMA_FRAME_LIBRARY_MISS, 1);
+        auto keff = get_spacer_keff(thmxParser::parseFile(key));
+        std::lock_guard<std::mutex> lock(mutex);
+        return spacers.emplace(key, keff).first->second;
+    }
+
+    std::shared_ptr<CMA_Frame_Data const>
+      CMA_Frame_Library::add_frame(std::string const & key,
+                                   thmxParser::ThmxFileContents const & frame)
+    {
+        auto data = std::make_shared<CMA_Frame_Data const>(get_cma_frame_data(frame));
+        std::lock_guard<std::mutex> lock(mutex);
+        frames[key] = data;
+        return data;
+    }
+
+    void CMA_Frame_Library::add_spacer(std::string const & key,
+                                       thmxParser::ThmxFileContents const & spacer)
+    {
+        auto keff = get_spacer_keff(spacer);
+        std::lock_guard<std::mutex> lock(mutex);
+        spacers[key] = keff;
+    }
+
+    size_t CMA_Frame_Library::size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return frames.size() + spacers.size();
+    }
+
+    void CMA_Frame_Library::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        frames.clear();
+        spacers.clear();
+    }
+
+    std::shared_ptr<CMA::CMAWindowSingleVision>
+      get_cma_window_single_vision(CMA_Frame_Data const & top_frame,
+                                   CMA_Frame_Data const & bottom_frame,
+                                   CMA_Frame_Data const & left_frame,
+                                   CMA_Frame_Data const & right_frame,
+                                   double window_width,
+                                   double window_height)
+    {
+        auto const & options = window_options(top_frame);
+        std::shared_ptr<CMA::CMAWindowSingleVision> cma_window(
+          new CMA::CMAWindowSingleVision(window_width,
+                                         window_height,
+                                         options.best_spacer_keff,
+                                         options.worst_spacer_keff,
+                                         options.best_u_factors,
+                                         options.worst_u_factors));
+        cma_window->setFrameTop(top_frame.frame);
+        cma_window->setFrameBottom(bottom_frame.frame);
+        cma_window->setFrameLeft(left_frame.frame);
+        cma_window->setFrameRight(right_frame.frame);
+        return cma_window;
+    }
+
+    std::shared_ptr<CMA::CMAWindowDualVisionVertical>
+      get_cma_window_double_vision_vertical(CMA_Frame_Data const & top_frame,
+                                            CMA_Frame_Data const & bottom_frame,
+                                            CMA_Frame_Data const & top_left_frame,
+                                            CMA_Frame_Data const & top_right_frame,
+                                            CMA_Frame_Data const & bottom_left_frame,
+                                            CMA_Frame_Data const & bottom_right_frame,
+                                            CMA_Frame_Data const & meeting_rail,
+                                            double window_width,
+                                            double window_height)
+    {
+        auto const & options = window_options(top_frame);
+        std::shared_ptr<CMA::CMAWindowDualVisionVertical> cma_window(
+          new CMA::CMAWindowDualVisionVertical(window_width,
+                                               window_height,
+                                               options.best_spacer_keff,
+                                               options.worst_spacer_keff,
+                                               options.best_u_factors,
+                                               options.worst_u_factors));
+        cma_window->setFrameTop(top_frame.frame);
+        cma_window->setFrameBottom(bottom_frame.frame);
+        cma_window->setFrameTopLeft(top_left_frame.frame);
+        cma_window->setFrameTopRight(top_right_frame.frame);
+        cma_window->setFrameBottomLeft(bottom_left_frame.frame);
+        cma_window->setFrameBottomRight(bottom_right_frame.frame);
+        cma_window->setFrameMeetingRail(meeting_rail.frame);
+        return cma_window;
+    }
+
+    std::shared_ptr<CMA::CMAWindowDualVisionHorizontal>
+      get_cma_window_double_vision_horizontal(CMA_Frame_Data const & top_left_frame,
+                                              CMA_Frame_Data const & top_right_frame,
+                                              CMA_Frame_Data const & bottom_left_frame,
+                                              CMA_Frame_Data const & bottom_right_frame,
+                                              CMA_Frame_Data const & left_frame,
+                                              CMA_Frame_Data const & right_frame,
+                                              CMA_Frame_Data const & meeting_rail,
+                                              double window_width,
+                                              double window_height)
+    {
+        auto const & options = window_options(top_left_frame);
+        std::shared_ptr<CMA::CMAWindowDualVisionHorizontal> cma_window(
+          new CMA::CMAWindowDualVisionHorizontal(window_width,
+                                                 window_height,
+                                                 options.best_spacer_keff,
+                                                 options.worst_spacer_keff,
+                                                 options.best_u_factors,
+                                                 options.worst_u_factors));
+        cma_window->setFrameTopLeft(top_left_frame.frame);
+        cma_window->setFrameTopRight(top_right_frame.frame);
+        cma_window->setFrameBottomLeft(bottom_left_frame.frame);
+        cma_window->setFrameBottomRight(bottom_right_frame.frame);
+        cma_window->setFrameLeft(left_frame.frame);
+        cma_window->setFrameRight(right_frame.frame);
+        cma_window->setFrameMeetingRail(meeting_rail.frame);
+        return cma_window;
+    }
+
     std::shared_ptr<CMA::CMAWindowSingleVision>
       get_cma_window_single_vision(thmxParser::ThmxFileContents const & top_frame,
                                    thmxParser::ThmxFileContents const & bottom_frame,
@@ -190,29 +372,12 @@ namespace wincalc
                                    double window_width,
                                    double window_height)
     {
-		auto top_cma_frame = get_cma_frame(cma_frame_parameters(top_frame));
-        auto bottom_cma_frame = get_cma_frame(cma_frame_parameters(bottom_frame));
-        auto left_cma_frame = get_cma_frame(cma_frame_parameters(left_frame));
-        auto right_cma_frame = get_cma_frame(cma_frame_parameters(right_frame));
-
-		auto best_worst_u_factors = get_best_worst_u_factors(top_frame);
-		auto best_spacer_keff =
-          top_frame.cmaOptions.value().bestWorstOptions.at("Low").spacerConductance;
-        auto worst_spacer_keff =
-          top_frame.cmaOptions.value().bestWorstOptions.at("High").spacerConductance;
-		
-        std::shared_ptr<CMA::CMAWindowSingleVision> cma_window(
-          new CMA::CMAWindowSingleVision(window_width,
-                                         window_height,
-                                         best_spacer_keff,
-                                         worst_spacer_keff,
-                                         best_worst_u_factors.best,
-                                         best_worst_u_factors.worst));
-		cma_window->setFrameTop(top_cma_frame);
-        cma_window->setFrameBottom(bottom_cma_frame);
-        cma_window->setFrameLeft(left_cma_frame);
-        cma_window->setFrameRight(right_cma_frame);
-		return cma_window;
+        return get_cma_window_single_vision(get_cma_frame_data(top_frame),
+                                            get_cma_frame_data(bottom_frame),
+                                            get_cma_frame_data(left_frame),
+                                            get_cma_frame_data(right_frame),
+                                            window_width,
+                                            window_height);
     }
 
     std::shared_ptr<CMA::CMAWindowDualVisionVertical>
@@ -226,35 +391,15 @@ namespace wincalc
                                             double window_width,
                                             double window_height)
     {
-        auto top_cma_frame = get_cma_frame(cma_frame_parameters(top_frame));
-        auto bottom_cma_frame = get_cma_frame(cma_frame_parameters(bottom_frame));
-        auto top_left_cma_frame = get_cma_frame(cma_frame_parameters(top_left_frame));
-        auto top_right_cma_frame = get_cma_frame(cma_frame_parameters(top_right_frame));
-        auto bottom_left_cma_frame = get_cma_frame(cma_frame_parameters(bottom_left_frame));
-        auto bottom_right_cma_frame = get_cma_frame(cma_frame_parameters(bottom_right_frame));
-        auto meeting_rail_cma_frame = get_cma_frame(cma_frame_parameters(meeting_rail));
-
-        auto best_worst_u_factors = get_best_worst_u_factors(top_frame);
-        auto best_spacer_keff =
-          top_frame.cmaOptions.value().bestWorstOptions.at("Low").spacerConductance;
-        auto worst_spacer_keff =
-          top_frame.cmaOptions.value().bestWorstOptions.at("High").spacerConductance;
-
-        std::shared_ptr<CMA::CMAWindowDualVisionVertical> cma_window(
-          new CMA::CMAWindowDualVisionVertical(window_width,
-                                               window_height,
-                                               best_spacer_keff,
-                                               worst_spacer_keff,
-                                               best_worst_u_factors.best,
-                                               best_worst_u_factors.worst));
-        cma_window->setFrameTop(top_cma_frame);
-        cma_window->setFrameBottom(bottom_cma_frame);
-        cma_window->setFrameTopLeft(top_left_cma_frame);
-        cma_window->setFrameTopRight(top_right_cma_frame);
-        cma_window->setFrameBottomLeft(bottom_left_cma_frame);
-        cma_window->setFrameBottomRight(bottom_right_cma_frame);
-        cma_window->setFrameMeetingRail(meeting_rail_cma_frame);
-        return cma_window;
+        return get_cma_window_double_vision_vertical(get_cma_frame_data(top_frame),
+                                                     get_cma_frame_data(bottom_frame),
+                                                     get_cma_frame_data(top_left_frame),
+                                                     get_cma_frame_data(top_right_frame),
+                                                     get_cma_frame_data(bottom_left_frame),
+                                                     get_cma_frame_data(bottom_right_frame),
+                                                     get_cma_frame_data(meeting_rail),
+                                                     window_width,
+                                                     window_height);
     }
 
     std::shared_ptr<CMA::CMAWindowDualVisionHorizontal> get_cma_window_double_vision_horizontal(
@@ -268,35 +413,15 @@ namespace wincalc
       double window_width,
       double window_height)
     {
-        auto top_left_cma_frame = get_cma_frame(cma_frame_parameters(top_left_frame));
-        auto top_right_cma_frame = get_cma_frame(cma_frame_parameters(top_right_frame));
-        auto bottom_left_cma_frame = get_cma_frame(cma_frame_parameters(bottom_left_frame));
-        auto bottom_right_cma_frame = get_cma_frame(cma_frame_parameters(bottom_right_frame));
-        auto meeting_rail_cma_frame = get_cma_frame(cma_frame_parameters(meeting_rail));
-        auto left_cma_frame = get_cma_frame(cma_frame_parameters(left_frame));
-        auto right_cma_frame = get_cma_frame(cma_frame_parameters(right_frame));
-
-        auto best_worst_u_factors = get_best_worst_u_factors(top_left_frame);
-        auto best_spacer_keff =
-          top_left_frame.cmaOptions.value().bestWorstOptions.at("Low").spacerConductance;
-        auto worst_spacer_keff =
-          top_left_frame.cmaOptions.value().bestWorstOptions.at("High").spacerConductance;
-
-        std::shared_ptr<CMA::CMAWindowDualVisionHorizontal> cma_window(
-          new CMA::CMAWindowDualVisionHorizontal(window_width,
-                                                 window_height,
-                                                 best_spacer_keff,
-                                                 worst_spacer_keff,
-                                                 best_worst_u_factors.best,
-                                                 best_worst_u_factors.worst));
-        cma_window->setFrameTopLeft(top_left_cma_frame);
-        cma_window->setFrameTopRight(top_right_cma_frame);
-        cma_window->setFrameBottomLeft(bottom_left_cma_frame);
-        cma_window->setFrameBottomRight(bottom_right_cma_frame);
-        cma_window->setFrameLeft(left_cma_frame);
-        cma_window->setFrameRight(right_cma_frame);
-        cma_window->setFrameMeetingRail(meeting_rail_cma_frame);
-        return cma_window;
+        return get_cma_window_double_vision_horizontal(get_cma_frame_data(top_left_frame),
+                                                       get_cma_frame_data(top_right_frame),
+                                                       get_cma_frame_data(bottom_left_frame),
+                                                       get_cma_frame_data(bottom_right_frame),
+                                                       get_cma_frame_data(left_frame),
+                                                       get_cma_frame_data(right_frame),
+                                                       get_cma_frame_data(meeting_rail),
+                                                       window_width,
+                                                       window_height);
     }
 
     CMAResult calc_cma(std::shared_ptr<CMA::ICMAWindow> window,
@@ -311,4 +436,180 @@ namespace wincalc
 		return CMAResult{u, shgc, tvis};
     }
 
+    namespace
+    {
+        CMA_Frame_Set frame_set(CMA_Window_Type type,
+                                std::vector<std::shared_ptr<CMA_Frame_Data const>> frames)
+        {
+            for(auto const & frame : frames)
+            {
+                if(!frame)
+                {
+                    throw std::runtime_error("CMA frame set is missing a frame");
+                }
+            }
+            return CMA_Frame_Set{type, std::move(frames)};
+        }
+    }   // namespace
+
+    CMA_Frame_Set cma_single_vision_frames(std::shared_ptr<CMA_Frame_Data const> top_frame,
+                                           std::shared_ptr<CMA_Frame_Data const> bottom_frame,
+                                           std::shared_ptr<CMA_Frame_Data const> left_frame,
+                                           std::shared_ptr<CMA_Frame_Data const> right_frame)
+    {
+        return frame_set(CMA_Window_Type::SINGLE_VISION,
+                         {std::move(top_frame),
+                          std::move(bottom_frame),
+                          std::move(left_frame),
+                          std::move(right_frame)});
+    }
+
+    CMA_Frame_Set
+      cma_double_vision_vertical_frames(std::shared_ptr<CMA_Frame_Data const> top_frame,
+                                        std::shared_ptr<CMA_Frame_Data const> bottom_frame,
+                                        std::shared_ptr<CMA_Frame_Data const> top_left_frame,
+                                        std::shared_ptr<CMA_Frame_Data const> top_right_frame,
+                                        std::shared_ptr<CMA_Frame_Data const> bottom_left_frame,
+                                        std::shared_ptr<CMA_Frame_Data const> bottom_right_frame,
+                                        std::shared_ptr<CMA_Frame_Data const> meeting_rail)
+    {
+        return frame_set(CMA_Window_Type::DOUBLE_VISION_VERTICAL,
+                         {std::move(top_frame),
+                          std::move(bottom_frame),
+                          std::move(top_left_frame),
+                          std::move(top_right_frame),
+                          std::move(bottom_left_frame),
+                          std::move(bottom_right_frame),
+                          std::move(meeting_rail)});
+    }
+
+    CMA_Frame_Set
+      cma_double_vision_horizontal_frames(std::shared_ptr<CMA_Frame_Data const> top_left_frame,
+                                          std::shared_ptr<CMA_Frame_Data const> top_right_frame,
+                                          std::shared_ptr<CMA_Frame_Data const> bottom_left_frame,
+                                          std::shared_ptr<CMA_Frame_Data const> bottom_right_frame,
+                                          std::shared_ptr<CMA_Frame_Data const> left_frame,
+                                          std::shared_ptr<CMA_Frame_Data const> right_frame,
+                                          std::shared_ptr<CMA_Frame_Data const> meeting_rail)
+    {
+        return frame_set(CMA_Window_Type::DOUBLE_VISION_HORIZONTAL,
+                         {std::move(top_left_frame),
+                          std::move(top_right_frame),
+                          std::move(bottom_left_frame),
+                          std::move(bottom_right_frame),
+                          std::move(left_frame),
+                          std::move(right_frame),
+                          std::move(meeting_rail)});
+    }
+
+    std::shared_ptr<CMA::ICMAWindow> CMA_Frame_Set::window(double window_width,
+                                                           double window_height) const
+    {
+        size_t expected_frames = type == CMA_Window_Type::SINGLE_VISION ? 4 : 7;
+        if(frames.size() != expected_frames)
+        {
+            std::stringstream msg;
+            msg << "CMA frame set has " << frames.size() << " frames, expected "
+                << expected_frames;
+            throw std::runtime_error(msg.str());
+        }
+
+        switch(type)
+        {
+            case CMA_Window_Type::SINGLE_VISION:
+                return get_cma_window_single_vision(
+                  *frames[0], *frames[1], *frames[2], *frames[3], window_width, window_height);
+            case CMA_Window_Type::DOUBLE_VISION_VERTICAL:
+                return get_cma_window_double_vision_vertical(*frames[0],
+                                                             *frames[1],
+                                                             *frames[2],
+                                                             *frames[3],
+                                                             *frames[4],
+                                                             *frames[5],
+                                                             *frames[6],
+                                                             window_width,
+                                                             window_height);
+            case CMA_Window_Type::DOUBLE_VISION_HORIZONTAL:
+                return get_cma_window_double_vision_horizontal(*frames[0],
+                                                               *frames[1],
+                                                               *frames[2],
+                                                               *frames[3],
+                                                               *frames[4],
+                                                               *frames[5],
+                                                               *frames[6],
+                                                               window_width,
+                                                               window_height);
+        }
+        throw std::runtime_error("Unknown CMA window type");
+    }
+
+    CMAResult const & CMA_Table::at(size_t size, size_t spacer, size_t glazing) const
+    {
+        if(size >= sizes || spacer >= spacers || glazing >= glazings)
+        {
+            std::stringstream msg;
+            msg << "CMA table index (" << size << ", " << spacer << ", " << glazing
+                << ") out of range (" << sizes << ", " << spacers << ", " << glazings << ")";
+            throw std::out_of_range(msg.str());
+        }
+        return results[(size * spacers + spacer) * glazings + glazing];
+    }
+
+    CMA_Table calc_cma_table(CMA_Frame_Set const & frames,
+                             std::vector<CMA_Glazing> const & glazings,
+                             std::vector<double> const & spacer_keffs,
+                             std::vector<CMA_Window_Size> const & sizes,
+                             size_t number_of_threads)
+    {
+        CMA_Table table;
+        table.sizes = sizes.size();
+        table.spacers = spacer_keffs.size();
+        table.glazings = glazings.size();
+        table.results.resize(table.sizes * table.spacers * table.glazings);
+        if(table.results.empty())
+        {
+            return table;
+        }
+
+        // Glazing values as separate contiguous arrays for the inner loops
+        std::vector<double> u(glazings.size());
+        std::vector<double> shgc(glazings.size());
+        std::vector<double> tvis(glazings.size());
+        for(size_t i = 0; i < glazings.size(); ++i)
+        {
+            u[i] = glazings[i].u;
+            shgc[i] = glazings[i].shgc;
+            tvis[i] = glazings[i].visible_front_direct_hemispheric_transmittance;
+        }
+
+        // Each thread builds its own windows so no window is shared between threads
+        parallel_for(
+          sizes.size(),
+          thread_count(number_of_threads, sizes.size()),
+          [&](size_t begin, size_t end) {
+              std::vector<double> vt(glazings.size());
+              for(size_t size = begin; size < end; ++size)
+              {
+                  auto window = frames.window(sizes[size].width, sizes[size].height);
+                  for(size_t glazing = 0; glazing < glazings.size(); ++glazing)
+                  {
+                      vt[glazing] = window->vt(tvis[glazing]);
+                  }
+                  for(size_t spacer = 0; spacer < spacer_keffs.size(); ++spacer)
+                  {
+                      auto keff = spacer_keffs[spacer];
+                      auto * row = &table.results[(size * table.spacers + spacer) * table.glazings];
+                      for(size_t glazing = 0; glazing < glazings.size(); ++glazing)
+                      {
+                          row[glazing] = CMAResult{window->uValue(u[glazing], keff),
+                                                   window->shgc(shgc[glazing], keff),
+                                                   vt[glazing]};
+                      }
+                  }
+              }
+          });
+
+        return table;
+    }
+
 }   // namespace wincalc
@@ -3,7 +3,12 @@
 
 #include <thmxParser/thmxParser.hpp>
 #include <WCETarcog.hpp>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace wincalc
 {
@@ -16,6 +21,50 @@ namespace wincalc
 
 	double get_spacer_keff(thmxParser::ThmxFileContents const & spacer);
 
+    // Window wide CMA options.  The windows take these from the first frame passed in.
+    struct CMA_Window_Options
+    {
+        double best_spacer_keff;
+        double worst_spacer_keff;
+        CMA::CMABestWorstUFactors best_u_factors;
+        CMA::CMABestWorstUFactors worst_u_factors;
+    };
+
+    // Everything a CMA window needs from one frame THMX file, with all strings already
+    // matched and all numbers already converted
+    struct CMA_Frame_Data
+    {
+        CMA::CMAFrame frame;
+        // Not set if the file has no CMA options
+        std::optional<CMA_Window_Options> options;
+    };
+
+    CMA_Frame_Data get_cma_frame_data(thmxParser::ThmxFileContents const & frame);
+
+    // Frame and spacer THMX files parsed once and kept for every window built from them.
+    // Entries are keyed by the absolute path of the file and are parsed on first use.
+    // Safe to use from multiple threads.
+    class CMA_Frame_Library
+    {
+    public:
+        std::shared_ptr<CMA_Frame_Data const> frame(std::string const & path);
+        double spacer_keff(std::string const & path);
+
+        // Adds a file that has already been parsed, e.g. one not read from disk
+        std::shared_ptr<CMA_Frame_Data const> add_frame(std::string const & key,
+                                                        thmxParser::ThmxFileContents const & frame);
+        void add_spacer(std::string const & key, thmxParser::ThmxFileContents const & spacer);
+
+        // Number of frame and spacer files held
+        size_t size() const;
+        void clear();
+
+    private:
+        mutable std::mutex mutex;
+        std::map<std::string, std::shared_ptr<CMA_Frame_Data const>> frames;
+        std::map<std::string, double> spacers;
+    };
+
     std::shared_ptr<CMA::CMAWindowSingleVision>
       get_cma_window_single_vision(thmxParser::ThmxFileContents const & top_frame,
                                    thmxParser::ThmxFileContents const & bottom_frame,
@@ -46,11 +95,121 @@ namespace wincalc
       double window_width,
       double window_height);
 
+    // The same windows built from frame data that has already been parsed.  Window wide
+    // options come from top_frame, or top_left_frame for the horizontal window.
+    std::shared_ptr<CMA::CMAWindowSingleVision>
+      get_cma_window_single_vision(CMA_Frame_Data const & top_frame,
+                                   CMA_Frame_Data const & bottom_frame,
+                                   CMA_Frame_Data const & left_frame,
+                                   CMA_Frame_Data const & right_frame,
+                                   double window_width,
+                                   double window_height);
+
+    std::shared_ptr<CMA::CMAWindowDualVisionVertical>
+      get_cma_window_double_vision_vertical(CMA_Frame_Data const & top_frame,
+                                            CMA_Frame_Data const & bottom_frame,
+                                            CMA_Frame_Data const & top_left_frame,
+                                            CMA_Frame_Data const & top_right_frame,
+                                            CMA_Frame_Data const & bottom_left_frame,
+                                            CMA_Frame_Data const & bottom_right_frame,
+                                            CMA_Frame_Data const & meeting_rail,
+                                            double window_width,
+                                            double window_height);
+
+    std::shared_ptr<CMA::CMAWindowDualVisionHorizontal>
+      get_cma_window_double_vision_horizontal(CMA_Frame_Data const & top_left_frame,
+                                              CMA_Frame_Data const & top_right_frame,
+                                              CMA_Frame_Data const & bottom_left_frame,
+                                              CMA_Frame_Data const & bottom_right_frame,
+                                              CMA_Frame_Data const & left_frame,
+                                              CMA_Frame_Data const & right_frame,
+                                              CMA_Frame_Data const & meeting_rail,
+                                              double window_width,
+                                              double window_height);
+
     CMAResult calc_cma(std::shared_ptr<CMA::ICMAWindow> window,
                        double glazing_system_u,
                        double glazing_system_shgc,
                        double glazing_system_visible_front_direct_hemispheric_transmittance,
                        double spacer_keff);
 
+    enum class CMA_Window_Type
+    {
+        SINGLE_VISION,
+        DOUBLE_VISION_VERTICAL,
+        DOUBLE_VISION_HORIZONTAL
+    };
+
+    // The frames of one CMA window in the same order as the arguments of the matching
+    // get_cma_window_* function.  Frames are shared so a frame set made from a
+    // CMA_Frame_Library does not copy any frame data.
+    struct CMA_Frame_Set
+    {
+        CMA_Window_Type type;
+        std::vector<std::shared_ptr<CMA_Frame_Data const>> frames;
+
+        std::shared_ptr<CMA::ICMAWindow> window(double window_width, double window_height) const;
+    };
+
+    CMA_Frame_Set cma_single_vision_frames(std::shared_ptr<CMA_Frame_Data const> top_frame,
+                                           std::shared_ptr<CMA_Frame_Data const> bottom_frame,
+                                           std::shared_ptr<CMA_Frame_Data const> left_frame,
+                                           std::shared_ptr<CMA_Frame_Data const> right_frame);
+
+    CMA_Frame_Set
+      cma_double_vision_vertical_frames(std::shared_ptr<CMA_Frame_Data const> top_frame,
+                                        std::shared_ptr<CMA_Frame_Data const> bottom_frame,
+                                        std::shared_ptr<CMA_Frame_Data const> top_left_frame,
+                                        std::shared_ptr<CMA_Frame_Data const> top_right_frame,
+                                        std::shared_ptr<CMA_Frame_Data const> bottom_left_frame,
+                                        std::shared_ptr<CMA_Frame_Data const> bottom_right_frame,
+                                        std::shared_ptr<CMA_Frame_Data const> meeting_rail);
+
+    CMA_Frame_Set
+      cma_double_vision_horizontal_frames(std::shared_ptr<CMA_Frame_Data const> top_left_frame,
+                                          std::shared_ptr<CMA_Frame_Data const> top_right_frame,
+                                          std::shared_ptr<CMA_Frame_Data const> bottom_left_frame,
+                                          std::shared_ptr<CMA_Frame_Data const> bottom_right_frame,
+                                          std::shared_ptr<CMA_Frame_Data const> left_frame,
+                                          std::shared_ptr<CMA_Frame_Data const> right_frame,
+                                          std::shared_ptr<CMA_Frame_Data const> meeting_rail);
+
+    // Center of glazing values for one glazing system, the same values calc_cma takes
+    struct CMA_Glazing
+    {
+        double u;
+        double shgc;
+        double visible_front_direct_hemispheric_transmittance;
+    };
+
+    struct CMA_Window_Size
+    {
+        double width;
+        double height;
+    };
+
+    // Results for every combination of window size, spacer keff and glazing.  Results are
+    // stored by size, then spacer, then glazing so the results for one size and spacer are
+    // contiguous.
+    struct CMA_Table
+    {
+        size_t sizes = 0;
+        size_t spacers = 0;
+        size_t glazings = 0;
+        std::vector<CMAResult> results;
+
+        CMAResult const & at(size_t size, size_t spacer, size_t glazing) const;
+    };
+
+    // Evaluates the whole table.  The window, with its frame areas, is built once per size and
+    // reused for every spacer and glazing, and the visible transmittance, which does not
+    // depend on the spacer, is calculated once per size and glazing.  Sizes are split across
+    // number_of_threads threads, zero means one per hardware thread.
+    CMA_Table calc_cma_table(CMA_Frame_Set const & frames,
+                             std::vector<CMA_Glazing> const & glazings,
+                             std::vector<double> const & spacer_keffs,
+                             std::vector<CMA_Window_Size> const & sizes,
+                             size_t number_of_threads = 1);
+
 }   // namespace wincalc
 #endif
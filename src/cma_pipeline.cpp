@@ -0,0 +1,44 @@
+#include <sstream>
+
+#include "cma_pipeline.h"
+#include "util.h"
+
+namespace wincalc
+{
+    CMA_Pipeline_Results
+      calc_cma_pipeline(std::vector<std::shared_ptr<Glazing_System>> const & glazing_systems,
+                        CMA_Frame_Set const & frames,
+                        std::vector<double> const & spacer_keffs,
+                        std::vector<CMA_Window_Size> const & sizes,
+                        size_t number_of_threads,
+                        Environments const & u_environment,
+                        Environments const & shgc_environment,
+                        std::string const & visible_method)
+    {
+        for(size_t i = 0; i < glazing_systems.size(); ++i)
+        {
+            if(!glazing_systems[i])
+            {
+                std::stringstream msg;
+                msg << "Glazing system " << i << " is null";
+                throw std::runtime_error(msg.str());
+            }
+        }
+
+        CMA_Pipeline_Results results;
+        results.glazings.resize(glazing_systems.size());
+        parallel_for(glazing_systems.size(),
+                     thread_count(number_of_threads, glazing_systems.size()),
+                     [&](size_t begin, size_t end) {
+                         for(size_t i = begin; i < end; ++i)
+                         {
+                             results.glazings[i] = glazing_systems[i]->cma_glazing(
+                               u_environment, shgc_environment, visible_method);
+                         }
+                     });
+
+        results.table =
+          calc_cma_table(frames, results.glazings, spacer_keffs, sizes, number_of_threads);
+        return results;
+    }
+}   // namespace wincalc
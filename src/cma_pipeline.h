@@ -0,0 +1,36 @@
+#ifndef WINCALC_CMA_PIPELINE_H_
+#define WINCALC_CMA_PIPELINE_H_
+
+#include <string>
+#include <vector>
+
+#include "cma.h"
+#include "glazing_system.h"
+
+namespace wincalc
+{
+    struct CMA_Pipeline_Results
+    {
+        // Center of glazing values, one per glazing system in the same order
+        std::vector<CMA_Glazing> glazings;
+        // Indexed by size, spacer and then glazing system
+        CMA_Table table;
+    };
+
+    // Calculates the CMA table for a set of glazing systems.  The glazing values come from
+    // Glazing_System::cma_glazing and the glazing systems are split across number_of_threads
+    // threads, zero means one per hardware thread.  Each system is only used by one thread so
+    // the same system must not appear twice or be used by other threads while this runs.  The
+    // table is then calculated with calc_cma_table using the same number of threads.
+    CMA_Pipeline_Results
+      calc_cma_pipeline(std::vector<std::shared_ptr<Glazing_System>> const & glazing_systems,
+                        CMA_Frame_Set const & frames,
+                        std::vector<double> const & spacer_keffs,
+                        std::vector<CMA_Window_Size> const & sizes,
+                        size_t number_of_threads = 1,
+                        Environments const & u_environment = nfrc_u_environments(),
+                        Environments const & shgc_environment = nfrc_shgc_environments(),
+                        std::string const & visible_method = "PHOTOPIC");
+}   // namespace wincalc
+
+#endif
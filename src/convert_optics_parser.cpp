@@ -1,5 +1,6 @@
 #include "convert_optics_parser.h"
 #include <sstream>
+#include <utility>
 #include "util.h"
 
 namespace wincalc
@@ -98,8 +99,20 @@ namespace wincalc
         return length_conversion;
     }
 
+    // Copies the matrix unless the caller owns the product and it can be moved from
+    std::vector<std::vector<double>> take_or_copy(std::vector<std::vector<double>> & data,
+                                                  bool move_measurements)
+    {
+        if(move_measurements)
+        {
+            return std::move(data);
+        }
+        return data;
+    }
+
     std::shared_ptr<Product_Data_Optical>
-      convert_optical(std::shared_ptr<OpticsParser::ProductData> const & product)
+      convert_optical(std::shared_ptr<OpticsParser::ProductData> const & product,
+                      bool move_measurements)
     {
         std::shared_ptr<OpticsParser::ComposedProductData> composed_product =
           std::dynamic_pointer_cast<OpticsParser::ComposedProductData>(product);
@@ -108,7 +121,10 @@ namespace wincalc
 
         if(composed_product)
         {
-            auto material = convert_optical(composed_product->compositionInformation->material);
+            auto const & composition = composed_product->compositionInformation;
+            auto material = convert_optical(composition->material,
+                                            move_measurements && composition.use_count() == 1
+                                              && composition->material.use_count() == 1);
 
             std::shared_ptr<OpticsParser::VenetianGeometry> venetian_geometry =
               std::dynamic_pointer_cast<OpticsParser::VenetianGeometry>(
@@ -189,7 +205,7 @@ namespace wincalc
             {
                 throw std::runtime_error("Missing product thickness");
             }
-            auto wavelength_measured_values = product->measurements.value();
+            auto & wavelength_measured_values = product->measurements.value();
             std::shared_ptr<Product_Data_Optical> converted;
             if(std::holds_alternative<std::vector<OpticsParser::WLData>>(
                  wavelength_measured_values))
@@ -221,10 +237,10 @@ namespace wincalc
             {
                 auto bsdfHemisphere =
                   SingleLayerOptics::CBSDFHemisphere::create(SingleLayerOptics::BSDFBasis::Full);
-                auto wavelengthValues =
+                auto & wavelengthValues =
                   std::get<OpticsParser::DualBandBSDF>(wavelength_measured_values);
-                auto solar = wavelengthValues.solar;
-                auto visible = wavelengthValues.visible;
+                auto & solar = wavelengthValues.solar;
+                auto & visible = wavelengthValues.visible;
                 validate_bsdf(solar.tf);
                 validate_bsdf(solar.tb);
                 validate_bsdf(solar.rf);
@@ -234,14 +250,14 @@ namespace wincalc
                 validate_bsdf(visible.rf);
                 validate_bsdf(visible.rb);
                 converted.reset(new Product_Data_Dual_Band_Optical_BSDF(
-                  solar.tf.data,
-                  solar.tb.data,
-                  solar.rf.data,
-                  solar.rb.data,
-                  visible.tf.data,
-                  visible.tb.data,
-                  visible.rf.data,
-                  visible.rb.data,
+                  take_or_copy(solar.tf.data, move_measurements),
+                  take_or_copy(solar.tb.data, move_measurements),
+                  take_or_copy(solar.rf.data, move_measurements),
+                  take_or_copy(solar.rb.data, move_measurements),
+                  take_or_copy(visible.tf.data, move_measurements),
+                  take_or_copy(visible.tb.data, move_measurements),
+                  take_or_copy(visible.rf.data, move_measurements),
+                  take_or_copy(visible.rb.data, move_measurements),
                   bsdfHemisphere,
                   product->thickness.value() * length_conversion,
                   product->IRTransmittance,
@@ -284,21 +300,55 @@ namespace wincalc
         return thermal_data;
     }
 
-    wincalc::Product_Data_Optical_Thermal
-      convert_to_solid_layer(std::shared_ptr<OpticsParser::ProductData> const & product)
+    std::shared_ptr<Product_Data_Optical>
+      convert_optical_data(std::shared_ptr<OpticsParser::ProductData> const & product,
+                           bool move_measurements)
     {
-        auto optical = convert_optical(product);
+        auto optical = convert_optical(product, move_measurements);
         // PV power properties are properties of the layer and so far do not require any conversion
         optical->pv_power_properties = product->pvPowerProperties;
-        auto thermal = std::make_shared<Product_Data_Thermal>(convert_thermal(product));
-        return wincalc::Product_Data_Optical_Thermal{optical, thermal};
+        return optical;
+    }
+
+    std::shared_ptr<Product_Data_Thermal>
+      convert_thermal_data(std::shared_ptr<OpticsParser::ProductData> const & product)
+    {
+        return std::make_shared<Product_Data_Thermal>(convert_thermal(product));
+    }
+
+    namespace
+    {
+        wincalc::Product_Data_Optical_Thermal
+          convert_to_solid_layer(std::shared_ptr<OpticsParser::ProductData> const & product,
+                                 bool move_measurements)
+        {
+            auto optical = convert_optical_data(product, move_measurements);
+            auto thermal = convert_thermal_data(product);
+            return wincalc::Product_Data_Optical_Thermal{std::move(optical), std::move(thermal)};
+        }
+    }   // namespace
+
+    wincalc::Product_Data_Optical_Thermal
+      convert_to_solid_layer(std::shared_ptr<OpticsParser::ProductData> const & product)
+    {
+        return convert_to_solid_layer(product, false);
+    }
+
+    wincalc::Product_Data_Optical_Thermal
+      convert_to_solid_layer(std::shared_ptr<OpticsParser::ProductData> && product)
+    {
+        // Only move the measurements out if nothing else can see the product.  Check before
+        // any casts since those take another reference.
+        bool move_measurements = product.use_count() == 1;
+        return convert_to_solid_layer(product, move_measurements);
     }
 
     std::vector<wincalc::Product_Data_Optical_Thermal> convert_to_solid_layers(
       std::vector<std::shared_ptr<OpticsParser::ProductData>> const & products)
     {
         std::vector<wincalc::Product_Data_Optical_Thermal> converted;
-        for(auto product : products)
+        converted.reserve(products.size());
+        for(auto const & product : products)
         {
             converted.push_back(convert_to_solid_layer(product));
         }
@@ -306,5 +356,17 @@ namespace wincalc
         return converted;
     }
 
+    std::vector<wincalc::Product_Data_Optical_Thermal> convert_to_solid_layers(
+      std::vector<std::shared_ptr<OpticsParser::ProductData>> && products)
+    {
+        std::vector<wincalc::Product_Data_Optical_Thermal> converted;
+        converted.reserve(products.size());
+        for(auto & product : products)
+        {
+            converted.push_back(convert_to_solid_layer(std::move(product)));
+        }
+        products.clear();
 
+        return converted;
+    }
 }   // namespace wincalc
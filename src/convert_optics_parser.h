@@ -10,4 +10,22 @@ namespace wincalc
       convert_to_solid_layer(std::shared_ptr<OpticsParser::ProductData> const & product);
     std::vector<wincalc::Product_Data_Optical_Thermal> convert_to_solid_layers(
       std::vector<std::shared_ptr<OpticsParser::ProductData>> const & products);
+
+    // Same as above but if the caller held the only reference to a product its measured data is
+    // moved into the converted layer instead of copied, e.g.
+    //     convert_to_solid_layer(OpticsParser::parseJSONFile(path))
+    // The products must not be used afterwards.
+    wincalc::Product_Data_Optical_Thermal
+      convert_to_solid_layer(std::shared_ptr<OpticsParser::ProductData> && product);
+    std::vector<wincalc::Product_Data_Optical_Thermal> convert_to_solid_layers(
+      std::vector<std::shared_ptr<OpticsParser::ProductData>> && products);
+
+    // The optical and thermal parts of convert_to_solid_layer, for converting them separately.
+    // If move_measurements is set the measured data is moved out of the product instead of
+    // copied.  The thermal part can still be converted from the product afterwards.
+    std::shared_ptr<Product_Data_Optical>
+      convert_optical_data(std::shared_ptr<OpticsParser::ProductData> const & product,
+                           bool move_measurements = false);
+    std::shared_ptr<Product_Data_Thermal>
+      convert_thermal_data(std::shared_ptr<OpticsParser::ProductData> const & product);
 }   // namespace wincalc
@@ -4,6 +4,8 @@
 #include "optical_calcs.h"
 #include "util.h"
 #include "thermal_ir.h"
+#include "instrumentation.h"
+#include "trace.h"
 
 
 namespace wincalc
@@ -63,6 +65,23 @@ namespace wincalc
         return converted;
     }
 
+    std::vector<SpectralAveraging::MeasuredRow> convert(N_Band_Spectral_Data const & data)
+    {
+        // Only rows with a direct component, the same as converting the rows
+        auto const & wavelengths = data.direct_wavelengths();
+        auto const & tf = data.tf();
+        auto const & rf = data.rf();
+        auto const & rb = data.rb();
+
+        std::vector<SpectralAveraging::MeasuredRow> converted;
+        converted.reserve(wavelengths.size());
+        for(size_t i = 0; i < wavelengths.size(); ++i)
+        {
+            converted.emplace_back(wavelengths[i], tf[i], rf[i], rb[i]);
+        }
+        return converted;
+    }
+
     FenestrationCommon::CSeries convert(std::vector<std::pair<double, double>> const & v)
     {
         FenestrationCommon::CSeries series;
@@ -416,30 +435,25 @@ namespace wincalc
         return Lambda_Range{min_wavelength, max_wavelength};
     }
 
-    FenestrationCommon::CSeries get_eqef(std::vector<OpticsParser::WLData> const & data)
+    FenestrationCommon::CSeries get_pv_series(std::vector<double> const & wavelengths,
+                                              std::vector<double> const & values)
     {
         FenestrationCommon::CSeries res;
-        for(auto & row : data)
+        for(size_t i = 0; i < wavelengths.size(); ++i)
         {
-            if(row.pvComponent.has_value())
-            {
-                res.addProperty(row.wavelength, row.pvComponent.value().eqef);
-            }
+            res.addProperty(wavelengths[i], values[i]);
         }
         return res;
     }
 
-    FenestrationCommon::CSeries get_eqeb(std::vector<OpticsParser::WLData> const & data)
+    FenestrationCommon::CSeries get_eqef(N_Band_Spectral_Data const & data)
     {
-        FenestrationCommon::CSeries res;
-        for(auto & row : data)
-        {
-            if(row.pvComponent.has_value())
-            {
-                res.addProperty(row.wavelength, row.pvComponent.value().eqeb);
-            }
-        }
-        return res;
+        return get_pv_series(data.pv_wavelengths(), data.eqef());
+    }
+
+    FenestrationCommon::CSeries get_eqeb(N_Band_Spectral_Data const & data)
+    {
+        return get_pv_series(data.pv_wavelengths(), data.eqeb());
     }
 
     std::shared_ptr<SingleLayerOptics::CMaterial>
@@ -457,7 +471,7 @@ namespace wincalc
 
         auto integration_rule = convert(method.integration_rule.type);
 
-        auto measured_wavelength_data = convert(product_data.wavelength_data);
+        auto measured_wavelength_data = convert(product_data.spectral_data);
         auto spectral_sample_data =
           SpectralAveraging::CSpectralSampleData::create(measured_wavelength_data);
 
@@ -491,14 +505,14 @@ namespace wincalc
 
         auto integration_rule = convert(method.integration_rule.type);
 
-        auto measured_wavelength_data = convert(product_data.wavelength_data);
+        auto measured_wavelength_data = convert(product_data.spectral_data);
         auto spectral_sample_data =
           SpectralAveraging::CSpectralSampleData::create(measured_wavelength_data);
 
         auto lambda_range = get_lambda_range({product_data.wavelengths()}, method);
 
-        auto eqef = get_eqef(product_data.wavelength_data);
-        auto eqeb = get_eqeb(product_data.wavelength_data);
+        auto eqef = get_eqef(product_data.spectral_data);
+        auto eqeb = get_eqeb(product_data.spectral_data);
 
         auto pvSample = std::make_shared<SpectralAveraging::PhotovoltaicSampleData>(
           measured_wavelength_data, eqef, eqeb);
@@ -524,8 +538,10 @@ namespace wincalc
                       int number_visible_bands,
                       int number_solar_bands)
     {
+        WINCALC_TIME_STAGE(CREATE_MATERIAL);
+        WINCALC_TRACE_SCOPE_ARGUMENTS("create_material", {"method", method.name});
         std::shared_ptr<SingleLayerOptics::CMaterial> material;
-        auto wavelengths = product_data->wavelengths();
+        auto const & wavelengths = product_data->wavelengths();
         double material_min_wavelength = wavelengths.front();
         double material_max_wavelength = wavelengths.back();
         auto source_spectrum = get_spectum_values(method.source_spectrum, method, wavelengths);
@@ -638,8 +654,10 @@ namespace wincalc
                          int number_visible_bands,
                          int number_solar_bands)
     {
+        WINCALC_TIME_STAGE(CREATE_MATERIAL);
+        WINCALC_TRACE_SCOPE_ARGUMENTS("create_pv_material", {"method", method.name});
         std::shared_ptr<SingleLayerOptics::CMaterial> material;
-        auto wavelengths = product_data->wavelengths();
+        auto const & wavelengths = product_data->wavelengths();
         double material_min_wavelength = wavelengths.front();
         double material_max_wavelength = wavelengths.back();
         auto source_spectrum = get_spectum_values(method.source_spectrum, method, wavelengths);
@@ -766,7 +784,8 @@ namespace wincalc
                             size_t number_of_layers,
                             Spectal_Data_Wavelength_Range_Method const & type,
                             int number_visible_bands,
-                            int number_solar_bands)
+                            int number_solar_bands,
+                            std::optional<bool> flipped)
     {
         std::shared_ptr<SingleLayerOptics::SpecularLayer> specular_layer;
         if(is_pv(product_data))
@@ -787,7 +806,7 @@ namespace wincalc
                                             number_solar_bands);
             specular_layer = SingleLayerOptics::SpecularLayer::createLayer(material);
         }
-        specular_layer->Flipped(product_data->flipped);
+        specular_layer->Flipped(flipped.value_or(product_data->flipped));
         return specular_layer;
     }
 
@@ -797,14 +816,34 @@ namespace wincalc
       window_standards::Optical_Standard_Method const & method,
       Spectal_Data_Wavelength_Range_Method const & type,
       int number_visible_bands,
-      int number_solar_bands)
+      int number_solar_bands,
+      std::vector<bool> const & flipped_layers)
     {
+        if(!flipped_layers.empty() && flipped_layers.size() != product_data.size())
+        {
+            std::stringstream msg;
+            msg << "Number of flipped layer values (" << flipped_layers.size()
+                << ") does not match the number of layers (" << product_data.size() << ")";
+            throw std::runtime_error(msg.str());
+        }
+        WINCALC_TRACE_SCOPE_ARGUMENTS("create_multi_pane_specular", {"method", method.name});
         std::vector<std::shared_ptr<SingleLayerOptics::SpecularLayer>> layers;
         auto number_of_layers = product_data.size();
-        for(std::shared_ptr<wincalc::Product_Data_Optical> const & product : product_data)
+        for(size_t i = 0; i < number_of_layers; ++i)
         {
-            layers.push_back(create_specular_layer(
-              product, method, number_of_layers, type, number_visible_bands, number_solar_bands));
+            WINCALC_TRACE_SCOPE_ARGUMENTS("layer", {"layer", static_cast<int64_t>(i)});
+            std::optional<bool> flipped;
+            if(!flipped_layers.empty())
+            {
+                flipped = flipped_layers[i];
+            }
+            layers.push_back(create_specular_layer(product_data[i],
+                                                   method,
+                                                   number_of_layers,
+                                                   type,
+                                                   number_visible_bands,
+                                                   number_solar_bands,
+                                                   flipped));
         }
 
         std::vector<std::vector<double>> wavelengths = get_wavelengths(product_data);
@@ -984,6 +1023,8 @@ namespace wincalc
                         int number_visible_bands,
                         int number_solar_bands)
     {
+        WINCALC_TIME_STAGE(CREATE_BSDF_LAYER);
+        WINCALC_TRACE_SCOPE_ARGUMENTS("create_bsdf_layer", {"method", method.name});
         std::shared_ptr<SingleLayerOptics::CBSDFLayer> layer;
         if(std::dynamic_pointer_cast<wincalc::Product_Data_Optical_Perfectly_Diffuse>(product_data))
         {
@@ -1100,11 +1141,14 @@ namespace wincalc
       int number_visible_bands,
       int number_solar_bands)
     {
+        WINCALC_TRACE_SCOPE_ARGUMENTS("create_multi_pane_bsdf", {"method", method.name});
         std::vector<std::shared_ptr<SingleLayerOptics::CBSDFLayer>> layers;
         std::vector<std::vector<double>> wavelengths;
         auto number_of_layers = products.size();
-        for(auto const & product : products)
+        for(size_t i = 0; i < number_of_layers; ++i)
         {
+            WINCALC_TRACE_SCOPE_ARGUMENTS("layer", {"layer", static_cast<int64_t>(i)});
+            auto const & product = products[i];
             layers.push_back(create_bsdf_layer(product,
                                                method,
                                                number_of_layers,
@@ -1131,8 +1175,10 @@ namespace wincalc
       std::optional<SingleLayerOptics::CBSDFHemisphere> bsdf_hemisphere,
       Spectal_Data_Wavelength_Range_Method const & type,
       int number_visible_bands,
-      int number_solar_bands)
+      int number_solar_bands,
+      std::vector<bool> const & flipped_layers)
     {
+        WINCALC_TIME_STAGE(CREATE_MULTI_PANE);
         bool as_bsdf = false;
         for(auto product : product_data)
         {
@@ -1164,8 +1210,12 @@ namespace wincalc
         }
         else
         {
-            return create_multi_pane_specular(
-              product_data, method, type, number_visible_bands, number_solar_bands);
+            return create_multi_pane_specular(product_data,
+                                              method,
+                                              type,
+                                              number_visible_bands,
+                                              number_solar_bands,
+                                              flipped_layers);
         }
     }
 
@@ -1203,6 +1253,11 @@ namespace wincalc
                  double phi,
                  std::optional<SingleLayerOptics::CBSDFHemisphere> bsdf_hemisphere)
     {
+        WINCALC_TIME_STAGE(CREATE_IGU);
+        WINCALC_TRACE_SCOPE_ARGUMENTS("create_igu",
+                                      {"layers", static_cast<int64_t>(layers.size())},
+                                      {"theta", theta},
+                                      {"phi", phi});
         std::ignore = theta;
         std::ignore = phi;
         std::ignore = bsdf_hemisphere;
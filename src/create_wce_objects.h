@@ -43,6 +43,8 @@ namespace wincalc
     std::vector<SpectralAveraging::MeasuredRow>
       convert(std::vector<OpticsParser::WLData> const & data);
 
+    std::vector<SpectralAveraging::MeasuredRow> convert(N_Band_Spectral_Data const & data);
+
     FenestrationCommon::CSeries convert(std::vector<std::pair<double, double>> const & v);
 
     std::shared_ptr<SpectralAveraging::CSpectralSampleData>
@@ -81,8 +83,11 @@ namespace wincalc
                             Spectal_Data_Wavelength_Range_Method const & type =
                               Spectal_Data_Wavelength_Range_Method::FULL,
                             int number_visible_bands = 5,
-                            int number_solar_bands = 10);
+                            int number_solar_bands = 10,
+                            std::optional<bool> flipped = std::optional<bool>());
 
+    // flipped_layers has one value per layer and takes precedence over the flipped flag on the
+    // product data.  If empty the flag on the product data is used.
     std::unique_ptr<SingleLayerOptics::IScatteringLayer> create_multi_pane(
       std::vector<std::shared_ptr<wincalc::Product_Data_Optical>> const & product_data,
       window_standards::Optical_Standard_Method const & method,
@@ -91,7 +96,8 @@ namespace wincalc
       Spectal_Data_Wavelength_Range_Method const & type =
         Spectal_Data_Wavelength_Range_Method::FULL,
       int number_visible_bands = 5,
-      int number_solar_bands = 10);
+      int number_solar_bands = 10,
+      std::vector<bool> const & flipped_layers = std::vector<bool>());
 
     std::shared_ptr<SingleLayerOptics::CBSDFLayer>
       create_bsdf_layer(std::shared_ptr<wincalc::Product_Data_Optical> const & product_data,
@@ -2,6 +2,7 @@
 #define WINCALC_DEFLECTION_RESULTS_H_
 
 #include <vector>
+#include <cstddef>
 
 namespace wincalc
 {
@@ -10,7 +11,46 @@ namespace wincalc
         std::vector<double> deflection_max;
         std::vector<double> deflection_mean;
 		std::vector<double> panes_load;
+        // Number of coupled thermal-deflection passes performed and whether the change in
+        // maximum deflection between the last two passes was within the solver tolerance.
+        // A single pass does no check and is reported as converged, as are results without
+        // deflection.
+        // See Deflection_Solver_Settings.
+        size_t passes = 1;
+        // Tarcog solver iterations summed over the passes
+        size_t solver_iterations = 0;
+        bool converged = true;
     };
+
+    // Controls for the coupled thermal-deflection solution used by calc_deflection_properties.
+    // Each pass after the first applies the deflection properties to the solved Tarcog system
+    // again, which has Tarcog solve it again with the deflections of the previous pass.
+    // Passes stop once the largest change in maximum pane deflection (m) is no more than
+    // tolerance or after max_passes passes.  The default of a single pass matches the
+    // behavior of earlier versions.
+    struct Deflection_Solver_Settings
+    {
+        double tolerance = 1e-9;
+        size_t max_passes = 1;
+    };
+
+    // One point of a deflection sweep.  Pressure in Pa, temperatures in K, tilt in degrees
+    // and applied loads in Pa, one per pane.
+    struct Deflection_Sweep_Point
+    {
+        std::vector<double> applied_loads;
+        double initial_temperature = 293.15;
+        double initial_pressure = 101325;
+        double tilt = 90;
+    };
+
+    // Full factorial grid of sweep points.  Tilt varies slowest and applied loads fastest so
+    // consecutive points differ by as little as possible.
+    std::vector<Deflection_Sweep_Point>
+      deflection_sweep_grid(std::vector<std::vector<double>> const & applied_loads,
+                            std::vector<double> const & initial_temperatures,
+                            std::vector<double> const & initial_pressures,
+                            std::vector<double> const & tilts);
 }   // namespace wincalc
 
 #endif
@@ -1,17 +1,75 @@
 #include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <utility>
 
 #include "glazing_system.h"
 #include "optical_calcs.h"
 #include "util.h"
 #include "create_wce_objects.h"
 #include "convert_optics_parser.h"
+#include "instrumentation.h"
+#include "trace.h"
 
 namespace wincalc
 {
+    namespace
+    {
+        // Runs a Tarcog result query, which solves the system first if it has not been solved,
+        // as the TARCOG_SOLVE stage
+        template<typename Query>
+        auto tarcog_query([[maybe_unused]] Tarcog::ISO15099::CSystem & system,
+                          [[maybe_unused]] Tarcog::ISO15099::System system_type,
+                          Query && query)
+        {
+            WINCALC_TIME_STAGE(TARCOG_SOLVE);
+            WINCALC_TRACE_SCOPE("tarcog_solve");
+            auto result = query();
+            WINCALC_COUNT(TARCOG_QUERIES, 1);
+            WINCALC_COUNT(TARCOG_ITERATIONS, system.getNumberOfIterations(system_type));
+            return result;
+        }
+
+        std::vector<std::string> parsed_product_names(
+          std::vector<std::shared_ptr<OpticsParser::ProductData>> const & parsed)
+        {
+            std::vector<std::string> names;
+            names.reserve(parsed.size());
+            for(auto const & product : parsed)
+            {
+                names.push_back(product ? product->productName : std::string());
+            }
+            return names;
+        }
+
+#ifdef WINCALC_ENABLE_TRACING
+        // Product names of a system as one trace event argument
+        std::string products_argument(std::vector<std::string> const & names)
+        {
+            std::string joined;
+            for(size_t i = 0; i < names.size(); ++i)
+            {
+                joined += (i == 0 ? "" : ", ");
+                joined += names[i].empty() ? "unnamed" : names[i];
+            }
+            return joined;
+        }
+#endif
+    }   // namespace
+
+// Trace event for a Glazing_System entry point labelled with its angles and products
+#define WINCALC_TRACE_GLAZING_SYSTEM(name)                                \
+    WINCALC_TRACE_SCOPE_ARGUMENTS("Glazing_System::" name,                 \
+                                  {"theta", theta},                        \
+                                  {"phi", phi},                            \
+                                  {"products", products_argument(product_names)})
+
     WCE_Optical_Results Glazing_System::optical_method_results(std::string const & method_name,
                                                                double theta,
                                                                double phi) const
     {
+        WINCALC_COLLECT_STATISTICS(instrumentation_statistics);
+        WINCALC_TRACE_GLAZING_SYSTEM("optical_method_results");
         if(method_name == "THERMAL IR")
         {
             throw std::runtime_error(
@@ -36,14 +94,16 @@ namespace wincalc
               "way.");
         }
         auto method = get_method(method_name);
-        return calc_all(get_optical_layers(product_data),
+        auto const & layers = optical_layer_data();
+        return calc_all(get_optical_layers(layers),
                         method,
                         theta,
                         phi,
                         bsdf_hemisphere,
                         spectral_data_wavelength_range_method,
                         number_visible_bands,
-                        number_solar_bands);
+                        number_solar_bands,
+                        get_flipped_layers(layers));
     }
 
     WCE_Color_Results Glazing_System::color(double theta,
@@ -52,10 +112,13 @@ namespace wincalc
                                             std::string const & tristimulus_y_method,
                                             std::string const & tristimulus_z_method) const
     {
+        WINCALC_COLLECT_STATISTICS(instrumentation_statistics);
+        WINCALC_TRACE_GLAZING_SYSTEM("color");
         window_standards::Optical_Standard_Method tristim_x = get_method(tristimulus_x_method);
         window_standards::Optical_Standard_Method tristim_y = get_method(tristimulus_y_method);
         window_standards::Optical_Standard_Method tristim_z = get_method(tristimulus_z_method);
-        return calc_color(get_optical_layers(product_data),
+        auto const & layers = optical_layer_data();
+        return calc_color(get_optical_layers(layers),
                           tristim_x,
                           tristim_y,
                           tristim_z,
@@ -64,7 +127,8 @@ namespace wincalc
                           bsdf_hemisphere,
                           spectral_data_wavelength_range_method,
                           number_visible_bands,
-                          number_solar_bands);
+                          number_solar_bands,
+                          get_flipped_layers(layers));
     }
 
     void Glazing_System::reset_igu()
@@ -96,12 +160,14 @@ namespace wincalc
     {
         if(current_igu.has_value() && theta == last_theta && phi == last_phi)
         {
+            WINCALC_COUNT(IGU_CACHE_HIT, 1);
             return current_igu.value();
         }
         else
         {
+            WINCALC_COUNT(IGU_CACHE_MISS, 1);
             current_igu = create_igu(
-              product_data, gap_values, width, height, tilt, standard, theta, phi, bsdf_hemisphere);
+              layer_data(), gap_values, width, height, tilt, standard, theta, phi, bsdf_hemisphere);
             if(!applied_loads.empty())
             {
                 current_igu.value().setAppliedLoad(applied_loads);
@@ -120,6 +186,7 @@ namespace wincalc
         {
             auto & igu = get_igu(theta, phi);
             current_system = create_system(igu, environment);
+            deflection_updates_needed = true;
             last_theta = theta;
             last_phi = phi;
             return current_system.value();
@@ -128,13 +195,18 @@ namespace wincalc
 
     double Glazing_System::u(double theta, double phi)
     {
+        WINCALC_COLLECT_STATISTICS(instrumentation_statistics);
+        WINCALC_TRACE_GLAZING_SYSTEM("u");
         do_deflection_updates(theta, phi);
         auto & system = get_system(theta, phi);
-        return system.getUValue();
+        return tarcog_query(
+          system, Tarcog::ISO15099::System::Uvalue, [&system]() { return system.getUValue(); });
     }
 
     double Glazing_System::shgc(double theta, double phi)
     {
+        WINCALC_COLLECT_STATISTICS(instrumentation_statistics);
+        WINCALC_TRACE_GLAZING_SYSTEM("shgc");
         // Doing deflection updates and creating the system before calculating the optical results
         // because there are cases where the thermal system cannot be created.  E.G. genSDF XML
         // files do not have conductivity and so can be used in optical calcs but not thermal.
@@ -144,7 +216,7 @@ namespace wincalc
         auto & system = get_system(theta, phi);
 
         auto optical_results =
-          optical_solar_results_needed_for_thermal_calcs(product_data,
+          optical_solar_results_needed_for_thermal_calcs(layer_data(),
                                                          optical_standard(),
                                                          theta,
                                                          phi,
@@ -154,7 +226,9 @@ namespace wincalc
                                                          number_solar_bands);
 
         system.setAbsorptances(optical_results.layer_solar_absorptances);
-        return system.getSHGC(optical_results.total_solar_transmittance);
+        return tarcog_query(system, Tarcog::ISO15099::System::SHGC, [&]() {
+            return system.getSHGC(optical_results.total_solar_transmittance);
+        });
 
 
         // return shgc(optical_results.layer_solar_absorptances,
@@ -165,6 +239,8 @@ namespace wincalc
                                                            double theta,
                                                            double phi)
     {
+        WINCALC_COLLECT_STATISTICS(instrumentation_statistics);
+        WINCALC_TRACE_GLAZING_SYSTEM("layer_temperatures");
         // Don't do deflection updates if theta and phi are unchanged.  If this check is not
         // present then the CSystem m_solved value will get set to false causing the deflection
         // solver to go through another iteration resulting in slightly differnt temperatures
@@ -187,7 +263,7 @@ namespace wincalc
         auto & system = get_system(theta, phi);
 
         auto optical_results =
-          optical_solar_results_needed_for_thermal_calcs(product_data,
+          optical_solar_results_needed_for_thermal_calcs(layer_data(),
                                                          optical_standard(),
                                                          theta,
                                                          phi,
@@ -200,7 +276,8 @@ namespace wincalc
         {
             system.setAbsorptances(optical_results.layer_solar_absorptances);
         }
-        return system.getTemperatures(system_type);
+        return tarcog_query(
+          system, system_type, [&]() { return system.getTemperatures(system_type); });
     }
 
     void Glazing_System::set_deflection_properties(double temperature_initial,
@@ -208,6 +285,7 @@ namespace wincalc
     {
         initial_pressure = pressure_initial;
         initial_temperature = temperature_initial;
+        deflection_updates_needed = true;
         do_deflection_updates(last_theta, last_phi);
     }
 
@@ -217,29 +295,154 @@ namespace wincalc
         if(current_system)
         {
             current_system.value().setAppliedLoad(applied_loads);
+            deflection_updates_needed = true;
         }
     }
 
     Deflection_Results Glazing_System::calc_deflection_properties(
       Tarcog::ISO15099::System system_type, double theta, double phi)
     {
+        WINCALC_COLLECT_STATISTICS(instrumentation_statistics);
+        WINCALC_TRACE_GLAZING_SYSTEM("calc_deflection_properties");
         do_deflection_updates(theta, phi);
         auto & system = get_system(theta, phi);
-        auto deflection_max = system.getMaxDeflections(system_type);
+        auto max_deflections = [&]() { return system.getMaxDeflections(system_type); };
+        auto deflection_max = tarcog_query(system, system_type, max_deflections);
+
+        size_t passes = 1;
+        size_t solver_iterations = system.getNumberOfIterations(system_type);
+        // Without deflection there is nothing to iterate so the single pass is converged
+        bool converged = !model_deflection || solver_settings.max_passes <= 1;
+        while(model_deflection && passes < solver_settings.max_passes)
+        {
+            system.setDeflectionProperties(initial_temperature, initial_pressure);
+            auto next_deflection_max = tarcog_query(system, system_type, max_deflections);
+            solver_iterations += system.getNumberOfIterations(system_type);
+            ++passes;
+
+            double max_change = 0;
+            for(size_t i = 0; i < next_deflection_max.size() && i < deflection_max.size(); ++i)
+            {
+                max_change =
+                  std::max(max_change, std::abs(next_deflection_max[i] - deflection_max[i]));
+            }
+            deflection_max = next_deflection_max;
+            if(max_change <= solver_settings.tolerance)
+            {
+                converged = true;
+                break;
+            }
+        }
+
         auto deflection_mean = system.getMeanDeflections(system_type);
         auto panes_load = system.getPanesLoad(system_type);
-        return {deflection_max, deflection_mean, panes_load};
+        return {
+          deflection_max, deflection_mean, panes_load, passes, solver_iterations, converged};
+    }
+
+    std::vector<Deflection_Results>
+      Glazing_System::deflection_sweep(std::vector<Deflection_Sweep_Point> const & points,
+                                       Tarcog::ISO15099::System system_type,
+                                       double theta,
+                                       double phi,
+                                       size_t number_of_threads) const
+    {
+        WINCALC_COLLECT_STATISTICS(instrumentation_statistics);
+        WINCALC_TRACE_GLAZING_SYSTEM("deflection_sweep");
+        std::vector<Deflection_Results> results(points.size());
+        // Convert the layers once here rather than in every copy
+        layer_data();
+        parallel_for(points.size(), number_of_threads, [&](size_t begin, size_t end) {
+            // Each block works on its own copy.  The copy must not keep the cached Tarcog
+            // objects since copies of those share state with this system.
+            Glazing_System system(*this);
+            system.model_deflection = true;
+            for(size_t i = begin; i < end; ++i)
+            {
+                auto const & point = points[i];
+                // Every point starts from a new IGU built at the requested angles, as a new
+                // system would, so no deflection state carries over from the point before and
+                // the results do not depend on how the points are split between threads.
+                system.applied_loads.clear();
+                system.reset_igu();
+                system.last_theta = theta;
+                system.last_phi = phi;
+                system.set_tilt(point.tilt);
+                system.set_deflection_properties(point.initial_temperature,
+                                                 point.initial_pressure);
+                // Loads are set after the system exists so they are applied to the CSystem the
+                // same way set_applied_loads does for an existing system.  No loads means no
+                // loads for this point, not the loads of the previous one.
+                system.set_applied_loads(point.applied_loads.empty()
+                                           ? std::vector<double>(product_data.size(), 0.0)
+                                           : point.applied_loads);
+                results[i] = system.calc_deflection_properties(system_type, theta, phi);
+            }
+        });
+        return results;
+    }
+
+    std::vector<Deflection_Sweep_Point>
+      deflection_sweep_grid(std::vector<std::vector<double>> const & applied_loads,
+                            std::vector<double> const & initial_temperatures,
+                            std::vector<double> const & initial_pressures,
+                            std::vector<double> const & tilts)
+    {
+        std::vector<Deflection_Sweep_Point> points;
+        for(auto tilt : tilts)
+        {
+            for(auto temperature : initial_temperatures)
+            {
+                for(auto pressure : initial_pressures)
+                {
+                    for(auto const & loads : applied_loads)
+                    {
+                        points.push_back({loads, temperature, pressure, tilt});
+                    }
+                }
+            }
+        }
+        return points;
+    }
+
+    void Glazing_System::set_deflection_solver_settings(Deflection_Solver_Settings const & settings)
+    {
+        if(settings.max_passes == 0)
+        {
+            throw std::runtime_error("Deflection solver max_passes must be at least 1");
+        }
+        if(settings.tolerance < 0)
+        {
+            std::stringstream err_msg;
+            err_msg << "Deflection solver tolerance must not be negative: " << settings.tolerance;
+            throw std::runtime_error(err_msg.str());
+        }
+        solver_settings = settings;
+    }
+
+    Deflection_Solver_Settings Glazing_System::deflection_solver_settings() const
+    {
+        return solver_settings;
     }
 
     void Glazing_System::do_deflection_updates(double theta, double phi)
     {
+        // setDeflectionProperties and clearDeflection both mark the CSystem as unsolved so the
+        // next query solves it again.  Without deflection that solve only repeats the previous
+        // one so clearDeflection is only called when the system was rebuilt or a setting
+        // changed.
+        // With deflection each solve is another deflection pass starting from the previous
+        // one and the expected results, which come from Windows-CalcEngine, depend on those
+        // passes so the properties are still applied on every query.
         auto & system = get_system(theta, phi);
         if(model_deflection)
         {
+            deflection_updates_needed = false;
             system.setDeflectionProperties(initial_temperature, initial_pressure);
         }
-        else
+        else if(deflection_updates_needed)
         {
+            deflection_updates_needed = false;
             system.clearDeflection();
         }
     }
@@ -248,27 +451,41 @@ namespace wincalc
     std::vector<double> Glazing_System::solid_layers_effective_conductivities(
       Tarcog::ISO15099::System system_type, double theta, double phi)
     {
+        WINCALC_COLLECT_STATISTICS(instrumentation_statistics);
+        WINCALC_TRACE_GLAZING_SYSTEM("solid_layers_effective_conductivities");
         do_deflection_updates(theta, phi);
         auto & system = get_system(theta, phi);
-        return system.getSolidEffectiveLayerConductivities(system_type);
+        return tarcog_query(system, system_type, [&]() {
+            return system.getSolidEffectiveLayerConductivities(system_type);
+        });
     }
     std::vector<double> Glazing_System::gap_layers_effective_conductivities(
       Tarcog::ISO15099::System system_type, double theta, double phi)
     {
+        WINCALC_COLLECT_STATISTICS(instrumentation_statistics);
+        WINCALC_TRACE_GLAZING_SYSTEM("gap_layers_effective_conductivities");
         do_deflection_updates(theta, phi);
         auto & system = get_system(theta, phi);
-        return system.getGapEffectiveLayerConductivities(system_type);
+        return tarcog_query(system, system_type, [&]() {
+            return system.getGapEffectiveLayerConductivities(system_type);
+        });
     }
     double Glazing_System::system_effective_conductivity(Tarcog::ISO15099::System system_type,
                                                          double theta,
                                                          double phi)
     {
+        WINCALC_COLLECT_STATISTICS(instrumentation_statistics);
+        WINCALC_TRACE_GLAZING_SYSTEM("system_effective_conductivity");
         do_deflection_updates(theta, phi);
         auto & system = get_system(theta, phi);
-        return system.getEffectiveSystemConductivity(system_type);
+        return tarcog_query(system, system_type, [&]() {
+            return system.getEffectiveSystemConductivity(system_type);
+        });
     }
     double Glazing_System::relative_heat_gain(double theta, double phi)
     {
+        WINCALC_COLLECT_STATISTICS(instrumentation_statistics);
+        WINCALC_TRACE_GLAZING_SYSTEM("relative_heat_gain");
         // Doing deflection updates and creating the system before calculating the optical results
         // because there are cases where the thermal system cannot be created.  E.G. genSDF XML
         // files do not have conductivity and so can be used in optical calcs but not thermal.
@@ -278,7 +495,7 @@ namespace wincalc
         auto & system = get_system(theta, phi);
 
         auto optical_results =
-          optical_solar_results_needed_for_thermal_calcs(product_data,
+          optical_solar_results_needed_for_thermal_calcs(layer_data(),
                                                          optical_standard(),
                                                          theta,
                                                          phi,
@@ -287,7 +504,170 @@ namespace wincalc
                                                          number_visible_bands,
                                                          number_solar_bands);
 
-        return system.relativeHeatGain(optical_results.total_solar_transmittance);
+        return tarcog_query(system, Tarcog::ISO15099::System::SHGC, [&]() {
+            return system.relativeHeatGain(optical_results.total_solar_transmittance);
+        });
+    }
+
+    Tarcog::ISO15099::CSystem
+      Glazing_System::environment_system(Tarcog::ISO15099::CIGU & igu,
+                                         Environments const & environments)
+    {
+        auto system = create_system(igu, environments);
+        system.setWidth(width);
+        system.setHeight(height);
+        system.setTilt(tilt);
+        if(!applied_loads.empty())
+        {
+            system.setAppliedLoad(applied_loads);
+        }
+        if(model_deflection)
+        {
+            system.setDeflectionProperties(initial_temperature, initial_pressure);
+        }
+        else
+        {
+            system.clearDeflection();
+        }
+        return system;
+    }
+
+    Thermal_Environment_Results Glazing_System::thermal_environment_results(
+      Tarcog::ISO15099::CIGU & igu,
+      Environments const & environments,
+      std::vector<double> const & layer_solar_absorptances,
+      double total_solar_transmittance)
+    {
+        using Tarcog::ISO15099::System;
+
+        auto system = environment_system(igu, environments);
+        system.setAbsorptances(layer_solar_absorptances);
+
+        Thermal_Environment_Results results;
+        results.u =
+          tarcog_query(system, System::Uvalue, [&system]() { return system.getUValue(); });
+        results.shgc = tarcog_query(system, System::SHGC, [&]() {
+            return system.getSHGC(total_solar_transmittance);
+        });
+        results.relative_heat_gain = system.relativeHeatGain(total_solar_transmittance);
+        results.system_effective_conductivity_u =
+          system.getEffectiveSystemConductivity(System::Uvalue);
+        results.system_effective_conductivity_shgc =
+          system.getEffectiveSystemConductivity(System::SHGC);
+        results.solid_layers_effective_conductivities_u =
+          system.getSolidEffectiveLayerConductivities(System::Uvalue);
+        results.solid_layers_effective_conductivities_shgc =
+          system.getSolidEffectiveLayerConductivities(System::SHGC);
+        results.gap_layers_effective_conductivities_u =
+          system.getGapEffectiveLayerConductivities(System::Uvalue);
+        results.gap_layers_effective_conductivities_shgc =
+          system.getGapEffectiveLayerConductivities(System::SHGC);
+        results.layer_temperatures_u = system.getTemperatures(System::Uvalue);
+        results.layer_temperatures_shgc = system.getTemperatures(System::SHGC);
+        results.deflection_u = {system.getMaxDeflections(System::Uvalue),
+                                system.getMeanDeflections(System::Uvalue),
+                                system.getPanesLoad(System::Uvalue),
+                                1,
+                                system.getNumberOfIterations(System::Uvalue)};
+        results.deflection_shgc = {system.getMaxDeflections(System::SHGC),
+                                   system.getMeanDeflections(System::SHGC),
+                                   system.getPanesLoad(System::SHGC),
+                                   1,
+                                   system.getNumberOfIterations(System::SHGC)};
+        return results;
+    }
+
+    Thermal_Report Glazing_System::thermal_report(Environments const & u_environment,
+                                                  Environments const & shgc_environment,
+                                                  double theta,
+                                                  double phi)
+    {
+        WINCALC_COLLECT_STATISTICS(instrumentation_statistics);
+        WINCALC_TRACE_GLAZING_SYSTEM("thermal_report");
+        // Build the IGU before the optical calculations for the same reason as shgc()
+        auto & igu = get_igu(theta, phi);
+
+        auto optical_results =
+          optical_solar_results_needed_for_thermal_calcs(layer_data(),
+                                                         optical_standard(),
+                                                         theta,
+                                                         phi,
+                                                         bsdf_hemisphere,
+                                                         spectral_data_wavelength_range_method,
+                                                         number_visible_bands,
+                                                         number_solar_bands);
+
+        Thermal_Report report;
+        report.u_environment =
+          thermal_environment_results(igu,
+                                      u_environment,
+                                      optical_results.layer_solar_absorptances,
+                                      optical_results.total_solar_transmittance);
+        report.shgc_environment =
+          thermal_environment_results(igu,
+                                      shgc_environment,
+                                      optical_results.layer_solar_absorptances,
+                                      optical_results.total_solar_transmittance);
+        return report;
+    }
+
+    CMA_Glazing Glazing_System::cma_glazing(Environments const & u_environment,
+                                            Environments const & shgc_environment,
+                                            std::string const & visible_method,
+                                            double theta,
+                                            double phi)
+    {
+        WINCALC_COLLECT_STATISTICS(instrumentation_statistics);
+        WINCALC_TRACE_GLAZING_SYSTEM("cma_glazing");
+        // Build the IGU before the optical calculations for the same reason as shgc()
+        auto & igu = get_igu(theta, phi);
+        auto visible = get_method(visible_method);
+
+        auto u_system = environment_system(igu, u_environment);
+        auto u = tarcog_query(u_system, Tarcog::ISO15099::System::Uvalue, [&u_system]() {
+            return u_system.getUValue();
+        });
+
+        auto optical_results =
+          optical_solar_results_needed_for_thermal_calcs(layer_data(),
+                                                         optical_standard(),
+                                                         theta,
+                                                         phi,
+                                                         bsdf_hemisphere,
+                                                         spectral_data_wavelength_range_method,
+                                                         number_visible_bands,
+                                                         number_solar_bands);
+        auto shgc_system = environment_system(igu, shgc_environment);
+        shgc_system.setAbsorptances(optical_results.layer_solar_absorptances);
+        auto shgc = tarcog_query(shgc_system, Tarcog::ISO15099::System::SHGC, [&]() {
+            return shgc_system.getSHGC(optical_results.total_solar_transmittance);
+        });
+
+        auto const & layers = optical_layer_data();
+        auto tvis = calc_optical_property(get_optical_layers(layers),
+                                          visible,
+                                          Calculated_Property_Choice::T,
+                                          Side_Choice::Front,
+                                          Scattering_Choice::DirectHemispherical,
+                                          theta,
+                                          phi,
+                                          bsdf_hemisphere,
+                                          spectral_data_wavelength_range_method,
+                                          number_visible_bands,
+                                          number_solar_bands,
+                                          get_flipped_layers(layers));
+
+        return CMA_Glazing{u, shgc, tvis};
+    }
+
+    instrumentation::Statistics Glazing_System::statistics() const
+    {
+        return instrumentation_statistics;
+    }
+
+    void Glazing_System::reset_statistics()
+    {
+        instrumentation_statistics = instrumentation::Statistics();
     }
 
     void Glazing_System::optical_standard(window_standards::Optical_Standard const & s)
@@ -300,39 +680,64 @@ namespace wincalc
         return standard;
     }
 
-    void Glazing_System::solid_layers(std::vector<Product_Data_Optical_Thermal> const & layers)
+    void Glazing_System::solid_layers(std::vector<Product_Data_Optical_Thermal> layers)
     {
         reset_igu();
-        product_data = layers;
+        product_data = std::move(layers);
+        parsed_layers.clear();
+        product_names.clear();
     }
 
     std::vector<Product_Data_Optical_Thermal> Glazing_System::solid_layers() const
     {
+        return layer_data();
+    }
+
+    std::vector<Product_Data_Optical_Thermal> const & Glazing_System::optical_layer_data() const
+    {
+        for(size_t i = 0; i < parsed_layers.size(); ++i)
+        {
+            auto & parsed = parsed_layers[i];
+            if(!parsed && !product_data[i].optical_data)
+            {
+                std::stringstream msg;
+                msg << "Layer " << i << " has no product data";
+                throw std::runtime_error(msg.str());
+            }
+            if(parsed && !product_data[i].optical_data)
+            {
+                // Nothing outside this system can see the product if this is the only reference
+                // so its measurements can be moved instead of copied
+                product_data[i].optical_data =
+                  convert_optical_data(parsed, parsed.use_count() == 1);
+            }
+        }
         return product_data;
     }
 
-    void Glazing_System::sort_spectral_data()
+    std::vector<Product_Data_Optical_Thermal> const & Glazing_System::layer_data() const
     {
-        for(auto & product : product_data)
+        if(parsed_layers.empty())
+        {
+            return product_data;
+        }
+        optical_layer_data();
+        for(size_t i = 0; i < parsed_layers.size(); ++i)
         {
-            auto nband_optical_data = std::dynamic_pointer_cast<Product_Data_N_Band_Optical>(
-              product.optical_data->optical_data());
-            if(nband_optical_data)
+            if(parsed_layers[i])
             {
-                auto & measurements = nband_optical_data->wavelength_data;
-                std::sort(measurements.begin(),
-                          measurements.end(),
-                          [](OpticsParser::WLData const & a, OpticsParser::WLData const & b) {
-                              return a.wavelength < b.wavelength;
-                          });
+                product_data[i].thermal_data = convert_thermal_data(parsed_layers[i]);
+                parsed_layers[i].reset();
             }
         }
+        parsed_layers.clear();
+        return product_data;
     }
 
     Glazing_System::Glazing_System(
       window_standards::Optical_Standard const & standard,
-      std::vector<Product_Data_Optical_Thermal> const & product_data,
-      std::vector<Engine_Gap_Info> const & gap_values,
+      std::vector<Product_Data_Optical_Thermal> product_data,
+      std::vector<Engine_Gap_Info> gap_values,
       double width,
       double height,
       double tilt,
@@ -341,8 +746,8 @@ namespace wincalc
       Spectal_Data_Wavelength_Range_Method const & spectral_data_wavelength_range_method,
       int number_visible_bands,
       int number_solar_bands) :
-        product_data(product_data),
-        gap_values(gap_values),
+        product_data(std::move(product_data)),
+        gap_values(std::move(gap_values)),
         standard(standard),
         width(width),
         height(height),
@@ -352,14 +757,12 @@ namespace wincalc
         spectral_data_wavelength_range_method(spectral_data_wavelength_range_method),
         number_visible_bands(number_visible_bands),
         number_solar_bands(number_solar_bands)
-    {
-        sort_spectral_data();
-    }
+    {}
 
     Glazing_System::Glazing_System(
       window_standards::Optical_Standard const & standard,
-      std::vector<std::shared_ptr<OpticsParser::ProductData>> const & product_data,
-      std::vector<Engine_Gap_Info> const & gap_values,
+      std::vector<std::shared_ptr<OpticsParser::ProductData>> product_data,
+      std::vector<Engine_Gap_Info> gap_values,
       double width,
       double height,
       double tilt,
@@ -368,8 +771,10 @@ namespace wincalc
       Spectal_Data_Wavelength_Range_Method const & spectral_data_wavelength_range_method,
       int number_visible_bands,
       int number_solar_bands) :
-        product_data(convert_to_solid_layers(product_data)),
-        gap_values(gap_values),
+        // Every layer starts as a placeholder, see layer_data
+        product_data(product_data.size(), Product_Data_Optical_Thermal(nullptr, nullptr)),
+        parsed_layers(std::move(product_data)),
+        gap_values(std::move(gap_values)),
         standard(standard),
         width(width),
         height(height),
@@ -380,40 +785,14 @@ namespace wincalc
         number_visible_bands(number_visible_bands),
         number_solar_bands(number_solar_bands)
     {
-        sort_spectral_data();
-    }
-
-    std::vector<Product_Data_Optical_Thermal> create_solid_layers(
-      std::vector<std::variant<std::shared_ptr<OpticsParser::ProductData>,
-                               Product_Data_Optical_Thermal>> const & product_data)
-    {
-        std::vector<Product_Data_Optical_Thermal> solid_layers;
-        for(auto product : product_data)
-        {
-            Product_Data_Optical_Thermal * solid_layer =
-              std::get_if<Product_Data_Optical_Thermal>(&product);
-            if(solid_layer)
-            {
-                // If the variant was already holding a converted object use it
-                solid_layers.push_back(*solid_layer);
-            }
-            else
-            {
-                // Otherwise the variant was holding OpticsParser::ProductData
-                // Convert that and use it
-                auto converted_layer = convert_to_solid_layer(
-                  std::get<std::shared_ptr<OpticsParser::ProductData>>(product));
-                solid_layers.push_back(converted_layer);
-            }
-        }
-        return solid_layers;
+        product_names = parsed_product_names(parsed_layers);
     }
 
     Glazing_System::Glazing_System(
       window_standards::Optical_Standard const & standard,
       std::vector<std::variant<std::shared_ptr<OpticsParser::ProductData>,
-                               Product_Data_Optical_Thermal>> const & product_data,
-      std::vector<Engine_Gap_Info> const & gap_values,
+                               Product_Data_Optical_Thermal>> product_data,
+      std::vector<Engine_Gap_Info> gap_values,
       double width,
       double height,
       double tilt,
@@ -422,8 +801,7 @@ namespace wincalc
       Spectal_Data_Wavelength_Range_Method const & spectral_data_wavelength_range_method,
       int number_visible_bands,
       int number_solar_bands) :
-        product_data(create_solid_layers(product_data)),
-        gap_values(gap_values),
+        gap_values(std::move(gap_values)),
         standard(standard),
         width(width),
         height(height),
@@ -434,7 +812,28 @@ namespace wincalc
         number_visible_bands(number_visible_bands),
         number_solar_bands(number_solar_bands)
     {
-        sort_spectral_data();
+        // Layers that were already converted are used as they are.  Parsed products are
+        // converted when a calculation first needs them, see layer_data.
+        this->product_data.reserve(product_data.size());
+        for(auto & product : product_data)
+        {
+            auto * solid_layer = std::get_if<Product_Data_Optical_Thermal>(&product);
+            if(solid_layer)
+            {
+                this->product_data.push_back(std::move(*solid_layer));
+            }
+            else
+            {
+                if(parsed_layers.empty())
+                {
+                    parsed_layers.resize(product_data.size());
+                }
+                parsed_layers[this->product_data.size()] =
+                  std::move(std::get<std::shared_ptr<OpticsParser::ProductData>>(product));
+                this->product_data.emplace_back(nullptr, nullptr);
+            }
+        }
+        product_names = parsed_product_names(parsed_layers);
     }
 
     Environments Glazing_System::environments() const
@@ -454,6 +853,7 @@ namespace wincalc
         if(current_system)
         {
             current_system.value().setWidth(width);
+            deflection_updates_needed = true;
         }
     }
 
@@ -463,6 +863,7 @@ namespace wincalc
         if(current_system)
         {
             current_system.value().setHeight(height);
+            deflection_updates_needed = true;
         }
     }
 
@@ -472,14 +873,13 @@ namespace wincalc
         if(current_system)
         {
             current_system.value().setTilt(tilt);
+            deflection_updates_needed = true;
         }
     }
 
     void Glazing_System::flip_layer(size_t layer_index, bool flipped)
     {
-        auto & layer = product_data.at(layer_index);
-        layer.optical_data->flipped = flipped;
-        layer.thermal_data->flipped = flipped;
+        product_data.at(layer_index).flipped = flipped;
         reset_igu();
     }
 
@@ -493,7 +893,11 @@ namespace wincalc
 
     void Glazing_System::enable_deflection(bool enable)
     {
-        model_deflection = enable;
+        if(model_deflection != enable)
+        {
+            model_deflection = enable;
+            deflection_updates_needed = true;
+        }
         do_deflection_updates(last_theta, last_phi);
     }
 }   // namespace wincalc
@@ -13,15 +13,36 @@
 #include "product_data.h"
 #include "create_wce_objects.h"
 #include "deflection_results.h"
+#include "thermal_results.h"
+#include "cma.h"
+#include "instrumentation.h"
 
 namespace wincalc
 {
+    // Thread safety:
+    // A Glazing_System caches the Tarcog IGU and system it last solved, so even the thermal
+    // queries (u, shgc, layer_temperatures, ...) modify the object.  A single instance must
+    // therefore not be used from more than one thread at a time without external locking.
+    // Separate instances can be used concurrently on separate threads, including instances
+    // built from the same converted products and the same Optical_Standard: the product data
+    // is never modified by a system.  Layer orientation set with flip_layer is stored on the
+    // system's own copy of the layer list and does not affect other systems.  Layers given as
+    // parsed products are converted by the first calculation that needs them, including const
+    // queries such as optical_method_results and solid_layers.
+    //
+    // The free functions used to set up systems keep no shared state either.
+    // load_optical_standard only reads the files it is given into a new Optical_Standard, and
+    // create_venetian_blind, create_woven_shade and create_perforated_screen convert their
+    // material into new product data that points at, but never modifies, the material passed
+    // in.  They can be called concurrently, also with the same parsed material.
     struct Glazing_System
     {
+        // The layers and gaps are taken by value.  Pass them with std::move, or pass freshly
+        // parsed products directly, to build a system without copying any measured data.
         Glazing_System(
           window_standards::Optical_Standard const & standard,
-          std::vector<Product_Data_Optical_Thermal> const & product_data,
-          std::vector<Engine_Gap_Info> const & gap_values = std::vector<Engine_Gap_Info>(),
+          std::vector<Product_Data_Optical_Thermal> product_data,
+          std::vector<Engine_Gap_Info> gap_values = std::vector<Engine_Gap_Info>(),
           double width = 1.0,
           double height = 1.0,
           double tilt = 90,
@@ -35,8 +56,8 @@ namespace wincalc
 
         Glazing_System(
           window_standards::Optical_Standard const & standard,
-          std::vector<std::shared_ptr<OpticsParser::ProductData>> const & product_data,
-          std::vector<Engine_Gap_Info> const & gap_values = std::vector<Engine_Gap_Info>(),
+          std::vector<std::shared_ptr<OpticsParser::ProductData>> product_data,
+          std::vector<Engine_Gap_Info> gap_values = std::vector<Engine_Gap_Info>(),
           double width = 1.0,
           double height = 1.0,
           double tilt = 90,
@@ -52,8 +73,8 @@ namespace wincalc
         Glazing_System(
           window_standards::Optical_Standard const & standard,
           std::vector<std::variant<std::shared_ptr<OpticsParser::ProductData>,
-                                   Product_Data_Optical_Thermal>> const & product_data,
-          std::vector<Engine_Gap_Info> const & gap_values = std::vector<Engine_Gap_Info>(),
+                                   Product_Data_Optical_Thermal>> product_data,
+          std::vector<Engine_Gap_Info> gap_values = std::vector<Engine_Gap_Info>(),
           double width = 1.0,
           double height = 1.0,
           double tilt = 90,
@@ -75,10 +96,25 @@ namespace wincalc
         void enable_deflection(bool model);
         void set_deflection_properties(double temperature_initial, double pressure_initial);
         void set_applied_loads(std::vector<double> const & loads);
+        void set_deflection_solver_settings(Deflection_Solver_Settings const & settings);
+        Deflection_Solver_Settings deflection_solver_settings() const;
         Deflection_Results calc_deflection_properties(Tarcog::ISO15099::System system_type,
                                                       double theta = 0,
                                                       double phi = 0);
 
+        // Deflection results for every point, in the same order as points.  Deflection is
+        // modeled for every point regardless of enable_deflection and this system is left
+        // unchanged.  Each point is solved from a new IGU, the same as a new system set up with
+        // that point's values, so the results do not depend on number_of_threads.  Points are
+        // split into contiguous blocks, one per thread.  number_of_threads = 0 uses one thread
+        // per core.
+        std::vector<Deflection_Results>
+          deflection_sweep(std::vector<Deflection_Sweep_Point> const & points,
+                           Tarcog::ISO15099::System system_type,
+                           double theta = 0,
+                           double phi = 0,
+                           size_t number_of_threads = 1) const;
+
         WCE_Optical_Results optical_method_results(std::string const & method_name,
                                                    double theta = 0,
                                                    double phi = 0) const;
@@ -101,10 +137,40 @@ namespace wincalc
 
         double relative_heat_gain(double theta = 0, double phi = 0);
 
+        // All thermal results for both environments from one IGU.  The solar optical results
+        // are calculated once and each environment's Tarcog system is solved once per system
+        // type, instead of once per call as with the individual functions.  Deflection
+        // settings, applied loads and the system size are the same as for the individual
+        // functions, except that deflection is always solved with a single pass whatever
+        // set_deflection_solver_settings asked for, so deflection_u and deflection_shgc report
+        // one pass.
+        Thermal_Report thermal_report(Environments const & u_environment = nfrc_u_environments(),
+                                      Environments const & shgc_environment =
+                                        nfrc_shgc_environments(),
+                                      double theta = 0,
+                                      double phi = 0);
+
+        // The three center of glazing values a CMA calculation needs: the U-factor in
+        // u_environment, the SHGC in shgc_environment and the front direct hemispheric
+        // transmittance for visible_method.  Both environments share one IGU and one set of solar
+        // optical results, each environment only solves the system its value needs, and the
+        // visible calculation only calculates the one property.
+        CMA_Glazing cma_glazing(Environments const & u_environment = nfrc_u_environments(),
+                                Environments const & shgc_environment = nfrc_shgc_environments(),
+                                std::string const & visible_method = "PHOTOPIC",
+                                double theta = 0,
+                                double phi = 0);
+
+        // Stage timings and counters for every calculation run by this system since it was
+        // built or last reset, see instrumentation.h.  All zero unless the library was built
+        // with WINCALC_ENABLE_INSTRUMENTATION.
+        instrumentation::Statistics statistics() const;
+        void reset_statistics();
+
         void optical_standard(window_standards::Optical_Standard const & s);
         window_standards::Optical_Standard optical_standard() const;
 
-        void solid_layers(std::vector<Product_Data_Optical_Thermal> const & layers);
+        void solid_layers(std::vector<Product_Data_Optical_Thermal> layers);
         std::vector<Product_Data_Optical_Thermal> solid_layers() const;
 
         Environments environments() const;
@@ -121,7 +187,19 @@ namespace wincalc
 
 
     protected:
-        std::vector<Product_Data_Optical_Thermal> product_data;
+        // Layers given as parsed OpticsParser products start as placeholders with no optical or
+        // thermal data.  Each part is converted from parsed_layers the first time a calculation
+        // needs it and kept, so building a system does no conversion and optical calculations
+        // never convert thermal data.
+        mutable std::vector<Product_Data_Optical_Thermal> product_data;
+        // Same size as product_data while any layer has not been fully converted, null entries
+        // for layers that were given already converted
+        mutable std::vector<std::shared_ptr<OpticsParser::ProductData>> parsed_layers;
+        // Names of layers given as parsed products, empty for the others.  Only used to label
+        // trace events, see trace.h.
+        std::vector<std::string> product_names;
+        std::vector<Product_Data_Optical_Thermal> const & optical_layer_data() const;
+        std::vector<Product_Data_Optical_Thermal> const & layer_data() const;
         std::vector<Engine_Gap_Info> gap_values;
         window_standards::Optical_Standard standard;
         double width;
@@ -136,8 +214,19 @@ namespace wincalc
         double initial_temperature = 293.15;
         double initial_pressure = 101325;
         std::vector<double> applied_loads;
+        Deflection_Solver_Settings solver_settings;
+        mutable instrumentation::Statistics instrumentation_statistics;
 
         void do_deflection_updates(double theta, double phi);
+        // A system for the given environments with this system's size, loads and deflection
+        // settings.  current_system is not changed.
+        Tarcog::ISO15099::CSystem environment_system(Tarcog::ISO15099::CIGU & igu,
+                                                     Environments const & environments);
+        Thermal_Environment_Results
+          thermal_environment_results(Tarcog::ISO15099::CIGU & igu,
+                                      Environments const & environments,
+                                      std::vector<double> const & layer_solar_absorptances,
+                                      double total_solar_transmittance);
 
         Tarcog::ISO15099::CIGU & get_igu(double theta, double phi);
         Tarcog::ISO15099::CSystem & get_system(double theta, double phi);
@@ -146,9 +235,10 @@ namespace wincalc
         std::optional<Tarcog::ISO15099::CSystem> current_system;
         double last_theta = 0;
         double last_phi = 0;
+        // True when the deflection settings have not been applied to current_system yet
+        bool deflection_updates_needed = true;
         void reset_system();
         void reset_igu();
-        void sort_spectral_data();
 
         window_standards::Optical_Standard_Method get_method(std::string const & method_name) const;
     };
@@ -0,0 +1,198 @@
+#include "instrumentation.h"
+
+namespace wincalc::instrumentation
+{
+    namespace
+    {
+        struct Thread_State
+        {
+            Statistics statistics;
+            // Target of the innermost collector on this thread, see Scoped_Collector
+            Statistics const * collecting = nullptr;
+        };
+
+        Thread_State & thread_state()
+        {
+            thread_local Thread_State state;
+            return state;
+        }
+    }   // namespace
+
+    std::string_view name(Stage stage)
+    {
+        switch(stage)
+        {
+            case Stage::CREATE_MATERIAL:
+                return "create_material";
+            case Stage::CREATE_BSDF_LAYER:
+                return "create_bsdf_layer";
+            case Stage::CREATE_MULTI_PANE:
+                return "create_multi_pane";
+            case Stage::OPTICAL_CALCULATION:
+                return "optical_calculation";
+            case Stage::THERMAL_IR:
+                return "thermal_ir";
+            case Stage::CREATE_IGU:
+                return "create_igu";
+            case Stage::TARCOG_SOLVE:
+                return "tarcog_solve";
+            case Stage::COUNT:
+                break;
+        }
+        return "unknown";
+    }
+
+    std::string_view name(Counter counter)
+    {
+        switch(counter)
+        {
+            case Counter::TARCOG_QUERIES:
+                return "tarcog_queries";
+            case Counter::TARCOG_ITERATIONS:
+                return "tarcog_iterations";
+            case Counter::IGU_CACHE_HIT:
+                return "igu_cache_hit";
+            case Counter::IGU_CACHE_MISS:
+                return "igu_cache_miss";
+            case Counter::PRODUCT_LIBRARY_CACHE_HIT:
+                return "product_library_cache_hit";
+            case Counter::PRODUCT_LIBRARY_CACHE_MISS:
+                return "product_library_cache_miss";
+            case Counter::OPTICAL_STANDARD_CACHE_HIT:
+                return "optical_standard_cache_hit";
+            case Counter::OPTICAL_STANDARD_CACHE_MISS:
+                return "optical_standard_cache_miss";
+            case Counter::CMA_FRAME_LIBRARY_HIT:
+                return "cma_frame_library_hit";
+            case Counter::CMA_FRAME_LIBRARY_MISS:
+                return "cma_frame_library_miss";
+            case Counter::COUNT:
+                break;
+        }
+        return "unknown";
+    }
+
+    Stage_Statistics const & Statistics::operator[](Stage stage) const
+    {
+        return stages.at(static_cast<size_t>(stage));
+    }
+
+    uint64_t Statistics::operator[](Counter counter) const
+    {
+        return counters.at(static_cast<size_t>(counter));
+    }
+
+    Statistics & Statistics::operator+=(Statistics const & other)
+    {
+        for(size_t i = 0; i < stage_count; ++i)
+        {
+            stages[i].calls += other.stages[i].calls;
+            stages[i].nanoseconds += other.stages[i].nanoseconds;
+            stages[i].allocations += other.stages[i].allocations;
+            stages[i].allocated_bytes += other.stages[i].allocated_bytes;
+        }
+        for(size_t i = 0; i < counter_count; ++i)
+        {
+            counters[i] += other.counters[i];
+        }
+        return *this;
+    }
+
+    Statistics & Statistics::operator-=(Statistics const & other)
+    {
+        for(size_t i = 0; i < stage_count; ++i)
+        {
+            stages[i].calls -= other.stages[i].calls;
+            stages[i].nanoseconds -= other.stages[i].nanoseconds;
+            stages[i].allocations -= other.stages[i].allocations;
+            stages[i].allocated_bytes -= other.stages[i].allocated_bytes;
+        }
+        for(size_t i = 0; i < counter_count; ++i)
+        {
+            counters[i] -= other.counters[i];
+        }
+        return *this;
+    }
+
+    bool enabled()
+    {
+#ifdef WINCALC_ENABLE_INSTRUMENTATION
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    Statistics const & thread_statistics()
+    {
+        return thread_state().statistics;
+    }
+
+    void reset_thread_statistics()
+    {
+        thread_state().statistics = Statistics();
+    }
+
+    void add(Stage stage, uint64_t nanoseconds, Allocations const & allocations)
+    {
+        auto & statistics = thread_state().statistics.stages[static_cast<size_t>(stage)];
+        ++statistics.calls;
+        statistics.nanoseconds += nanoseconds;
+        statistics.allocations += allocations.count;
+        statistics.allocated_bytes += allocations.bytes;
+    }
+
+    void add(Counter counter, uint64_t value)
+    {
+        thread_state().statistics.counters[static_cast<size_t>(counter)] += value;
+    }
+
+    void add(Statistics const & statistics)
+    {
+        thread_state().statistics += statistics;
+    }
+
+    Scoped_Timer::Scoped_Timer(Stage stage) :
+        stage(stage),
+        start(std::chrono::steady_clock::now()),
+        start_allocations(thread_allocations())
+    {}
+
+    Scoped_Timer::~Scoped_Timer()
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        auto allocations = thread_allocations();
+        allocations.count -= start_allocations.count;
+        allocations.bytes -= start_allocations.bytes;
+        add(stage,
+            static_cast<uint64_t>(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+            allocations);
+    }
+
+    Scoped_Collector::Scoped_Collector(Statistics & target) :
+        target(&target),
+        previous_target(thread_state().collecting),
+        start(thread_state().statistics)
+    {
+        if(previous_target == this->target)
+        {
+            this->target = nullptr;
+            return;
+        }
+        thread_state().collecting = this->target;
+    }
+
+    Scoped_Collector::~Scoped_Collector()
+    {
+        if(!target)
+        {
+            return;
+        }
+        auto & state = thread_state();
+        auto recorded = state.statistics;
+        recorded -= start;
+        *target += recorded;
+        state.collecting = previous_target;
+    }
+}   // namespace wincalc::instrumentation
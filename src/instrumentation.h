@@ -0,0 +1,165 @@
+#ifndef WINCALC_INSTRUMENTATION_H_
+#define WINCALC_INSTRUMENTATION_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+// Optional timers and counters around the expensive stages of a calculation.  Built with
+// WINCALC_ENABLE_INSTRUMENTATION defined (the CMake option of the same name) the
+// WINCALC_TIME_STAGE, WINCALC_COUNT and WINCALC_COLLECT_STATISTICS macros record into
+// statistics kept per thread.  Without it the macros expand to nothing and no timing or
+// counting code is compiled; the types and query functions below still exist and report
+// zeros so code using them builds either way.
+//
+// Built with WINCALC_ENABLE_ALLOCATION_PROFILING as well, which the CMake option of the same
+// name turns on together with WINCALC_ENABLE_INSTRUMENTATION, the library replaces the global
+// operator new and delete to count allocations per thread and each stage also records the
+// allocations made while it ran.
+//
+// Statistics are recorded on the thread doing the work.  parallel_for adds the statistics of
+// its worker threads to the thread that called it once they finish, so work split across
+// threads is still attributed to the call that started it.
+
+namespace wincalc::instrumentation
+{
+    enum class Stage
+    {
+        CREATE_MATERIAL,
+        CREATE_BSDF_LAYER,
+        CREATE_MULTI_PANE,
+        OPTICAL_CALCULATION,
+        THERMAL_IR,
+        CREATE_IGU,
+        TARCOG_SOLVE,
+        COUNT
+    };
+
+    enum class Counter
+    {
+        // Tarcog result queries and the solver iterations of the solution each one returned.
+        // Queries of an already solved system do not solve it again but still count the
+        // iterations of that solution.
+        TARCOG_QUERIES,
+        TARCOG_ITERATIONS,
+        // Glazing_System reusing or rebuilding its cached IGU
+        IGU_CACHE_HIT,
+        IGU_CACHE_MISS,
+        PRODUCT_LIBRARY_CACHE_HIT,
+        PRODUCT_LIBRARY_CACHE_MISS,
+        OPTICAL_STANDARD_CACHE_HIT,
+        OPTICAL_STANDARD_CACHE_MISS,
+        CMA_FRAME_LIBRARY_HIT,
+        CMA_FRAME_LIBRARY_MISS,
+        COUNT
+    };
+
+    constexpr size_t stage_count = static_cast<size_t>(Stage::COUNT);
+    constexpr size_t counter_count = static_cast<size_t>(Counter::COUNT);
+
+    std::string_view name(Stage stage);
+    std::string_view name(Counter counter);
+
+    struct Allocations
+    {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    struct Stage_Statistics
+    {
+        // Number of times the stage ran
+        uint64_t calls = 0;
+        // Wall time including any nested stages
+        uint64_t nanoseconds = 0;
+        // Allocations including any nested stages, zero without allocation profiling
+        uint64_t allocations = 0;
+        uint64_t allocated_bytes = 0;
+    };
+
+    struct Statistics
+    {
+        std::array<Stage_Statistics, stage_count> stages{};
+        std::array<uint64_t, counter_count> counters{};
+
+        Stage_Statistics const & operator[](Stage stage) const;
+        uint64_t operator[](Counter counter) const;
+
+        Statistics & operator+=(Statistics const & other);
+        Statistics & operator-=(Statistics const & other);
+    };
+
+    // True if the library was built with WINCALC_ENABLE_INSTRUMENTATION
+    bool enabled();
+
+    // True if the library was built with WINCALC_ENABLE_ALLOCATION_PROFILING
+    bool allocation_profiling_enabled();
+
+    // Allocations made through the global operator new on the calling thread since it started.
+    // Always zero without allocation profiling.  Over-aligned allocations are not counted.
+    Allocations thread_allocations();
+
+    // Everything recorded on the calling thread since it started or was last reset
+    Statistics const & thread_statistics();
+    void reset_thread_statistics();
+
+    // Used by the macros
+    void add(Stage stage, uint64_t nanoseconds, Allocations const & allocations = Allocations());
+    void add(Counter counter, uint64_t value);
+    void add(Statistics const & statistics);
+
+    class Scoped_Timer
+    {
+    public:
+        explicit Scoped_Timer(Stage stage);
+        ~Scoped_Timer();
+
+        Scoped_Timer(Scoped_Timer const &) = delete;
+        Scoped_Timer & operator=(Scoped_Timer const &) = delete;
+
+    private:
+        Stage stage;
+        std::chrono::steady_clock::time_point start;
+        Allocations start_allocations;
+    };
+
+    // Adds everything recorded on this thread while it exists to target.  A collector for a
+    // target that is already collecting on this thread does nothing so nested calls are not
+    // counted twice.
+    class Scoped_Collector
+    {
+    public:
+        explicit Scoped_Collector(Statistics & target);
+        ~Scoped_Collector();
+
+        Scoped_Collector(Scoped_Collector const &) = delete;
+        Scoped_Collector & operator=(Scoped_Collector const &) = delete;
+
+    private:
+        Statistics * target;
+        Statistics const * previous_target;
+        Statistics start;
+    };
+}   // namespace wincalc::instrumentation
+
+#define WINCALC_INSTRUMENTATION_JOIN_(a, b) a##b
+#define WINCALC_INSTRUMENTATION_JOIN(a, b) WINCALC_INSTRUMENTATION_JOIN_(a, b)
+
+#ifdef WINCALC_ENABLE_INSTRUMENTATION
+#    define WINCALC_TIME_STAGE(stage)                                                   \
+        ::wincalc::instrumentation::Scoped_Timer WINCALC_INSTRUMENTATION_JOIN(          \
+          wincalc_stage_timer_, __LINE__)(::wincalc::instrumentation::Stage::stage)
+#    define WINCALC_COUNT(counter, value)                                               \
+        ::wincalc::instrumentation::add(::wincalc::instrumentation::Counter::counter,   \
+                                        static_cast<uint64_t>(value))
+#    define WINCALC_COLLECT_STATISTICS(target)                                          \
+        ::wincalc::instrumentation::Scoped_Collector WINCALC_INSTRUMENTATION_JOIN(      \
+          wincalc_statistics_collector_, __LINE__)(target)
+#else
+#    define WINCALC_TIME_STAGE(stage) static_cast<void>(0)
+#    define WINCALC_COUNT(counter, value) static_cast<void>(0)
+#    define WINCALC_COLLECT_STATISTICS(target) static_cast<void>(0)
+#endif
+
+#endif
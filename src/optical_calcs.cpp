@@ -13,6 +13,8 @@
 #include "create_wce_objects.h"
 #include "util.h"
 #include "thermal_ir.h"
+#include "instrumentation.h"
+#include "trace.h"
 
 namespace wincalc
 {
@@ -224,10 +226,21 @@ namespace wincalc
                std::optional<SingleLayerOptics::CBSDFHemisphere> bsdf_hemisphere,
                Spectal_Data_Wavelength_Range_Method const & type,
                int number_visible_bands,
-               int number_solar_bands)
+               int number_solar_bands,
+               std::vector<bool> const & flipped_layers)
     {
-        auto layers = create_multi_pane(
-          product_data, method, bsdf_hemisphere, type, number_visible_bands, number_solar_bands);
+        WINCALC_TIME_STAGE(OPTICAL_CALCULATION);
+        WINCALC_TRACE_SCOPE_ARGUMENTS("calc_all",
+                                      {"method", method.name},
+                                      {"theta", theta},
+                                      {"phi", phi});
+        auto layers = create_multi_pane(product_data,
+                                        method,
+                                        bsdf_hemisphere,
+                                        type,
+                                        number_visible_bands,
+                                        number_solar_bands,
+                                        flipped_layers);
         std::vector<std::vector<double>> wavelengths = get_wavelengths(product_data);
         auto lambda_range = get_lambda_range(wavelengths, method);
         return calc_all(
@@ -272,14 +285,35 @@ namespace wincalc
                  std::optional<SingleLayerOptics::CBSDFHemisphere> bsdf_hemisphere,
                  Spectal_Data_Wavelength_Range_Method const & type,
                  int number_visible_bands,
-                 int number_solar_bands)
+                 int number_solar_bands,
+                 std::vector<bool> const & flipped_layers)
     {
-        auto layer_x = create_multi_pane(
-          product_data, method_x, bsdf_hemisphere, type, number_visible_bands, number_solar_bands);
-        auto layer_y = create_multi_pane(
-          product_data, method_y, bsdf_hemisphere, type, number_visible_bands, number_solar_bands);
-        auto layer_z = create_multi_pane(
-          product_data, method_z, bsdf_hemisphere, type, number_visible_bands, number_solar_bands);
+        WINCALC_TIME_STAGE(OPTICAL_CALCULATION);
+        WINCALC_TRACE_SCOPE_ARGUMENTS("calc_color",
+                                      {"method", method_x.name},
+                                      {"theta", theta},
+                                      {"phi", phi});
+        auto layer_x = create_multi_pane(product_data,
+                                         method_x,
+                                         bsdf_hemisphere,
+                                         type,
+                                         number_visible_bands,
+                                         number_solar_bands,
+                                         flipped_layers);
+        auto layer_y = create_multi_pane(product_data,
+                                         method_y,
+                                         bsdf_hemisphere,
+                                         type,
+                                         number_visible_bands,
+                                         number_solar_bands,
+                                         flipped_layers);
+        auto layer_z = create_multi_pane(product_data,
+                                         method_z,
+                                         bsdf_hemisphere,
+                                         type,
+                                         number_visible_bands,
+                                         number_solar_bands,
+                                         flipped_layers);
 
         auto x_wavelengths = layer_x->getWavelengths();
         auto y_wavelengths = layer_y->getWavelengths();
@@ -374,6 +408,10 @@ namespace wincalc
       int number_visible_bands,
       int number_solar_bands)
     {
+        WINCALC_TIME_STAGE(OPTICAL_CALCULATION);
+        WINCALC_TRACE_SCOPE_ARGUMENTS("optical_solar_results_needed_for_thermal_calcs",
+                                      {"theta", theta},
+                                      {"phi", phi});
         auto optical_layers = get_optical_layers(product_data);
         auto solar_method = standard.methods.at("SOLAR");
 
@@ -386,7 +424,8 @@ namespace wincalc
                                         bsdf_hemisphere,
                                         type,
                                         number_visible_bands,
-                                        number_solar_bands);
+                                        number_solar_bands,
+                                        get_flipped_layers(product_data));
 
         double t_sol =
           layers->getPropertySimple(lambda_range.min_lambda,
@@ -419,10 +458,21 @@ namespace wincalc
       std::optional<SingleLayerOptics::CBSDFHemisphere> bsdf_hemisphere,
       Spectal_Data_Wavelength_Range_Method const & type,
       int number_visible_bands,
-      int number_solar_bands)
+      int number_solar_bands,
+      std::vector<bool> const & flipped_layers)
     {
-        auto layers = create_multi_pane(
-          product_data, method, bsdf_hemisphere, type, number_visible_bands, number_solar_bands);
+        WINCALC_TIME_STAGE(OPTICAL_CALCULATION);
+        WINCALC_TRACE_SCOPE_ARGUMENTS("calc_optical_property",
+                                      {"method", method.name},
+                                      {"theta", theta},
+                                      {"phi", phi});
+        auto layers = create_multi_pane(product_data,
+                                        method,
+                                        bsdf_hemisphere,
+                                        type,
+                                        number_visible_bands,
+                                        number_solar_bands,
+                                        flipped_layers);
         std::vector<std::vector<double>> wavelengths = get_wavelengths(product_data);
         auto lambda_range = get_lambda_range(wavelengths, method);
 
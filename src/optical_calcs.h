@@ -41,6 +41,8 @@ namespace wincalc
       int number_visible_bands = 5,
       int number_solar_bands = 10);
 
+    // flipped_layers overrides the flipped flag on the product data, one value per layer.  Empty
+    // uses the product data.  Glazing_System passes the orientation of its layers here.
     double
       calc_optical_property(std::vector<std::shared_ptr<Product_Data_Optical>> const & product_data,
                             window_standards::Optical_Standard_Method const & method,
@@ -54,7 +56,8 @@ namespace wincalc
                             Spectal_Data_Wavelength_Range_Method const & type =
                               Spectal_Data_Wavelength_Range_Method::FULL,
                             int number_visible_bands = 5,
-                            int number_solar_bands = 10);
+                            int number_solar_bands = 10,
+                            std::vector<bool> const & flipped_layers = std::vector<bool>());
 
     WCE_Optical_Results
       calc_all(std::vector<std::shared_ptr<Product_Data_Optical>> const & product_data,
@@ -66,7 +69,8 @@ namespace wincalc
                Spectal_Data_Wavelength_Range_Method const & type =
                  Spectal_Data_Wavelength_Range_Method::FULL,
                int number_visible_bands = 5,
-               int number_solar_bands = 10);
+               int number_solar_bands = 10,
+               std::vector<bool> const & flipped_layers = std::vector<bool>());
 
     WCE_Color_Results
       calc_color(std::vector<std::shared_ptr<Product_Data_Optical>> const & product_data,
@@ -80,6 +84,7 @@ namespace wincalc
                  Spectal_Data_Wavelength_Range_Method const & type =
                    Spectal_Data_Wavelength_Range_Method::FULL,
                  int number_visible_bands = 5,
-                 int number_solar_bands = 10);
+                 int number_solar_bands = 10,
+                 std::vector<bool> const & flipped_layers = std::vector<bool>());
 }   // namespace wincalc
 #endif
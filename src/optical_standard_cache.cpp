@@ -0,0 +1,431 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <sstream>
+
+#include "optical_standard_cache.h"
+#include "binary_encoding.h"
+#include "instrumentation.h"
+
+namespace wincalc
+{
+    const uint32_t optical_standard_cache_version = 1;
+
+    namespace
+    {
+        using binary_encoding::Decoder;
+        using binary_encoding::Encoder;
+        using binary_encoding::fnv1a;
+
+        const char cache_magic[4] = {'W', 'C', 'S', 'C'};
+        const uint32_t byte_order_mark = 0x01020304;
+        const size_t header_size = 4 + 4 + 4 + 8 + 8;
+        char const * const cache_description = "Optical standard cache";
+
+        struct Source_File
+        {
+            std::string path;
+            uint64_t size;
+            int64_t modified;
+        };
+
+        std::optional<Source_File> stat_source_file(std::string const & path)
+        {
+            std::error_code error;
+            auto size = std::filesystem::file_size(path, error);
+            if(error)
+            {
+                return std::nullopt;
+            }
+            auto modified = std::filesystem::last_write_time(path, error);
+            if(error)
+            {
+                return std::nullopt;
+            }
+            return Source_File{
+              path, size, static_cast<int64_t>(modified.time_since_epoch().count())};
+        }
+
+        std::string trim(std::string const & text)
+        {
+            size_t begin = 0;
+            size_t end = text.size();
+            while(begin < end && std::isspace(static_cast<unsigned char>(text[begin])))
+            {
+                ++begin;
+            }
+            while(end > begin && std::isspace(static_cast<unsigned char>(text[end - 1])))
+            {
+                --end;
+            }
+            return text.substr(begin, end - begin);
+        }
+
+        void encode_spectrum(Encoder & encoder, window_standards::Spectrum const & spectrum)
+        {
+            encoder.put<uint32_t>(static_cast<uint32_t>(spectrum.type));
+            encoder.put<uint64_t>(spectrum.values.size());
+            for(auto const & value : spectrum.values)
+            {
+                encoder.put<double>(value.first);
+                encoder.put<double>(value.second);
+            }
+            encoder.put<double>(spectrum.t);
+            encoder.put<double>(spectrum.a);
+            encoder.put<double>(spectrum.b);
+        }
+
+        window_standards::Spectrum decode_spectrum(Decoder & decoder)
+        {
+            window_standards::Spectrum spectrum;
+            spectrum.type = static_cast<window_standards::Spectrum_Type>(decoder.get<uint32_t>());
+            auto count = decoder.get<uint64_t>();
+            if(count > (decoder.size - decoder.position) / (2 * sizeof(double)))
+            {
+                decoder.require(decoder.size - decoder.position + 1);
+            }
+            spectrum.values.reserve(count);
+            for(uint64_t i = 0; i < count; ++i)
+            {
+                auto wavelength = decoder.get<double>();
+                auto value = decoder.get<double>();
+                spectrum.values.emplace_back(wavelength, value);
+            }
+            spectrum.t = decoder.get<double>();
+            spectrum.a = decoder.get<double>();
+            spectrum.b = decoder.get<double>();
+            return spectrum;
+        }
+
+        void encode_boundary(Encoder & encoder,
+                             window_standards::Wavelength_Boundary const & boundary)
+        {
+            encoder.put<uint32_t>(static_cast<uint32_t>(boundary.type));
+            encoder.put<double>(boundary.value);
+        }
+
+        window_standards::Wavelength_Boundary decode_boundary(Decoder & decoder)
+        {
+            window_standards::Wavelength_Boundary boundary;
+            boundary.type =
+              static_cast<window_standards::Wavelength_Boundary_Type>(decoder.get<uint32_t>());
+            boundary.value = decoder.get<double>();
+            return boundary;
+        }
+
+        void encode_method(Encoder & encoder,
+                           window_standards::Optical_Standard_Method const & method)
+        {
+            encoder.put_string(method.name);
+            encoder.put_string(method.description);
+            encode_spectrum(encoder, method.source_spectrum);
+            encode_spectrum(encoder, method.detector_spectrum);
+            encoder.put<uint32_t>(static_cast<uint32_t>(method.wavelength_set.type));
+            encoder.put_vector(method.wavelength_set.values);
+            encoder.put<uint32_t>(static_cast<uint32_t>(method.integration_rule.type));
+            encoder.put<double>(method.integration_rule.k);
+            encode_boundary(encoder, method.min_wavelength);
+            encode_boundary(encoder, method.max_wavelength);
+        }
+
+        window_standards::Optical_Standard_Method decode_method(Decoder & decoder)
+        {
+            window_standards::Optical_Standard_Method method;
+            method.name = decoder.get_string();
+            method.description = decoder.get_string();
+            method.source_spectrum = decode_spectrum(decoder);
+            method.detector_spectrum = decode_spectrum(decoder);
+            method.wavelength_set.type =
+              static_cast<window_standards::Wavelength_Set_Type>(decoder.get<uint32_t>());
+            method.wavelength_set.values = decoder.get_vector();
+            method.integration_rule.type =
+              static_cast<window_standards::Integration_Rule_Type>(decoder.get<uint32_t>());
+            method.integration_rule.k = decoder.get<double>();
+            method.min_wavelength = decode_boundary(decoder);
+            method.max_wavelength = decode_boundary(decoder);
+            return method;
+        }
+
+        std::vector<char> encode_cache(window_standards::Optical_Standard const & standard,
+                                       std::vector<Source_File> const & sources)
+        {
+            Encoder body;
+            body.put<uint32_t>(static_cast<uint32_t>(sources.size()));
+            for(auto const & source : sources)
+            {
+                body.put_string(source.path);
+                body.put<uint64_t>(source.size);
+                body.put<int64_t>(source.modified);
+            }
+            body.put_string(standard.name);
+            body.put_string(standard.description);
+            body.put_string(standard.file);
+            body.put<uint64_t>(standard.methods.size());
+            for(auto const & method : standard.methods)
+            {
+                body.put_string(method.first);
+                encode_method(body, method.second);
+            }
+
+            Encoder cache;
+            cache.data.insert(cache.data.end(), cache_magic, cache_magic + sizeof(cache_magic));
+            cache.put<uint32_t>(optical_standard_cache_version);
+            cache.put<uint32_t>(byte_order_mark);
+            cache.put<uint64_t>(body.data.size());
+            cache.put<uint64_t>(fnv1a(body.data.data(), body.data.size()));
+            cache.data.insert(cache.data.end(), body.data.begin(), body.data.end());
+            return cache.data;
+        }
+
+        // Returns nothing if the file does not exist or check_sources is set and a source file
+        // has changed.  If standard_path is given the cache must also have been written for
+        // that .std file, the first source file.  Throws if the file exists but is not a valid
+        // cache.
+        std::optional<window_standards::Optical_Standard>
+          read_cache(std::string const & cache_path,
+                     bool check_sources,
+                     std::string const & standard_path = std::string())
+        {
+            std::ifstream in(cache_path, std::ios::binary | std::ios::ate);
+            if(!in)
+            {
+                return std::nullopt;
+            }
+            std::vector<char> data(static_cast<size_t>(in.tellg()));
+            in.seekg(0);
+            in.read(data.data(), static_cast<std::streamsize>(data.size()));
+            if(!in)
+            {
+                std::stringstream msg;
+                msg << "Error reading optical standard cache " << cache_path;
+                throw std::runtime_error(msg.str());
+            }
+
+            if(data.size() < header_size
+               || std::memcmp(data.data(), cache_magic, sizeof(cache_magic)) != 0)
+            {
+                std::stringstream msg;
+                msg << cache_path << " is not an optical standard cache";
+                throw std::runtime_error(msg.str());
+            }
+            Decoder header(data.data() + sizeof(cache_magic),
+                           header_size - sizeof(cache_magic),
+                           cache_description);
+            auto version = header.get<uint32_t>();
+            auto mark = header.get<uint32_t>();
+            auto body_size = header.get<uint64_t>();
+            auto checksum = header.get<uint64_t>();
+            if(version != optical_standard_cache_version || mark != byte_order_mark)
+            {
+                // Written by a different version or machine, treat it as out of date
+                return std::nullopt;
+            }
+            if(body_size != data.size() - header_size
+               || fnv1a(data.data() + header_size, body_size) != checksum)
+            {
+                std::stringstream msg;
+                msg << "Optical standard cache " << cache_path << " is corrupt";
+                throw std::runtime_error(msg.str());
+            }
+
+            Decoder decoder(data.data() + header_size, body_size, cache_description);
+            auto source_count = decoder.get<uint32_t>();
+            if(!standard_path.empty() && source_count == 0)
+            {
+                return std::nullopt;
+            }
+            for(uint32_t i = 0; i < source_count; ++i)
+            {
+                auto path = decoder.get_string();
+                auto size = decoder.get<uint64_t>();
+                auto modified = decoder.get<int64_t>();
+                if(i == 0 && !standard_path.empty()
+                   && std::filesystem::path(path).lexically_normal()
+                        != std::filesystem::absolute(standard_path).lexically_normal())
+                {
+                    // Written for another standard, or for this one at another location
+                    return std::nullopt;
+                }
+                if(check_sources)
+                {
+                    auto current = stat_source_file(path);
+                    if(!current.has_value() || current->size != size
+                       || current->modified != modified)
+                    {
+                        return std::nullopt;
+                    }
+                }
+            }
+
+            window_standards::Optical_Standard standard;
+            standard.name = decoder.get_string();
+            standard.description = decoder.get_string();
+            standard.file = decoder.get_string();
+            auto method_count = decoder.get<uint64_t>();
+            for(uint64_t i = 0; i < method_count; ++i)
+            {
+                auto name = decoder.get_string();
+                standard.methods[name] = decode_method(decoder);
+            }
+            return standard;
+        }
+
+        std::string default_cache_path(std::string const & standard_path,
+                                       std::string const & cache_path)
+        {
+            return cache_path.empty() ? standard_path + ".cache" : cache_path;
+        }
+    }   // namespace
+
+    std::vector<std::string> optical_standard_source_files(std::string const & standard_path)
+    {
+        auto standard = std::filesystem::absolute(standard_path);
+        std::ifstream in(standard);
+        if(!in)
+        {
+            std::stringstream msg;
+            msg << "Unable to open " << standard_path;
+            throw std::runtime_error(msg.str());
+        }
+
+        std::vector<std::string> files{standard.string()};
+        // Referenced files are given relative to the directory of the .std file
+        std::string line;
+        while(std::getline(in, line))
+        {
+            auto separator = line.find(':');
+            if(separator == std::string::npos)
+            {
+                continue;
+            }
+            auto key = trim(line.substr(0, separator));
+            if(key != "Source Spectrum" && key != "Detector Spectrum" && key != "Wavelength Set")
+            {
+                continue;
+            }
+            auto value = trim(line.substr(separator + 1));
+            if(value.empty())
+            {
+                continue;
+            }
+            auto referenced = standard.parent_path() / value;
+            std::error_code error;
+            if(std::filesystem::is_regular_file(referenced, error))
+            {
+                auto path = referenced.lexically_normal().string();
+                if(std::find(files.begin(), files.end(), path) == files.end())
+                {
+                    files.push_back(path);
+                }
+            }
+        }
+        return files;
+    }
+
+    window_standards::Optical_Standard compile_optical_standard(std::string const & standard_path,
+                                                                std::string const & cache_path)
+    {
+        // Record the sources before loading so a file changed while loading makes the cache
+        // out of date rather than silently stale
+        std::vector<Source_File> sources;
+        for(auto const & path : optical_standard_source_files(standard_path))
+        {
+            auto source = stat_source_file(path);
+            if(source.has_value())
+            {
+                sources.push_back(source.value());
+            }
+        }
+
+        auto standard = window_standards::load_optical_standard(standard_path);
+        auto data = encode_cache(standard, sources);
+
+        std::random_device random;
+        auto temporary_path = cache_path + "." + std::to_string(random()) + ".tmp";
+        {
+            std::ofstream out(temporary_path, std::ios::binary | std::ios::trunc);
+            out.write(data.data(), static_cast<std::streamsize>(data.size()));
+            out.close();
+            if(!out)
+            {
+                std::error_code ignored;
+                std::filesystem::remove(temporary_path, ignored);
+                std::stringstream msg;
+                msg << "Error writing optical standard cache " << cache_path;
+                throw std::runtime_error(msg.str());
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary_path, cache_path, error);
+        if(error)
+        {
+            std::error_code ignored;
+            std::filesystem::remove(temporary_path, ignored);
+            std::stringstream msg;
+            msg << "Unable to replace optical standard cache " << cache_path << ": "
+                << error.message();
+            throw std::runtime_error(msg.str());
+        }
+        return standard;
+    }
+
+    bool optical_standard_cache_is_current(std::string const & cache_path)
+    {
+        try
+        {
+            return read_cache(cache_path, true).has_value();
+        }
+        catch(std::exception const &)
+        {
+            return false;
+        }
+    }
+
+    window_standards::Optical_Standard read_optical_standard_cache(std::string const & cache_path)
+    {
+        auto standard = read_cache(cache_path, false);
+        if(!standard.has_value())
+        {
+            std::stringstream msg;
+            msg << "Unable to read optical standard cache " << cache_path;
+            throw std::runtime_error(msg.str());
+        }
+        return standard.value();
+    }
+
+    window_standards::Optical_Standard
+      load_optical_standard_cached(std::string const & standard_path,
+                                   std::string const & cache_path)
+    {
+        auto path = default_cache_path(standard_path, cache_path);
+        try
+        {
+            auto cached = read_cache(path, true, standard_path);
+            if(cached.has_value())
+            {
+                WINCALC_COUNT(OPTICAL_STANDARD_CACHE_HIT, 1);
+                return cached.value();
+            }
+        }
+        catch(std::exception const &)
+        {
+            // An invalid cache is rebuilt below
+        }
+        WINCALC_COUNT(OPTICAL_STANDARD_CACHE_MISS, 1);
+
+        try
+        {
+            return compile_optical_standard(standard_path, path);
+        }
+        catch(std::exception const &)
+        {
+            // Still usable without a cache, e.g. if the cache directory is read only.  Errors
+            // in the standard itself are reported by loading it again.
+            return window_standards::load_optical_standard(standard_path);
+        }
+    }
+}   // namespace wincalc
@@ -0,0 +1,53 @@
+#ifndef WINCALC_OPTICAL_STANDARD_CACHE_H_
+#define WINCALC_OPTICAL_STANDARD_CACHE_H_
+
+#include <string>
+#include <vector>
+
+#include <windows_standards/windows_standard.h>
+
+namespace wincalc
+{
+    // Binary cache of a loaded optical standard.  load_optical_standard reads the .std file and
+    // every spectrum and wavelength set file it references.  The cache stores the result in
+    // one file that is read with a single read and decoded without any text parsing.  The
+    // Optical_Standard it returns is the same as the one load_optical_standard returns and
+    // can be passed straight to a Glazing_System.
+    //
+    // The cache records the path, size and modification time of the .std file and each file
+    // it references.  A cache is only used while all of those still match, and
+    // load_optical_standard_cached only uses it for the .std file it was written for.
+    //
+    // Layout, values in the byte order of the machine that wrote the file:
+    //   magic "WCSC", uint32 version, uint32 byte order mark 0x01020304, uint64 body size,
+    //   uint64 body checksum (64-bit FNV-1a), then the body:
+    //     uint32 source file count, per file: path, uint64 size, int64 modification time
+    //     the standard's name, description and file and its methods
+    //   Strings are a uint32 length followed by the bytes.
+
+    extern const uint32_t optical_standard_cache_version;
+
+    // The .std file followed by the files it references that exist, as absolute paths
+    std::vector<std::string> optical_standard_source_files(std::string const & standard_path);
+
+    // Loads the standard from its text files and writes the cache.  The cache is written to a
+    // temporary file and then renamed so processes reading the cache at the same time never
+    // see a partial file.
+    window_standards::Optical_Standard
+      compile_optical_standard(std::string const & standard_path, std::string const & cache_path);
+
+    // True if the cache exists, is valid and none of its source files have changed
+    bool optical_standard_cache_is_current(std::string const & cache_path);
+
+    // Reads a cache without checking its source files
+    window_standards::Optical_Standard read_optical_standard_cache(std::string const & cache_path);
+
+    // Uses the cache if it is current, otherwise loads the text files and updates the cache.
+    // If the cache cannot be written, e.g. a read only directory, the loaded standard is still
+    // returned.  An empty cache_path uses standard_path + ".cache".
+    window_standards::Optical_Standard
+      load_optical_standard_cached(std::string const & standard_path,
+                                   std::string const & cache_path = std::string());
+}   // namespace wincalc
+
+#endif
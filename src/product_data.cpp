@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <cmath>
 #include <sstream>
+#include <stdexcept>
+#include <utility>
 #include "product_data.h"
 #include "create_wce_objects.h"
 #include "util.h"
@@ -44,10 +48,214 @@ namespace wincalc
     }
 
 
+    N_Band_Spectral_Data::N_Band_Spectral_Data(
+      std::vector<OpticsParser::WLData> const & wavelength_data)
+    {
+        // Stable so rows measured at the same wavelength keep their order
+        std::vector<OpticsParser::WLData const *> sorted;
+        sorted.reserve(wavelength_data.size());
+        for(auto const & row : wavelength_data)
+        {
+            // Checked before sorting, which needs comparable wavelengths
+            if(!std::isfinite(row.wavelength))
+            {
+                std::stringstream msg;
+                msg << "N-band spectral data has a wavelength that is not finite: "
+                    << row.wavelength;
+                throw std::runtime_error(msg.str());
+            }
+            sorted.push_back(&row);
+        }
+        std::stable_sort(
+          sorted.begin(),
+          sorted.end(),
+          [](OpticsParser::WLData const * v1, OpticsParser::WLData const * v2) {
+              return v1->wavelength < v2->wavelength;
+          });
+
+        wavelength_column.reserve(sorted.size());
+        row_components.reserve(sorted.size());
+        direct_wavelength_column.reserve(sorted.size());
+        tf_column.reserve(sorted.size());
+        tb_column.reserve(sorted.size());
+        rf_column.reserve(sorted.size());
+        rb_column.reserve(sorted.size());
+        for(auto row : sorted)
+        {
+            uint8_t components = 0;
+            wavelength_column.push_back(row->wavelength);
+            if(row->directComponent.has_value())
+            {
+                auto const & direct = row->directComponent.value();
+                components |= DIRECT;
+                direct_wavelength_column.push_back(row->wavelength);
+                tf_column.push_back(direct.tf);
+                tb_column.push_back(direct.tb);
+                rf_column.push_back(direct.rf);
+                rb_column.push_back(direct.rb);
+            }
+            if(row->diffuseComponent.has_value())
+            {
+                components |= DIFFUSE;
+                diffuse_components.push_back(row->diffuseComponent.value());
+            }
+            if(row->pvComponent.has_value())
+            {
+                components |= PV;
+                pv_wavelength_column.push_back(row->wavelength);
+                eqef_column.push_back(row->pvComponent.value().eqef);
+                eqeb_column.push_back(row->pvComponent.value().eqeb);
+            }
+            row_components.push_back(components);
+        }
+        validate();
+    }
+
+    void N_Band_Spectral_Data::validate() const
+    {
+        auto rows_with = [this](Row_Component component) {
+            return static_cast<size_t>(
+              std::count_if(row_components.begin(), row_components.end(), [&](uint8_t flags) {
+                  return (flags & component) != 0;
+              }));
+        };
+        auto direct_rows = rows_with(DIRECT);
+        auto pv_rows = rows_with(PV);
+        if(row_components.size() != wavelength_column.size()
+           || direct_wavelength_column.size() != direct_rows || tf_column.size() != direct_rows
+           || tb_column.size() != direct_rows || rf_column.size() != direct_rows
+           || rb_column.size() != direct_rows || diffuse_components.size() != rows_with(DIFFUSE)
+           || pv_wavelength_column.size() != pv_rows || eqef_column.size() != pv_rows
+           || eqeb_column.size() != pv_rows)
+        {
+            throw std::runtime_error("N-band spectral data columns do not match its rows");
+        }
+        for(size_t i = 1; i < wavelength_column.size(); ++i)
+        {
+            if(wavelength_column[i] <= wavelength_column[i - 1])
+            {
+                std::stringstream msg;
+                msg << "N-band spectral data has more than one row at wavelength "
+                    << wavelength_column[i];
+                throw std::runtime_error(msg.str());
+            }
+        }
+    }
+
+    size_t N_Band_Spectral_Data::size() const
+    {
+        return wavelength_column.size();
+    }
+
+    std::vector<double> const & N_Band_Spectral_Data::wavelengths() const
+    {
+        return wavelength_column;
+    }
+
+    std::vector<OpticsParser::WLData> N_Band_Spectral_Data::rows() const
+    {
+        std::vector<OpticsParser::WLData> result;
+        result.reserve(size());
+        size_t direct = 0;
+        size_t diffuse = 0;
+        size_t pv = 0;
+        for(size_t i = 0; i < size(); ++i)
+        {
+            auto components = row_components[i];
+            OpticsParser::WLData row(wavelength_column[i], OpticsParser::MeasurementComponent{});
+            row.directComponent.reset();
+            if(components & DIRECT)
+            {
+                row.directComponent = OpticsParser::MeasurementComponent{
+                  tf_column[direct], tb_column[direct], rf_column[direct], rb_column[direct]};
+                ++direct;
+            }
+            if(components & DIFFUSE)
+            {
+                row.diffuseComponent = diffuse_components[diffuse++];
+            }
+            if(components & PV)
+            {
+                row.pvComponent = OpticsParser::PVWavelengthData{eqef_column[pv], eqeb_column[pv]};
+                ++pv;
+            }
+            result.push_back(std::move(row));
+        }
+        return result;
+    }
+
+    std::vector<double> const & N_Band_Spectral_Data::direct_wavelengths() const
+    {
+        return direct_wavelength_column;
+    }
+
+    std::vector<double> const & N_Band_Spectral_Data::tf() const
+    {
+        return tf_column;
+    }
+
+    std::vector<double> const & N_Band_Spectral_Data::tb() const
+    {
+        return tb_column;
+    }
+
+    std::vector<double> const & N_Band_Spectral_Data::rf() const
+    {
+        return rf_column;
+    }
+
+    std::vector<double> const & N_Band_Spectral_Data::rb() const
+    {
+        return rb_column;
+    }
+
+    bool N_Band_Spectral_Data::has_pv() const
+    {
+        return !pv_wavelength_column.empty();
+    }
+
+    std::vector<double> const & N_Band_Spectral_Data::pv_wavelengths() const
+    {
+        return pv_wavelength_column;
+    }
+
+    std::vector<double> const & N_Band_Spectral_Data::eqef() const
+    {
+        return eqef_column;
+    }
+
+    std::vector<double> const & N_Band_Spectral_Data::eqeb() const
+    {
+        return eqeb_column;
+    }
+
     Product_Data_N_Band_Optical::Product_Data_N_Band_Optical(
       FenestrationCommon::MaterialType material_type,
       double thickness_meters,
-      std::vector<OpticsParser::WLData> wavelength_data,
+      std::vector<OpticsParser::WLData> const & wavelength_data,
+      std::optional<CoatedSide> coated_side,
+      std::optional<double> ir_transmittance_front,
+      std::optional<double> ir_transmittance_back,
+      std::optional<double> emissivity_front,
+      std::optional<double> emissivity_back,
+      double permeability_factor,
+      bool flipped) :
+        Product_Data_N_Band_Optical(material_type,
+                                    thickness_meters,
+                                    N_Band_Spectral_Data(wavelength_data),
+                                    coated_side,
+                                    ir_transmittance_front,
+                                    ir_transmittance_back,
+                                    emissivity_front,
+                                    emissivity_back,
+                                    permeability_factor,
+                                    flipped)
+    {}
+
+    Product_Data_N_Band_Optical::Product_Data_N_Band_Optical(
+      FenestrationCommon::MaterialType material_type,
+      double thickness_meters,
+      N_Band_Spectral_Data spectral_data,
       std::optional<CoatedSide> coated_side,
       std::optional<double> ir_transmittance_front,
       std::optional<double> ir_transmittance_back,
@@ -63,19 +271,14 @@ namespace wincalc
                              permeability_factor,
                              flipped),
         material_type(material_type),
-        wavelength_data(wavelength_data),
+        spectral_data(std::move(spectral_data)),
+        wavelength_data(this->spectral_data.rows()),
         coated_side(coated_side)
-    {
-        std::sort(this->wavelength_data.begin(),
-                  this->wavelength_data.end(),
-                  [](OpticsParser::WLData const & v1, OpticsParser::WLData const & v2) {
-                      return v1.wavelength < v2.wavelength;
-                  });
-    }
+    {}
 
-    std::vector<double> Product_Data_N_Band_Optical::wavelengths() const
+    std::vector<double> const & Product_Data_N_Band_Optical::wavelengths() const
     {
-        return get_first_val(wavelength_data);
+        return spectral_data.wavelengths();
     }
 
     Flippable_Solid_Layer::Flippable_Solid_Layer(double thickness_meters, bool flipped) :
@@ -111,7 +314,7 @@ namespace wincalc
     {
         return material_optical_data;
     }
-    std::vector<double> Product_Data_Optical_With_Material::wavelengths() const
+    std::vector<double> const & Product_Data_Optical_With_Material::wavelengths() const
     {
         return material_optical_data->wavelengths();
     }
@@ -182,9 +385,14 @@ namespace wincalc
     Product_Data_Optical_Thermal::Product_Data_Optical_Thermal(
       std::shared_ptr<Product_Data_Optical> optical_data,
       std::shared_ptr<Product_Data_Thermal> thermal_data) :
-        optical_data(optical_data), thermal_data(thermal_data)
+        optical_data(std::move(optical_data)), thermal_data(std::move(thermal_data))
     {}
 
+    bool Product_Data_Optical_Thermal::is_flipped() const
+    {
+        return flipped.value_or(optical_data->flipped);
+    }
+
     Product_Data_Optical_Perforated_Screen::Product_Data_Optical_Perforated_Screen(
       std::shared_ptr<Product_Data_Optical> const & material_optical_data,
       Perforated_Geometry const & geometry) :
@@ -250,14 +458,14 @@ namespace wincalc
     }
 
     Product_Data_Dual_Band_Optical_BSDF::Product_Data_Dual_Band_Optical_BSDF(
-      std::vector<std::vector<double>> const & tf_solar,
-      std::vector<std::vector<double>> const & tb_solar,
-      std::vector<std::vector<double>> const & rf_solar,
-      std::vector<std::vector<double>> const & rb_solar,
-      std::vector<std::vector<double>> const & tf_visible,
-      std::vector<std::vector<double>> const & tb_visible,
-      std::vector<std::vector<double>> const & rf_visible,
-      std::vector<std::vector<double>> const & rb_visible,
+      std::vector<std::vector<double>> tf_solar,
+      std::vector<std::vector<double>> tb_solar,
+      std::vector<std::vector<double>> rf_solar,
+      std::vector<std::vector<double>> rb_solar,
+      std::vector<std::vector<double>> tf_visible,
+      std::vector<std::vector<double>> tb_visible,
+      std::vector<std::vector<double>> rf_visible,
+      std::vector<std::vector<double>> rb_visible,
       SingleLayerOptics::CBSDFHemisphere const & bsdf_hemisphere,
       double thickness_meteres,
       std::optional<double> ir_transmittance_front,
@@ -274,14 +482,14 @@ namespace wincalc
                                        permeability_factor,
                                        flipped),
         bsdf_hemisphere(bsdf_hemisphere),
-        tf_solar(tf_solar),
-        tb_solar(tb_solar),
-        rf_solar(rf_solar),
-        rb_solar(rb_solar),
-        tf_visible(tf_visible),
-        tb_visible(tb_visible),
-        rf_visible(rf_visible),
-        rb_visible(rb_visible)
+        tf_solar(std::move(tf_solar)),
+        tb_solar(std::move(tb_solar)),
+        rf_solar(std::move(rf_solar)),
+        rb_solar(std::move(rb_solar)),
+        tf_visible(std::move(tf_visible)),
+        tb_visible(std::move(tb_visible)),
+        rf_visible(std::move(rf_visible)),
+        rb_visible(std::move(rb_visible))
     {}
 
     std::unique_ptr<EffectiveLayers::EffectiveLayer>
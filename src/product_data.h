@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <optional>
 #include <WCESpectralAveraging.hpp>
 #include <WCESingleLayerOptics.hpp>
@@ -67,7 +68,9 @@ namespace wincalc
         std::optional<double> emissivity_front;
         std::optional<double> emissivity_back;
         double permeability_factor;
-        virtual std::vector<double> wavelengths() const = 0;
+        // Returns a reference to data owned by the product so it can be called as often as
+        // needed without copying.  Valid as long as the product is.
+        virtual std::vector<double> const & wavelengths() const = 0;
         std::optional<OpticsParser::PVPowerProperties> pv_power_properties;
     };
 
@@ -92,9 +95,10 @@ namespace wincalc
         {}
 
 
-        virtual std::vector<double> wavelengths() const override
+        virtual std::vector<double> const & wavelengths() const override
         {
-            return {0.3, 0.32, 0.38, 0.78, 2.5};
+            static const std::vector<double> dual_band_wavelengths{0.3, 0.32, 0.38, 0.78, 2.5};
+            return dual_band_wavelengths;
         }
     };
 
@@ -130,14 +134,14 @@ namespace wincalc
     struct Product_Data_Dual_Band_Optical_BSDF : Product_Data_Dual_Band_Optical
     {
         Product_Data_Dual_Band_Optical_BSDF(
-          std::vector<std::vector<double>> const & tf_solar,
-          std::vector<std::vector<double>> const & tb_solar,
-          std::vector<std::vector<double>> const & rf_solar,
-          std::vector<std::vector<double>> const & rb_solar,
-          std::vector<std::vector<double>> const & tf_visible,
-          std::vector<std::vector<double>> const & tb_visible,
-          std::vector<std::vector<double>> const & rf_visible,
-          std::vector<std::vector<double>> const & rb_visible,
+          std::vector<std::vector<double>> tf_solar,
+          std::vector<std::vector<double>> tb_solar,
+          std::vector<std::vector<double>> rf_solar,
+          std::vector<std::vector<double>> rb_solar,
+          std::vector<std::vector<double>> tf_visible,
+          std::vector<std::vector<double>> tb_visible,
+          std::vector<std::vector<double>> rf_visible,
+          std::vector<std::vector<double>> rb_visible,
           SingleLayerOptics::CBSDFHemisphere const & bsdf_hemisphere,
           double thickness_meteres,
           std::optional<double> ir_transmittance_front = std::optional<double>(),
@@ -175,12 +179,85 @@ namespace wincalc
         NEITHER
     };
 
+    // Measured n-band data stored as one contiguous column per property instead of one
+    // struct per wavelength.  The rows are sorted by wavelength when the object is constructed
+    // and cannot be changed afterwards so the columns can be shared between threads and
+    // handed out by reference.
+    //
+    // Every row is kept, including rows without a direct component.  Those are not used by
+    // the optical calculations but their wavelengths are part of wavelengths(), the same as
+    // when the rows themselves were stored.  Direct and photovoltaic values do not have to be
+    // measured at every wavelength so each has its own wavelength column.  rows() gives the
+    // data back one struct per wavelength.
+    class N_Band_Spectral_Data
+    {
+    public:
+        N_Band_Spectral_Data() = default;
+        // Sorts the rows by wavelength and checks them once.  Throws if a wavelength is not
+        // finite or two rows have the same wavelength.  Rows without a direct component are
+        // kept, using one without direct values is reported when the data is converted.
+        explicit N_Band_Spectral_Data(std::vector<OpticsParser::WLData> const & wavelength_data);
+
+        // Number of rows
+        size_t size() const;
+        // Wavelength of every row
+        std::vector<double> const & wavelengths() const;
+        std::vector<OpticsParser::WLData> rows() const;
+
+        // Direct component of the rows that have one
+        std::vector<double> const & direct_wavelengths() const;
+        std::vector<double> const & tf() const;
+        std::vector<double> const & tb() const;
+        std::vector<double> const & rf() const;
+        std::vector<double> const & rb() const;
+
+        bool has_pv() const;
+        std::vector<double> const & pv_wavelengths() const;
+        std::vector<double> const & eqef() const;
+        std::vector<double> const & eqeb() const;
+
+    private:
+        void validate() const;
+
+        enum Row_Component : uint8_t
+        {
+            DIRECT = 1,
+            DIFFUSE = 2,
+            PV = 4
+        };
+
+        std::vector<double> wavelength_column;
+        // Row_Component flags of each row
+        std::vector<uint8_t> row_components;
+        std::vector<double> direct_wavelength_column;
+        std::vector<double> tf_column;
+        std::vector<double> tb_column;
+        std::vector<double> rf_column;
+        std::vector<double> rb_column;
+        // Only needed to give the rows back
+        std::vector<OpticsParser::MeasurementComponent> diffuse_components;
+        std::vector<double> pv_wavelength_column;
+        std::vector<double> eqef_column;
+        std::vector<double> eqeb_column;
+    };
+
     struct Product_Data_N_Band_Optical : Product_Data_Optical
     {
         Product_Data_N_Band_Optical(
           FenestrationCommon::MaterialType material_type,
           double thickness_meteres,
-          std::vector<OpticsParser::WLData> wavelength_data,
+          std::vector<OpticsParser::WLData> const & wavelength_data,
+          std::optional<CoatedSide> coatedSide = std::optional<CoatedSide>(),
+          std::optional<double> ir_transmittance_front = std::optional<double>(),
+          std::optional<double> ir_transmittance_back = std::optional<double>(),
+          std::optional<double> emissivity_front = std::optional<double>(),
+          std::optional<double> emissivity_back = std::optional<double>(),
+          double permeability_factor = 0,
+          bool flipped = false);
+        Product_Data_N_Band_Optical(
+          FenestrationCommon::MaterialType material_type,
+          double thickness_meteres,
+          N_Band_Spectral_Data spectral_data,
           std::optional<CoatedSide> coatedSide = std::optional<CoatedSide>(),
           std::optional<double> ir_transmittance_front = std::optional<double>(),
           std::optional<double> ir_transmittance_back = std::optional<double>(),
@@ -189,9 +266,13 @@ namespace wincalc
           double permeability_factor = 0,
           bool flipped = false);
         FenestrationCommon::MaterialType material_type;
+        N_Band_Spectral_Data spectral_data;
+        // Deprecated, use spectral_data.  The measured rows sorted by wavelength, kept for code
+        // written before spectral_data.  Calculations only use spectral_data so changing these
+        // rows after construction has no effect.
         std::vector<OpticsParser::WLData> wavelength_data;
         std::optional<CoatedSide> coated_side;
-        virtual std::vector<double> wavelengths() const override;
+        virtual std::vector<double> const & wavelengths() const override;
     };
 
     struct Product_Data_Optical_Thermal
@@ -200,6 +281,12 @@ namespace wincalc
                                      std::shared_ptr<Product_Data_Thermal> thermal_data);
         std::shared_ptr<Product_Data_Optical> optical_data;
         std::shared_ptr<Product_Data_Thermal> thermal_data;
+
+        // Orientation of this layer.  When set it takes precedence over the flipped flag on the
+        // product data so a layer can be flipped without modifying products that may be shared
+        // with other layers and systems.
+        std::optional<bool> flipped;
+        bool is_flipped() const;
     };
 
 
@@ -209,7 +296,7 @@ namespace wincalc
           std::shared_ptr<Product_Data_Optical> const & material_optical_data);
         virtual ~Product_Data_Optical_With_Material() = default;
         virtual std::shared_ptr<Product_Data_Optical> optical_data() override;
-        virtual std::vector<double> wavelengths() const override;
+        virtual std::vector<double> const & wavelengths() const override;
 
         std::shared_ptr<Product_Data_Optical> material_optical_data;
     };
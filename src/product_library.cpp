@@ -0,0 +1,904 @@
+#include <cstring>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+
+#ifdef _WIN32
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN
+#    endif
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+#include "product_library.h"
+#include "binary_encoding.h"
+#include "instrumentation.h"
+
+namespace wincalc
+{
+    const uint32_t product_library_version = 1;
+
+    namespace
+    {
+        const char library_magic[4] = {'W', 'C', 'P', 'L'};
+        const uint32_t byte_order_mark = 0x01020304;
+        const size_t header_size = 48;
+
+        enum class Optical_Record_Type : uint8_t
+        {
+            N_BAND = 1,
+            DUAL_BAND_HEMISPHERIC = 2,
+            DUAL_BAND_BSDF = 3,
+            PERFECTLY_DIFFUSE = 4,
+            VENETIAN = 5,
+            WOVEN = 6,
+            PERFORATED = 7
+        };
+
+        using binary_encoding::Decoder;
+        using binary_encoding::Encoder;
+        using binary_encoding::fnv1a;
+
+        char const * const record_description = "Product library record";
+
+        void encode_pv_power_properties(
+          Encoder & encoder, std::optional<OpticsParser::PVPowerProperties> const & properties)
+        {
+            encoder.put_bool(properties.has_value());
+            if(!properties.has_value())
+            {
+                return;
+            }
+            encoder.put<uint64_t>(properties.value().size());
+            for(auto const & entry : properties.value())
+            {
+                encoder.put<double>(entry.first);
+                encoder.put<uint64_t>(entry.second.size());
+                for(auto const & value : entry.second)
+                {
+                    encoder.put<double>(value.jsc);
+                    encoder.put<double>(value.voc);
+                    encoder.put<double>(value.ff);
+                }
+            }
+        }
+
+        std::optional<OpticsParser::PVPowerProperties> decode_pv_power_properties(Decoder & decoder)
+        {
+            if(!decoder.get_bool())
+            {
+                return std::optional<OpticsParser::PVPowerProperties>();
+            }
+            OpticsParser::PVPowerProperties properties;
+            auto count = decoder.get<uint64_t>();
+            for(uint64_t i = 0; i < count; ++i)
+            {
+                auto key = decoder.get<double>();
+                auto value_count = decoder.get<uint64_t>();
+                auto & values = properties[key];
+                for(uint64_t j = 0; j < value_count; ++j)
+                {
+                    auto jsc = decoder.get<double>();
+                    auto voc = decoder.get<double>();
+                    auto ff = decoder.get<double>();
+                    values.push_back(OpticsParser::PVPowerProperty{jsc, voc, ff});
+                }
+            }
+            return properties;
+        }
+
+        void encode_measurement(Encoder & encoder,
+                                std::optional<OpticsParser::MeasurementComponent> const & value)
+        {
+            encoder.put_bool(value.has_value());
+            if(value.has_value())
+            {
+                encoder.put<double>(value.value().tf);
+                encoder.put<double>(value.value().tb);
+                encoder.put<double>(value.value().rf);
+                encoder.put<double>(value.value().rb);
+            }
+        }
+
+        std::optional<OpticsParser::MeasurementComponent> decode_measurement(Decoder & decoder)
+        {
+            if(!decoder.get_bool())
+            {
+                return std::optional<OpticsParser::MeasurementComponent>();
+            }
+            auto tf = decoder.get<double>();
+            auto tb = decoder.get<double>();
+            auto rf = decoder.get<double>();
+            auto rb = decoder.get<double>();
+            return OpticsParser::MeasurementComponent{tf, tb, rf, rb};
+        }
+
+        // One entry per measured row so every row, including rows without a direct component,
+        // comes back the same as it was stored
+        void encode_wavelength_data(Encoder & encoder,
+                                    std::vector<OpticsParser::WLData> const & rows)
+        {
+            encoder.put<uint64_t>(rows.size());
+            for(auto const & row : rows)
+            {
+                encoder.put<double>(row.wavelength);
+                encode_measurement(encoder, row.directComponent);
+                encode_measurement(encoder, row.diffuseComponent);
+                encoder.put_bool(row.pvComponent.has_value());
+                if(row.pvComponent.has_value())
+                {
+                    encoder.put<double>(row.pvComponent.value().eqef);
+                    encoder.put<double>(row.pvComponent.value().eqeb);
+                }
+            }
+        }
+
+        std::vector<OpticsParser::WLData> decode_wavelength_data(Decoder & decoder)
+        {
+            std::vector<OpticsParser::WLData> rows;
+            auto count = decoder.get<uint64_t>();
+            for(uint64_t i = 0; i < count; ++i)
+            {
+                auto wavelength = decoder.get<double>();
+                OpticsParser::WLData row(wavelength, OpticsParser::MeasurementComponent{});
+                row.directComponent = decode_measurement(decoder);
+                row.diffuseComponent = decode_measurement(decoder);
+                if(decoder.get_bool())
+                {
+                    auto eqef = decoder.get<double>();
+                    auto eqeb = decoder.get<double>();
+                    row.pvComponent = OpticsParser::PVWavelengthData{eqef, eqeb};
+                }
+                rows.push_back(std::move(row));
+            }
+            return rows;
+        }
+
+        // Values every Product_Data_Optical has.  Written for every optical record and
+        // restored after construction since derived constructors do not take all of them.
+        void encode_common_optical(Encoder & encoder, Product_Data_Optical const & optical)
+        {
+            encoder.put<double>(optical.thickness_meters);
+            encoder.put_bool(optical.flipped);
+            encoder.put_optional(optical.ir_transmittance_front);
+            encoder.put_optional(optical.ir_transmittance_back);
+            encoder.put_optional(optical.emissivity_front);
+            encoder.put_optional(optical.emissivity_back);
+            encoder.put<double>(optical.permeability_factor);
+            encode_pv_power_properties(encoder, optical.pv_power_properties);
+        }
+
+        struct Common_Optical_Values
+        {
+            double thickness_meters;
+            bool flipped;
+            std::optional<double> ir_transmittance_front;
+            std::optional<double> ir_transmittance_back;
+            std::optional<double> emissivity_front;
+            std::optional<double> emissivity_back;
+            double permeability_factor;
+            std::optional<OpticsParser::PVPowerProperties> pv_power_properties;
+
+            void apply(Product_Data_Optical & optical) const
+            {
+                optical.thickness_meters = thickness_meters;
+                optical.flipped = flipped;
+                optical.ir_transmittance_front = ir_transmittance_front;
+                optical.ir_transmittance_back = ir_transmittance_back;
+                optical.emissivity_front = emissivity_front;
+                optical.emissivity_back = emissivity_back;
+                optical.permeability_factor = permeability_factor;
+                optical.pv_power_properties = pv_power_properties;
+            }
+        };
+
+        Common_Optical_Values decode_common_optical(Decoder & decoder)
+        {
+            Common_Optical_Values values;
+            values.thickness_meters = decoder.get<double>();
+            values.flipped = decoder.get_bool();
+            values.ir_transmittance_front = decoder.get_optional();
+            values.ir_transmittance_back = decoder.get_optional();
+            values.emissivity_front = decoder.get_optional();
+            values.emissivity_back = decoder.get_optional();
+            values.permeability_factor = decoder.get<double>();
+            values.pv_power_properties = decode_pv_power_properties(decoder);
+            return values;
+        }
+
+        SingleLayerOptics::BSDFBasis bsdf_basis_from_size(size_t size)
+        {
+            switch(size)
+            {
+                case 7:
+                    return SingleLayerOptics::BSDFBasis::Small;
+                case 41:
+                    return SingleLayerOptics::BSDFBasis::Quarter;
+                case 73:
+                    return SingleLayerOptics::BSDFBasis::Half;
+                case 145:
+                    return SingleLayerOptics::BSDFBasis::Full;
+                default:
+                    std::stringstream msg;
+                    msg << "BSDF matrix size " << size << " does not match a Klems basis";
+                    throw std::runtime_error(msg.str());
+            }
+        }
+
+        void encode_optical(Encoder & encoder, std::shared_ptr<Product_Data_Optical> const & optical)
+        {
+            if(!optical)
+            {
+                throw std::runtime_error("Cannot encode a product without optical data");
+            }
+
+            // Check the most derived types first
+            if(auto diffuse =
+                 std::dynamic_pointer_cast<Product_Data_Optical_Perfectly_Diffuse>(optical))
+            {
+                encoder.put<uint8_t>(static_cast<uint8_t>(Optical_Record_Type::PERFECTLY_DIFFUSE));
+                encode_common_optical(encoder, *diffuse);
+                encode_optical(encoder, diffuse->material_optical_data);
+            }
+            else if(auto venetian =
+                      std::dynamic_pointer_cast<Product_Data_Optical_Venetian>(optical))
+            {
+                encoder.put<uint8_t>(static_cast<uint8_t>(Optical_Record_Type::VENETIAN));
+                encode_common_optical(encoder, *venetian);
+                auto const & geometry = venetian->geometry;
+                encoder.put<double>(geometry.slat_tilt);
+                encoder.put<double>(geometry.slat_width);
+                encoder.put<double>(geometry.slat_spacing);
+                encoder.put<double>(geometry.slat_curvature);
+                encoder.put_bool(geometry.is_horizontal);
+                encoder.put<int32_t>(static_cast<int32_t>(geometry.distribution_method));
+                encoder.put<int32_t>(geometry.number_slat_segments);
+                encode_optical(encoder, venetian->material_optical_data);
+            }
+            else if(auto woven = std::dynamic_pointer_cast<Product_Data_Optical_Woven_Shade>(optical))
+            {
+                encoder.put<uint8_t>(static_cast<uint8_t>(Optical_Record_Type::WOVEN));
+                encode_common_optical(encoder, *woven);
+                encoder.put<double>(woven->geometry.thread_diameter);
+                encoder.put<double>(woven->geometry.thread_spacing);
+                encoder.put<double>(woven->geometry.shade_thickness);
+                encode_optical(encoder, woven->material_optical_data);
+            }
+            else if(auto perforated =
+                      std::dynamic_pointer_cast<Product_Data_Optical_Perforated_Screen>(optical))
+            {
+                encoder.put<uint8_t>(static_cast<uint8_t>(Optical_Record_Type::PERFORATED));
+                encode_common_optical(encoder, *perforated);
+                auto const & geometry = perforated->geometry;
+                encoder.put<double>(geometry.spacing_x);
+                encoder.put<double>(geometry.spacing_y);
+                encoder.put<double>(geometry.dimension_x);
+                encoder.put<double>(geometry.dimension_y);
+                encoder.put<int32_t>(static_cast<int32_t>(geometry.perforation_type));
+                encode_optical(encoder, perforated->material_optical_data);
+            }
+            else if(auto bsdf =
+                      std::dynamic_pointer_cast<Product_Data_Dual_Band_Optical_BSDF>(optical))
+            {
+                encoder.put<uint8_t>(static_cast<uint8_t>(Optical_Record_Type::DUAL_BAND_BSDF));
+                encode_common_optical(encoder, *bsdf);
+                // Fails here rather than when reading if the basis is not supported
+                bsdf_basis_from_size(bsdf->tf_solar.size());
+                encoder.put_matrix(bsdf->tf_solar);
+                encoder.put_matrix(bsdf->tb_solar);
+                encoder.put_matrix(bsdf->rf_solar);
+                encoder.put_matrix(bsdf->rb_solar);
+                encoder.put_matrix(bsdf->tf_visible);
+                encoder.put_matrix(bsdf->tb_visible);
+                encoder.put_matrix(bsdf->rf_visible);
+                encoder.put_matrix(bsdf->rb_visible);
+            }
+            else if(auto hemispheric =
+                      std::dynamic_pointer_cast<Product_Data_Dual_Band_Optical_Hemispheric>(
+                        optical))
+            {
+                encoder.put<uint8_t>(
+                  static_cast<uint8_t>(Optical_Record_Type::DUAL_BAND_HEMISPHERIC));
+                encode_common_optical(encoder, *hemispheric);
+                encoder.put<double>(hemispheric->tf_solar);
+                encoder.put<double>(hemispheric->tb_solar);
+                encoder.put<double>(hemispheric->rf_solar);
+                encoder.put<double>(hemispheric->rb_solar);
+                encoder.put<double>(hemispheric->tf_visible);
+                encoder.put<double>(hemispheric->tb_visible);
+                encoder.put<double>(hemispheric->rf_visible);
+                encoder.put<double>(hemispheric->rb_visible);
+            }
+            else if(auto n_band = std::dynamic_pointer_cast<Product_Data_N_Band_Optical>(optical))
+            {
+                encoder.put<uint8_t>(static_cast<uint8_t>(Optical_Record_Type::N_BAND));
+                encode_common_optical(encoder, *n_band);
+                encoder.put<int32_t>(static_cast<int32_t>(n_band->material_type));
+                encoder.put_bool(n_band->coated_side.has_value());
+                if(n_band->coated_side.has_value())
+                {
+                    encoder.put<int32_t>(static_cast<int32_t>(n_band->coated_side.value()));
+                }
+                encode_wavelength_data(encoder, n_band->spectral_data.rows());
+            }
+            else
+            {
+                throw std::runtime_error("Product type is not supported by the product library");
+            }
+        }
+
+        std::shared_ptr<Product_Data_Optical> decode_optical(Decoder & decoder)
+        {
+            auto type = static_cast<Optical_Record_Type>(decoder.get<uint8_t>());
+            std::shared_ptr<Product_Data_Optical> optical;
+
+            // Not every constructor takes all of the common values so they are set again
+            // once the object is created.
+            auto common = decode_common_optical(decoder);
+
+            switch(type)
+            {
+                case Optical_Record_Type::PERFECTLY_DIFFUSE: {
+                    auto material = decode_optical(decoder);
+                    optical = std::make_shared<Product_Data_Optical_Perfectly_Diffuse>(material);
+                    break;
+                }
+                case Optical_Record_Type::VENETIAN: {
+                    auto slat_tilt = decoder.get<double>();
+                    auto slat_width = decoder.get<double>();
+                    auto slat_spacing = decoder.get<double>();
+                    auto slat_curvature = decoder.get<double>();
+                    auto is_horizontal = decoder.get_bool();
+                    auto distribution_method =
+                      static_cast<SingleLayerOptics::DistributionMethod>(decoder.get<int32_t>());
+                    auto number_slat_segments = decoder.get<int32_t>();
+                    Venetian_Geometry geometry(slat_tilt,
+                                               slat_width,
+                                               slat_spacing,
+                                               slat_curvature,
+                                               is_horizontal,
+                                               distribution_method,
+                                               number_slat_segments);
+                    auto material = decode_optical(decoder);
+                    optical = std::make_shared<Product_Data_Optical_Venetian>(material, geometry);
+                    break;
+                }
+                case Optical_Record_Type::WOVEN: {
+                    auto thread_diameter = decoder.get<double>();
+                    auto thread_spacing = decoder.get<double>();
+                    auto shade_thickness = decoder.get<double>();
+                    Woven_Geometry geometry(thread_diameter, thread_spacing, shade_thickness);
+                    auto material = decode_optical(decoder);
+                    optical = std::make_shared<Product_Data_Optical_Woven_Shade>(material, geometry);
+                    break;
+                }
+                case Optical_Record_Type::PERFORATED: {
+                    auto spacing_x = decoder.get<double>();
+                    auto spacing_y = decoder.get<double>();
+                    auto dimension_x = decoder.get<double>();
+                    auto dimension_y = decoder.get<double>();
+                    auto perforation_type =
+                      static_cast<Perforated_Geometry::Type>(decoder.get<int32_t>());
+                    Perforated_Geometry geometry(
+                      spacing_x, spacing_y, dimension_x, dimension_y, perforation_type);
+                    auto material = decode_optical(decoder);
+                    optical =
+                      std::make_shared<Product_Data_Optical_Perforated_Screen>(material, geometry);
+                    break;
+                }
+                case Optical_Record_Type::DUAL_BAND_BSDF: {
+                    auto tf_solar = decoder.get_matrix();
+                    auto tb_solar = decoder.get_matrix();
+                    auto rf_solar = decoder.get_matrix();
+                    auto rb_solar = decoder.get_matrix();
+                    auto tf_visible = decoder.get_matrix();
+                    auto tb_visible = decoder.get_matrix();
+                    auto rf_visible = decoder.get_matrix();
+                    auto rb_visible = decoder.get_matrix();
+                    auto hemisphere = SingleLayerOptics::CBSDFHemisphere::create(
+                      bsdf_basis_from_size(tf_solar.size()));
+                    optical = std::make_shared<Product_Data_Dual_Band_Optical_BSDF>(
+                      std::move(tf_solar),
+                      std::move(tb_solar),
+                      std::move(rf_solar),
+                      std::move(rb_solar),
+                      std::move(tf_visible),
+                      std::move(tb_visible),
+                      std::move(rf_visible),
+                      std::move(rb_visible),
+                      hemisphere,
+                      common.thickness_meters);
+                    break;
+                }
+                case Optical_Record_Type::DUAL_BAND_HEMISPHERIC: {
+                    auto tf_solar = decoder.get<double>();
+                    auto tb_solar = decoder.get<double>();
+                    auto rf_solar = decoder.get<double>();
+                    auto rb_solar = decoder.get<double>();
+                    auto tf_visible = decoder.get<double>();
+                    auto tb_visible = decoder.get<double>();
+                    auto rf_visible = decoder.get<double>();
+                    auto rb_visible = decoder.get<double>();
+                    optical = std::make_shared<Product_Data_Dual_Band_Optical_Hemispheric>(
+                      tf_solar,
+                      tb_solar,
+                      rf_solar,
+                      rb_solar,
+                      tf_visible,
+                      tb_visible,
+                      rf_visible,
+                      rb_visible,
+                      common.thickness_meters);
+                    break;
+                }
+                case Optical_Record_Type::N_BAND: {
+                    auto material_type =
+                      static_cast<FenestrationCommon::MaterialType>(decoder.get<int32_t>());
+                    std::optional<CoatedSide> coated_side;
+                    if(decoder.get_bool())
+                    {
+                        coated_side = static_cast<CoatedSide>(decoder.get<int32_t>());
+                    }
+                    auto wavelength_data = decode_wavelength_data(decoder);
+                    optical = std::make_shared<Product_Data_N_Band_Optical>(
+                      material_type, common.thickness_meters, wavelength_data, coated_side);
+                    break;
+                }
+                default: {
+                    std::stringstream msg;
+                    msg << "Unknown optical record type " << static_cast<int>(type)
+                        << " in product library";
+                    throw std::runtime_error(msg.str());
+                }
+            }
+            common.apply(*optical);
+            return optical;
+        }
+
+        void encode_thermal(Encoder & encoder, std::shared_ptr<Product_Data_Thermal> const & thermal)
+        {
+            encoder.put_bool(thermal != nullptr);
+            if(!thermal)
+            {
+                return;
+            }
+            encoder.put_optional(thermal->conductivity);
+            encoder.put<double>(thermal->thickness_meters);
+            encoder.put_bool(thermal->flipped);
+            encoder.put<double>(thermal->opening_top);
+            encoder.put<double>(thermal->opening_bottom);
+            encoder.put<double>(thermal->opening_left);
+            encoder.put<double>(thermal->opening_right);
+            encoder.put<double>(thermal->opening_front);
+            encoder.put_optional(thermal->youngs_modulus);
+            encoder.put_optional(thermal->density);
+        }
+
+        std::shared_ptr<Product_Data_Thermal> decode_thermal(Decoder & decoder)
+        {
+            if(!decoder.get_bool())
+            {
+                return nullptr;
+            }
+            auto conductivity = decoder.get_optional();
+            auto thickness = decoder.get<double>();
+            auto flipped = decoder.get_bool();
+            auto opening_top = decoder.get<double>();
+            auto opening_bottom = decoder.get<double>();
+            auto opening_left = decoder.get<double>();
+            auto opening_right = decoder.get<double>();
+            auto opening_front = decoder.get<double>();
+            auto thermal = std::make_shared<Product_Data_Thermal>(conductivity,
+                                                                  thickness,
+                                                                  flipped,
+                                                                  opening_top,
+                                                                  opening_bottom,
+                                                                  opening_left,
+                                                                  opening_right,
+                                                                  opening_front);
+            thermal->youngs_modulus = decoder.get_optional();
+            thermal->density = decoder.get_optional();
+            return thermal;
+        }
+
+        struct Header
+        {
+            uint32_t version;
+            uint64_t count;
+            uint64_t index_offset;
+            uint64_t index_size;
+            uint64_t index_checksum;
+        };
+
+        std::vector<char> encode_header(Header const & header)
+        {
+            Encoder encoder;
+            encoder.data.insert(encoder.data.end(), library_magic, library_magic + 4);
+            encoder.put<uint32_t>(header.version);
+            encoder.put<uint32_t>(byte_order_mark);
+            encoder.put<uint32_t>(0);
+            encoder.put<uint64_t>(header.count);
+            encoder.put<uint64_t>(header.index_offset);
+            encoder.put<uint64_t>(header.index_size);
+            encoder.put<uint64_t>(header.index_checksum);
+            return encoder.data;
+        }
+
+        Header decode_header(char const * data, size_t size, std::string const & path)
+        {
+            if(size < header_size || std::memcmp(data, library_magic, 4) != 0)
+            {
+                std::stringstream msg;
+                msg << path << " is not a wincalc product library";
+                throw std::runtime_error(msg.str());
+            }
+            Decoder decoder(data + 4, header_size - 4, record_description);
+            Header header;
+            header.version = decoder.get<uint32_t>();
+            if(decoder.get<uint32_t>() != byte_order_mark)
+            {
+                std::stringstream msg;
+                msg << path << " was written on a machine with a different byte order";
+                throw std::runtime_error(msg.str());
+            }
+            if(header.version != product_library_version)
+            {
+                std::stringstream msg;
+                msg << path << " is product library version " << header.version
+                    << " but only version " << product_library_version << " is supported";
+                throw std::runtime_error(msg.str());
+            }
+            decoder.get<uint32_t>();
+            header.count = decoder.get<uint64_t>();
+            header.index_offset = decoder.get<uint64_t>();
+            header.index_size = decoder.get<uint64_t>();
+            header.index_checksum = decoder.get<uint64_t>();
+            return header;
+        }
+    }   // namespace
+
+    std::vector<char> encode_product(Product_Data_Optical_Thermal const & product)
+    {
+        Encoder encoder;
+        encode_optical(encoder, product.optical_data);
+        encode_thermal(encoder, product.thermal_data);
+        return encoder.data;
+    }
+
+    Product_Data_Optical_Thermal decode_product(char const * data, size_t size)
+    {
+        Decoder decoder(data, size, record_description);
+        auto optical = decode_optical(decoder);
+        auto thermal = decode_thermal(decoder);
+        if(decoder.position != size)
+        {
+            throw std::runtime_error("Product library record has unexpected trailing data");
+        }
+        return Product_Data_Optical_Thermal(optical, thermal);
+    }
+
+    Product_Library_Writer::Product_Library_Writer(std::string const & path) :
+        path(path), out(path, std::ios::binary | std::ios::trunc), offset(header_size)
+    {
+        if(!out)
+        {
+            std::stringstream msg;
+            msg << "Unable to open " << path << " for writing";
+            throw std::runtime_error(msg.str());
+        }
+        // Placeholder header, rewritten by finish once the index location is known
+        std::vector<char> header(header_size, 0);
+        out.write(header.data(), header.size());
+    }
+
+    Product_Library_Writer::~Product_Library_Writer()
+    {
+        if(!finished)
+        {
+            try
+            {
+                finish();
+            }
+            catch(...)
+            {}
+        }
+    }
+
+    void Product_Library_Writer::add(std::string const & id,
+                                     Product_Data_Optical_Thermal const & product)
+    {
+        if(finished)
+        {
+            throw std::runtime_error("Cannot add products to a finished product library");
+        }
+        if(ids.count(id))
+        {
+            std::stringstream msg;
+            msg << "Duplicate product id " << id << " in product library " << path;
+            throw std::runtime_error(msg.str());
+        }
+        auto record = encode_product(product);
+        out.write(record.data(), record.size());
+        if(!out)
+        {
+            std::stringstream msg;
+            msg << "Error writing product " << id << " to " << path;
+            throw std::runtime_error(msg.str());
+        }
+        ids[id] = index.size();
+        index.push_back({id, offset, record.size(), fnv1a(record.data(), record.size())});
+        offset += record.size();
+    }
+
+    void Product_Library_Writer::finish()
+    {
+        if(finished)
+        {
+            return;
+        }
+        finished = true;
+
+        Encoder encoder;
+        for(auto const & entry : index)
+        {
+            encoder.put_string(entry.id);
+            encoder.put<uint64_t>(entry.offset);
+            encoder.put<uint64_t>(entry.size);
+            encoder.put<uint64_t>(entry.checksum);
+        }
+        out.write(encoder.data.data(), encoder.data.size());
+
+        Header header{product_library_version,
+                      index.size(),
+                      offset,
+                      encoder.data.size(),
+                      fnv1a(encoder.data.data(), encoder.data.size())};
+        auto header_data = encode_header(header);
+        out.seekp(0);
+        out.write(header_data.data(), header_data.size());
+        out.close();
+        if(!out)
+        {
+            std::stringstream msg;
+            msg << "Error writing product library " << path;
+            throw std::runtime_error(msg.str());
+        }
+    }
+
+    void write_product_library(
+      std::string const & path,
+      std::vector<std::pair<std::string, Product_Data_Optical_Thermal>> const & products)
+    {
+        Product_Library_Writer writer(path);
+        for(auto const & product : products)
+        {
+            writer.add(product.first, product.second);
+        }
+        writer.finish();
+    }
+
+    struct Product_Library::Mapped_File
+    {
+        char const * data = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#endif
+
+        explicit Mapped_File(std::string const & path)
+        {
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(),
+                               GENERIC_READ,
+                               FILE_SHARE_READ,
+                               nullptr,
+                               OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL,
+                               nullptr);
+            if(file == INVALID_HANDLE_VALUE)
+            {
+                throw_open_error(path);
+            }
+            LARGE_INTEGER file_size;
+            if(!GetFileSizeEx(file, &file_size))
+            {
+                CloseHandle(file);
+                throw_open_error(path);
+            }
+            size = static_cast<size_t>(file_size.QuadPart);
+            if(size > 0)
+            {
+                mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if(!mapping)
+                {
+                    CloseHandle(file);
+                    throw_open_error(path);
+                }
+                data = static_cast<char const *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                if(!data)
+                {
+                    CloseHandle(mapping);
+                    CloseHandle(file);
+                    throw_open_error(path);
+                }
+            }
+#else
+            int fd = open(path.c_str(), O_RDONLY);
+            if(fd < 0)
+            {
+                throw_open_error(path);
+            }
+            struct stat file_stat;
+            if(fstat(fd, &file_stat) != 0)
+            {
+                close(fd);
+                throw_open_error(path);
+            }
+            size = static_cast<size_t>(file_stat.st_size);
+            if(size > 0)
+            {
+                void * mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if(mapped == MAP_FAILED)
+                {
+                    close(fd);
+                    throw_open_error(path);
+                }
+                data = static_cast<char const *>(mapped);
+            }
+            // The mapping stays valid after the descriptor is closed
+            close(fd);
+#endif
+        }
+
+        ~Mapped_File()
+        {
+#ifdef _WIN32
+            if(data)
+            {
+                UnmapViewOfFile(data);
+            }
+            if(mapping)
+            {
+                CloseHandle(mapping);
+            }
+            if(file != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(file);
+            }
+#else
+            if(data)
+            {
+                munmap(const_cast<char *>(data), size);
+            }
+#endif
+        }
+
+        Mapped_File(Mapped_File const &) = delete;
+        Mapped_File & operator=(Mapped_File const &) = delete;
+
+        [[noreturn]] static void throw_open_error(std::string const & path)
+        {
+            std::stringstream msg;
+            msg << "Unable to open product library " << path;
+            throw std::runtime_error(msg.str());
+        }
+    };
+
+    Product_Library::Product_Library(std::string const & path) :
+        file(std::make_unique<Mapped_File>(path)), path(path)
+    {
+        auto header = decode_header(file->data, file->size, path);
+        if(header.index_offset > file->size
+           || header.index_size > file->size - header.index_offset)
+        {
+            std::stringstream msg;
+            msg << "Product library " << path << " is truncated";
+            throw std::runtime_error(msg.str());
+        }
+        char const * index_data = file->data + header.index_offset;
+        if(fnv1a(index_data, header.index_size) != header.index_checksum)
+        {
+            std::stringstream msg;
+            msg << "Product library " << path << " index checksum does not match";
+            throw std::runtime_error(msg.str());
+        }
+
+        Decoder decoder(index_data, header.index_size, record_description);
+        for(uint64_t i = 0; i < header.count; ++i)
+        {
+            auto id = decoder.get_string();
+            Record record;
+            record.offset = decoder.get<uint64_t>();
+            record.size = decoder.get<uint64_t>();
+            record.checksum = decoder.get<uint64_t>();
+            if(record.offset < header_size || record.offset > header.index_offset
+               || record.size > header.index_offset - record.offset)
+            {
+                std::stringstream msg;
+                msg << "Product library " << path << " has an invalid record for product " << id;
+                throw std::runtime_error(msg.str());
+            }
+            records[id] = record;
+        }
+    }
+
+    Product_Library::~Product_Library() = default;
+
+    size_t Product_Library::size() const
+    {
+        return records.size();
+    }
+
+    std::vector<std::string> Product_Library::ids() const
+    {
+        std::vector<std::string> result;
+        for(auto const & record : records)
+        {
+            result.push_back(record.first);
+        }
+        return result;
+    }
+
+    bool Product_Library::contains(std::string const & id) const
+    {
+        return records.count(id) > 0;
+    }
+
+    Product_Data_Optical_Thermal Product_Library::product(std::string const & id) const
+    {
+        auto record_itr = records.find(id);
+        if(record_itr == records.end())
+        {
+            std::stringstream msg;
+            msg << "Product library " << path << " does not contain product " << id;
+            throw std::runtime_error(msg.str());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            auto cached = cache.find(id);
+            if(cached != cache.end())
+            {
+                WINCALC_COUNT(PRODUCT_LIBRARY_CACHE_HIT, 1);
+                return cached->second;
+            }
+        }
+        WINCALC_COUNT(PRODUCT_LIBRARY_CACHE_MISS, 1);
+
+        // Checked and decoded without the lock so threads loading different products do not
+        // wait for each other.  Two threads decoding the same product both get the copy
+        // inserted first.
+
+        auto const & record = record_itr->second;
+        char const * record_data = file->data + record.offset;
+        if(fnv1a(record_data, record.size) != record.checksum)
+        {
+            std::stringstream msg;
+            msg << "Product library " << path << " checksum does not match for product " << id;
+            throw std::runtime_error(msg.str());
+        }
+        auto product = decode_product(record_data, record.size);
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        return cache.emplace(id, std::move(product)).first->second;
+    }
+
+    std::vector<Product_Data_Optical_Thermal>
+      Product_Library::products(std::vector<std::string> const & ids) const
+    {
+        std::vector<Product_Data_Optical_Thermal> result;
+        for(auto const & id : ids)
+        {
+            result.push_back(product(id));
+        }
+        return result;
+    }
+}   // namespace wincalc
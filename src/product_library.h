@@ -0,0 +1,115 @@
+#ifndef WINCALC_PRODUCT_LIBRARY_H_
+#define WINCALC_PRODUCT_LIBRARY_H_
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "product_data.h"
+
+namespace wincalc
+{
+    // Binary library of converted products.  Products are stored after conversion so opening
+    // a library does no JSON or XML parsing, and each product is only decoded the first time
+    // it is asked for.
+    //
+    // Layout, values in the byte order of the machine that wrote the file.  Files written on
+    // a machine with a different byte order are rejected using the byte order mark:
+    //   header  magic "WCPL", uint32 version, uint32 byte order mark 0x01020304,
+    //           uint32 reserved, uint64 product count, uint64 index offset,
+    //           uint64 index size, uint64 index checksum
+    //   records one encoded Product_Data_Optical_Thermal per product
+    //   index   per product: uint32 id length, id bytes, uint64 record offset,
+    //           uint64 record size, uint64 record checksum
+    // Checksums are 64-bit FNV-1a.  The index checksum is checked when the library is opened
+    // and each record checksum when that record is decoded.
+    //
+    // Supported products are N-band, dual-band hemispheric and dual-band BSDF optical data,
+    // perfectly diffuse, venetian, woven and perforated shades and their thermal data.
+    // BSDF data must use one of the Klems bases.
+
+    extern const uint32_t product_library_version;
+
+    // Encodes a single product.  Exposed mostly for tests and other containers.
+    std::vector<char> encode_product(Product_Data_Optical_Thermal const & product);
+    Product_Data_Optical_Thermal decode_product(char const * data, size_t size);
+
+    class Product_Library_Writer
+    {
+    public:
+        explicit Product_Library_Writer(std::string const & path);
+        ~Product_Library_Writer();
+
+        Product_Library_Writer(Product_Library_Writer const &) = delete;
+        Product_Library_Writer & operator=(Product_Library_Writer const &) = delete;
+
+        // Records are written as they are added so memory use does not grow with the number
+        // of products.  IDs must be unique.
+        void add(std::string const & id, Product_Data_Optical_Thermal const & product);
+
+        // Writes the index and header.  Called by the destructor if not called explicitly but
+        // errors are only reported when called explicitly.
+        void finish();
+
+    private:
+        struct Index_Entry
+        {
+            std::string id;
+            uint64_t offset;
+            uint64_t size;
+            uint64_t checksum;
+        };
+
+        std::string path;
+        std::ofstream out;
+        uint64_t offset;
+        std::vector<Index_Entry> index;
+        std::map<std::string, size_t> ids;
+        bool finished = false;
+    };
+
+    void write_product_library(
+      std::string const & path,
+      std::vector<std::pair<std::string, Product_Data_Optical_Thermal>> const & products);
+
+    // Read-only view of a library file.  The file is memory mapped and products are decoded
+    // on first use and then cached, so repeated lookups share the same product objects.
+    // Safe to use from multiple threads.
+    class Product_Library
+    {
+    public:
+        explicit Product_Library(std::string const & path);
+        ~Product_Library();
+
+        Product_Library(Product_Library const &) = delete;
+        Product_Library & operator=(Product_Library const &) = delete;
+
+        size_t size() const;
+        std::vector<std::string> ids() const;
+        bool contains(std::string const & id) const;
+        Product_Data_Optical_Thermal product(std::string const & id) const;
+        std::vector<Product_Data_Optical_Thermal>
+          products(std::vector<std::string> const & ids) const;
+
+    private:
+        struct Record
+        {
+            uint64_t offset;
+            uint64_t size;
+            uint64_t checksum;
+        };
+
+        struct Mapped_File;
+        std::unique_ptr<Mapped_File> file;
+        std::string path;
+        std::map<std::string, Record> records;
+        mutable std::mutex cache_mutex;
+        mutable std::map<std::string, Product_Data_Optical_Thermal> cache;
+    };
+}   // namespace wincalc
+
+#endif
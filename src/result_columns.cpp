@@ -0,0 +1,612 @@
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+
+#include "result_columns.h"
+
+namespace wincalc
+{
+    const uint32_t result_columns_version = 1;
+
+    namespace
+    {
+        const char result_columns_magic[4] = {'W', 'C', 'R', 'T'};
+        const uint32_t byte_order_mark = 0x01020304;
+
+        template<typename T>
+        void write_value(std::ofstream & out, T value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Can only write POD values");
+            out.write(reinterpret_cast<char const *>(&value), sizeof(T));
+        }
+
+        template<typename T>
+        void write_array(std::ofstream & out, std::vector<T> const & values)
+        {
+            if(!values.empty())
+            {
+                out.write(reinterpret_cast<char const *>(values.data()),
+                          static_cast<std::streamsize>(values.size() * sizeof(T)));
+            }
+        }
+
+        struct Reader
+        {
+            std::vector<char> data;
+            size_t position = 0;
+            std::string path;
+
+            bool at_end() const
+            {
+                return position == data.size();
+            }
+
+            void require(size_t count)
+            {
+                if(count > data.size() - position)
+                {
+                    std::stringstream msg;
+                    msg << "Result file " << path << " is truncated: needed " << count
+                        << " bytes at offset " << position << " of " << data.size();
+                    throw std::runtime_error(msg.str());
+                }
+            }
+
+            template<typename T>
+            T get()
+            {
+                require(sizeof(T));
+                T value;
+                std::memcpy(&value, data.data() + position, sizeof(T));
+                position += sizeof(T);
+                return value;
+            }
+
+            template<typename T>
+            void get_array(std::vector<T> & values, uint64_t count)
+            {
+                if(count > (data.size() - position) / sizeof(T))
+                {
+                    require(data.size() - position + 1);
+                }
+                auto start = values.size();
+                values.resize(start + count);
+                if(count > 0)
+                {
+                    std::memcpy(values.data() + start, data.data() + position, count * sizeof(T));
+                }
+                position += count * sizeof(T);
+            }
+        };
+    }   // namespace
+
+    Result_Row::Name Result_Row::Name::then(std::string_view part) const
+    {
+        if(size == sizeof(parts) / sizeof(parts[0]))
+        {
+            throw std::runtime_error("Result column name has too many parts");
+        }
+        Name name = *this;
+        name.parts[name.size++] = part;
+        return name;
+    }
+
+    bool Result_Row::Name::matches(std::string const & name) const
+    {
+        std::string_view rest(name);
+        bool first = true;
+        for(size_t i = 0; i < size; ++i)
+        {
+            if(parts[i].empty())
+            {
+                continue;
+            }
+            if(!first)
+            {
+                if(rest.empty() || rest.front() != '_')
+                {
+                    return false;
+                }
+                rest.remove_prefix(1);
+            }
+            if(rest.substr(0, parts[i].size()) != parts[i])
+            {
+                return false;
+            }
+            rest.remove_prefix(parts[i].size());
+            first = false;
+        }
+        return rest.empty();
+    }
+
+    std::string Result_Row::Name::str() const
+    {
+        std::string name;
+        for(size_t i = 0; i < size; ++i)
+        {
+            if(parts[i].empty())
+            {
+                continue;
+            }
+            if(!name.empty())
+            {
+                name += '_';
+            }
+            name += parts[i];
+        }
+        return name;
+    }
+
+    void Result_Row::clear()
+    {
+        row_values.clear();
+        next = 0;
+    }
+
+    void Result_Row::next_column(Name const & name, bool list, size_t size)
+    {
+        if(next < row_columns.size())
+        {
+            auto & column = row_columns[next];
+            if(column.list != list || !name.matches(column.name))
+            {
+                std::stringstream msg;
+                msg << "Result column " << next << " was " << column.name << " but "
+                    << name.str() << " was added";
+                throw std::runtime_error(msg.str());
+            }
+            column.offset = row_values.size();
+            column.size = size;
+        }
+        else
+        {
+            row_columns.push_back(Column{name.str(), list, row_values.size(), size});
+        }
+        ++next;
+    }
+
+    void Result_Row::add(Name const & name, double value)
+    {
+        next_column(name, false, 1);
+        row_values.push_back(value);
+    }
+
+    void Result_Row::add(Name const & name, std::vector<double> const & values)
+    {
+        next_column(name, true, values.size());
+        row_values.insert(row_values.end(), values.begin(), values.end());
+    }
+
+    void Result_Row::add(std::string_view name, double value)
+    {
+        add(Name().then(name), value);
+    }
+
+    void Result_Row::add(std::string_view name, std::vector<double> const & values)
+    {
+        add(Name().then(name), values);
+    }
+
+    void Result_Row::add(Name const & name, WCE_Optical_Result_Simple<double> const & result)
+    {
+        add(name.then("direct_direct"), result.direct_direct);
+        add(name.then("direct_diffuse"), result.direct_diffuse);
+        add(name.then("diffuse_diffuse"), result.diffuse_diffuse);
+        add(name.then("direct_hemispherical"), result.direct_hemispherical);
+    }
+
+    void Result_Row::add(Name const & name, WCE_Optical_Result_Simple<Color_Result> const & result)
+    {
+        std::pair<std::string_view, Color_Result const *> values[] = {
+          {"direct_direct", &result.direct_direct},
+          {"direct_diffuse", &result.direct_diffuse},
+          {"diffuse_diffuse", &result.diffuse_diffuse},
+          {"direct_hemispherical", &result.direct_hemispherical}};
+        for(auto const & value : values)
+        {
+            auto value_name = name.then(value.first);
+            auto const & color = *value.second;
+            add(value_name.then("X"), color.trichromatic.X);
+            add(value_name.then("Y"), color.trichromatic.Y);
+            add(value_name.then("Z"), color.trichromatic.Z);
+            add(value_name.then("R"), static_cast<double>(color.rgb.R));
+            add(value_name.then("G"), static_cast<double>(color.rgb.G));
+            add(value_name.then("B"), static_cast<double>(color.rgb.B));
+            add(value_name.then("L"), color.lab.L);
+            add(value_name.then("a"), color.lab.a);
+            add(value_name.then("b"), color.lab.b);
+        }
+    }
+
+    void Result_Row::add(std::string_view prefix, WCE_Optical_Results const & results)
+    {
+        auto system = Name().then(prefix).then("system");
+        auto const & system_results = results.system_results;
+        add(system.then("front").then("transmittance"), system_results.front.transmittance);
+        add(system.then("front").then("reflectance"), system_results.front.reflectance);
+        add(system.then("back").then("transmittance"), system_results.back.transmittance);
+        add(system.then("back").then("reflectance"), system_results.back.reflectance);
+
+        // One value per layer in each column
+        std::vector<double> values(results.layer_results.size());
+        auto layer_column = [&](char const * side, char const * field, auto get) {
+            for(size_t i = 0; i < results.layer_results.size(); ++i)
+            {
+                values[i] = get(results.layer_results[i]);
+            }
+            add(Name().then(prefix).then("layer").then(side).then("absorptance").then(field),
+                values);
+        };
+        layer_column("front", "total_direct", [](auto const & l) {
+            return l.front.absorptance.total_direct;
+        });
+        layer_column("front", "total_diffuse", [](auto const & l) {
+            return l.front.absorptance.total_diffuse;
+        });
+        layer_column("front", "heat_direct", [](auto const & l) {
+            return l.front.absorptance.heat_direct;
+        });
+        layer_column("front", "heat_diffuse", [](auto const & l) {
+            return l.front.absorptance.heat_diffuse;
+        });
+        layer_column("front", "electricity_direct", [](auto const & l) {
+            return l.front.absorptance.electricity_direct;
+        });
+        layer_column("front", "electricity_diffuse", [](auto const & l) {
+            return l.front.absorptance.electricity_diffuse;
+        });
+        layer_column("back", "total_direct", [](auto const & l) {
+            return l.back.absorptance.total_direct;
+        });
+        layer_column("back", "total_diffuse", [](auto const & l) {
+            return l.back.absorptance.total_diffuse;
+        });
+        layer_column("back", "heat_direct", [](auto const & l) {
+            return l.back.absorptance.heat_direct;
+        });
+        layer_column("back", "heat_diffuse", [](auto const & l) {
+            return l.back.absorptance.heat_diffuse;
+        });
+        layer_column("back", "electricity_direct", [](auto const & l) {
+            return l.back.absorptance.electricity_direct;
+        });
+        layer_column("back", "electricity_diffuse", [](auto const & l) {
+            return l.back.absorptance.electricity_diffuse;
+        });
+    }
+
+    void Result_Row::add(std::string_view prefix, WCE_Color_Results const & results)
+    {
+        auto system = Name().then(prefix).then("system");
+        auto const & system_results = results.system_results;
+        add(system.then("front").then("transmittance"), system_results.front.transmittance);
+        add(system.then("front").then("reflectance"), system_results.front.reflectance);
+        add(system.then("back").then("transmittance"), system_results.back.transmittance);
+        add(system.then("back").then("reflectance"), system_results.back.reflectance);
+    }
+
+    void Result_Row::add(Name const & name, Deflection_Results const & results)
+    {
+        add(name.then("deflection_max"), results.deflection_max);
+        add(name.then("deflection_mean"), results.deflection_mean);
+        add(name.then("panes_load"), results.panes_load);
+        add(name.then("passes"), static_cast<double>(results.passes));
+        add(name.then("solver_iterations"), static_cast<double>(results.solver_iterations));
+        add(name.then("converged"), results.converged ? 1.0 : 0.0);
+    }
+
+    void Result_Row::add(std::string_view prefix, Deflection_Results const & results)
+    {
+        add(Name().then(prefix), results);
+    }
+
+    void Result_Row::add(Name const & name, Thermal_Environment_Results const & results)
+    {
+        add(name.then("u"), results.u);
+        add(name.then("shgc"), results.shgc);
+        add(name.then("relative_heat_gain"), results.relative_heat_gain);
+        add(name.then("system_effective_conductivity_u"), results.system_effective_conductivity_u);
+        add(name.then("system_effective_conductivity_shgc"),
+            results.system_effective_conductivity_shgc);
+        add(name.then("solid_layers_effective_conductivities_u"),
+            results.solid_layers_effective_conductivities_u);
+        add(name.then("solid_layers_effective_conductivities_shgc"),
+            results.solid_layers_effective_conductivities_shgc);
+        add(name.then("gap_layers_effective_conductivities_u"),
+            results.gap_layers_effective_conductivities_u);
+        add(name.then("gap_layers_effective_conductivities_shgc"),
+            results.gap_layers_effective_conductivities_shgc);
+        add(name.then("layer_temperatures_u"), results.layer_temperatures_u);
+        add(name.then("layer_temperatures_shgc"), results.layer_temperatures_shgc);
+        add(name.then("deflection_u"), results.deflection_u);
+        add(name.then("deflection_shgc"), results.deflection_shgc);
+    }
+
+    void Result_Row::add(std::string_view prefix, Thermal_Environment_Results const & results)
+    {
+        add(Name().then(prefix), results);
+    }
+
+    void Result_Row::add(std::string_view prefix, Thermal_Report const & report)
+    {
+        add(Name().then(prefix).then("u_environment"), report.u_environment);
+        add(Name().then(prefix).then("shgc_environment"), report.shgc_environment);
+    }
+
+    size_t Result_Row::size() const
+    {
+        return next;
+    }
+
+    std::vector<Result_Row::Column> const & Result_Row::columns() const
+    {
+        return row_columns;
+    }
+
+    std::vector<double> const & Result_Row::values() const
+    {
+        return row_values;
+    }
+
+    Result_Column_Writer::Result_Column_Writer(std::string const & path, size_t batch_size) :
+        path(path),
+        out(path, std::ios::binary | std::ios::trunc),
+        batch_size(std::max(batch_size, size_t(1)))
+    {
+        if(!out)
+        {
+            std::stringstream msg;
+            msg << "Unable to open " << path << " for writing";
+            throw std::runtime_error(msg.str());
+        }
+    }
+
+    Result_Column_Writer::~Result_Column_Writer()
+    {
+        if(!finished)
+        {
+            try
+            {
+                finish();
+            }
+            catch(...)
+            {}
+        }
+    }
+
+    void Result_Column_Writer::add(Result_Row const & row)
+    {
+        if(finished)
+        {
+            throw std::runtime_error("Cannot add rows to a finished result file");
+        }
+        auto const & row_columns = row.columns();
+        if(row.size() != row_columns.size())
+        {
+            std::stringstream msg;
+            msg << "Result row only has " << row.size() << " of its " << row_columns.size()
+                << " columns";
+            throw std::runtime_error(msg.str());
+        }
+        if(!header_written)
+        {
+            for(auto const & column : row_columns)
+            {
+                columns.push_back(Column_Buffer{column.name, column.list, {}, {0}});
+            }
+            write_header();
+        }
+        if(row_columns.size() != columns.size())
+        {
+            std::stringstream msg;
+            msg << "Result row has " << row_columns.size() << " columns but " << path << " has "
+                << columns.size();
+            throw std::runtime_error(msg.str());
+        }
+        // Check everything before adding anything so a bad row does not leave the columns
+        // with different numbers of rows
+        for(size_t i = 0; i < columns.size(); ++i)
+        {
+            if(columns[i].list != row_columns[i].list || columns[i].name != row_columns[i].name)
+            {
+                std::stringstream msg;
+                msg << "Result row column " << i << " is " << row_columns[i].name << " but "
+                    << path << " expects " << columns[i].name;
+                throw std::runtime_error(msg.str());
+            }
+        }
+
+        auto const & values = row.values();
+        for(size_t i = 0; i < columns.size(); ++i)
+        {
+            auto & column = columns[i];
+            auto begin = values.begin() + static_cast<std::ptrdiff_t>(row_columns[i].offset);
+            column.values.insert(
+              column.values.end(), begin, begin + static_cast<std::ptrdiff_t>(row_columns[i].size));
+            if(column.list)
+            {
+                column.offsets.push_back(column.values.size());
+            }
+        }
+        ++total_rows;
+        ++batch_rows;
+        if(batch_rows == batch_size)
+        {
+            flush();
+        }
+    }
+
+    size_t Result_Column_Writer::rows() const
+    {
+        return total_rows;
+    }
+
+    void Result_Column_Writer::write_header()
+    {
+        out.write(result_columns_magic, sizeof(result_columns_magic));
+        write_value<uint32_t>(out, result_columns_version);
+        write_value<uint32_t>(out, byte_order_mark);
+        write_value<uint32_t>(out, static_cast<uint32_t>(columns.size()));
+        for(auto const & column : columns)
+        {
+            write_value<uint32_t>(out, static_cast<uint32_t>(column.name.size()));
+            out.write(column.name.data(), static_cast<std::streamsize>(column.name.size()));
+            write_value<uint8_t>(out, column.list ? 1 : 0);
+        }
+        header_written = true;
+    }
+
+    void Result_Column_Writer::flush()
+    {
+        if(batch_rows > 0)
+        {
+            write_value<uint64_t>(out, batch_rows);
+            for(auto & column : columns)
+            {
+                if(column.list)
+                {
+                    write_array(out, column.offsets);
+                    column.offsets.assign(1, 0);
+                }
+                write_array(out, column.values);
+                column.values.clear();
+            }
+            batch_rows = 0;
+        }
+        out.flush();
+        if(!out)
+        {
+            std::stringstream msg;
+            msg << "Error writing result file " << path;
+            throw std::runtime_error(msg.str());
+        }
+    }
+
+    void Result_Column_Writer::finish()
+    {
+        if(finished)
+        {
+            return;
+        }
+        finished = true;
+        if(!header_written)
+        {
+            // No rows were added, still write a valid file with no columns
+            write_header();
+        }
+        flush();
+        out.close();
+        if(!out)
+        {
+            std::stringstream msg;
+            msg << "Error writing result file " << path;
+            throw std::runtime_error(msg.str());
+        }
+    }
+
+    Result_Column const & Result_Table::column(std::string const & name) const
+    {
+        for(auto const & c : columns)
+        {
+            if(c.name == name)
+            {
+                return c;
+            }
+        }
+        std::stringstream msg;
+        msg << "No result column named " << name;
+        throw std::runtime_error(msg.str());
+    }
+
+    Result_Table read_result_columns(std::string const & path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if(!in)
+        {
+            std::stringstream msg;
+            msg << "Unable to open " << path;
+            throw std::runtime_error(msg.str());
+        }
+        Reader reader;
+        reader.path = path;
+        reader.data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+        reader.require(sizeof(result_columns_magic));
+        if(std::memcmp(reader.data.data(), result_columns_magic, sizeof(result_columns_magic))
+           != 0)
+        {
+            std::stringstream msg;
+            msg << path << " is not a WinCalc result file";
+            throw std::runtime_error(msg.str());
+        }
+        reader.position = sizeof(result_columns_magic);
+        auto version = reader.get<uint32_t>();
+        if(version != result_columns_version)
+        {
+            std::stringstream msg;
+            msg << "Unsupported result file version " << version << " in " << path;
+            throw std::runtime_error(msg.str());
+        }
+        if(reader.get<uint32_t>() != byte_order_mark)
+        {
+            std::stringstream msg;
+            msg << "Result file " << path << " was written with a different byte order";
+            throw std::runtime_error(msg.str());
+        }
+
+        Result_Table table;
+        auto column_count = reader.get<uint32_t>();
+        for(uint32_t i = 0; i < column_count; ++i)
+        {
+            auto length = reader.get<uint32_t>();
+            reader.require(length);
+            std::string name(reader.data.data() + reader.position, length);
+            reader.position += length;
+            bool list = reader.get<uint8_t>() != 0;
+            table.columns.push_back(Result_Column{name, list, {}, {}});
+            if(list)
+            {
+                table.columns.back().offsets.push_back(0);
+            }
+        }
+
+        std::vector<uint64_t> offsets;
+        while(!reader.at_end())
+        {
+            auto rows = reader.get<uint64_t>();
+            if(!table.columns.empty() && rows >= reader.data.size())
+            {
+                // Every row needs at least one value per column
+                reader.require(reader.data.size());
+            }
+            for(auto & column : table.columns)
+            {
+                if(!column.list)
+                {
+                    reader.get_array(column.values, rows);
+                    continue;
+                }
+                offsets.clear();
+                reader.get_array(offsets, rows + 1);
+                // Offsets restart at 0 in each batch
+                auto base = column.values.size();
+                for(size_t row = 1; row < offsets.size(); ++row)
+                {
+                    if(offsets[row] < offsets[row - 1])
+                    {
+                        std::stringstream msg;
+                        msg << "Invalid offsets for " << column.name << " in " << path;
+                        throw std::runtime_error(msg.str());
+                    }
+                    column.offsets.push_back(base + offsets[row]);
+                }
+                reader.get_array(column.values, offsets.back());
+            }
+            table.rows += rows;
+        }
+        return table;
+    }
+}   // namespace wincalc
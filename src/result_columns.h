@@ -0,0 +1,163 @@
+#ifndef WINCALC_RESULT_COLUMNS_H_
+#define WINCALC_RESULT_COLUMNS_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "optical_results.h"
+#include "thermal_results.h"
+
+namespace wincalc
+{
+    // Columnar binary output for batch runs.  Each system's results are flattened into a
+    // Result_Row and rows are appended to a Result_Column_Writer, which buffers them by column
+    // and writes each column of a batch of rows with a single write.  Values are never
+    // formatted as text.
+    //
+    // Every column holds doubles.  Scalar columns have one value per row.  List columns have
+    // any number of values per row, e.g. one per layer, and are stored as per-row offsets into
+    // a values array in the same way as Arrow list arrays.
+    //
+    // Layout, values in the byte order of the machine that wrote the file.  Files written on
+    // a machine with a different byte order are rejected using the byte order mark:
+    //   header   magic "WCRT", uint32 version, uint32 byte order mark 0x01020304,
+    //            uint32 column count, then per column: uint32 name length, name bytes,
+    //            uint8 kind (0 scalar, 1 list)
+    //   batches  uint64 row count, then for each column in header order
+    //              scalar: row count float64 values
+    //              list:   row count + 1 uint64 offsets starting at 0, then offsets[row count]
+    //                      float64 values
+    // Batches follow each other until the end of the file.
+
+    extern const uint32_t result_columns_version;
+
+    // Flattened results for one system.  The first row added to a writer fixes the columns and
+    // every later row must add the same columns in the same order.
+    //
+    // Column names are prefix + "_" + field name, e.g. "solar_system_front_transmittance_
+    // direct_direct".  Per layer values are list columns with one value per layer.  A row can
+    // be cleared and reused; it then keeps its column names and only checks them against the
+    // names being added, which avoids building the names again for every system.
+    class Result_Row
+    {
+    public:
+        void clear();
+
+        void add(std::string_view name, double value);
+        void add(std::string_view name, std::vector<double> const & values);
+
+        // Optical matrices are not written
+        void add(std::string_view prefix, WCE_Optical_Results const & results);
+        void add(std::string_view prefix, WCE_Color_Results const & results);
+        void add(std::string_view prefix, Deflection_Results const & results);
+        void add(std::string_view prefix, Thermal_Environment_Results const & results);
+        // Columns are prefixed with prefix + "_u_environment" and prefix + "_shgc_environment"
+        void add(std::string_view prefix, Thermal_Report const & report);
+
+        struct Column
+        {
+            std::string name;
+            bool list;
+            size_t offset;
+            size_t size;
+        };
+        // Number of columns added since the row was last cleared
+        size_t size() const;
+        std::vector<Column> const & columns() const;
+        std::vector<double> const & values() const;
+
+    private:
+        // Column name as the parts joined by "_", empty parts are skipped.  Kept as parts so
+        // the name only has to be built the first time the column is added.
+        struct Name
+        {
+            std::string_view parts[8];
+            size_t size = 0;
+
+            Name then(std::string_view part) const;
+            bool matches(std::string const & name) const;
+            std::string str() const;
+        };
+
+        void next_column(Name const & name, bool list, size_t size);
+        void add(Name const & name, double value);
+        void add(Name const & name, std::vector<double> const & values);
+        void add(Name const & name, WCE_Optical_Result_Simple<double> const & result);
+        void add(Name const & name, WCE_Optical_Result_Simple<Color_Result> const & result);
+        void add(Name const & name, Deflection_Results const & results);
+        void add(Name const & name, Thermal_Environment_Results const & results);
+
+        std::vector<Column> row_columns;
+        std::vector<double> row_values;
+        size_t next = 0;
+    };
+
+    class Result_Column_Writer
+    {
+    public:
+        // Rows are buffered in memory and written batch_size rows at a time
+        explicit Result_Column_Writer(std::string const & path, size_t batch_size = 4096);
+        ~Result_Column_Writer();
+
+        Result_Column_Writer(Result_Column_Writer const &) = delete;
+        Result_Column_Writer & operator=(Result_Column_Writer const &) = delete;
+
+        void add(Result_Row const & row);
+
+        // Number of rows added so far
+        size_t rows() const;
+
+        // Writes any buffered rows.  The file is complete after each flush.
+        void flush();
+
+        // Flushes and closes the file.  Called by the destructor if not called explicitly but
+        // errors are only reported when called explicitly.
+        void finish();
+
+    private:
+        struct Column_Buffer
+        {
+            std::string name;
+            bool list;
+            std::vector<double> values;
+            std::vector<uint64_t> offsets;
+        };
+
+        void write_header();
+
+        std::string path;
+        std::ofstream out;
+        size_t batch_size;
+        size_t total_rows = 0;
+        size_t batch_rows = 0;
+        bool header_written = false;
+        bool finished = false;
+        std::vector<Column_Buffer> columns;
+    };
+
+    // A whole result file read back into memory, e.g. for tests or converting to other formats
+    struct Result_Column
+    {
+        std::string name;
+        bool list;
+        std::vector<double> values;
+        // Only for list columns, rows + 1 entries.  Values for row i are
+        // values[offsets[i]] to values[offsets[i + 1] - 1].
+        std::vector<uint64_t> offsets;
+    };
+
+    struct Result_Table
+    {
+        size_t rows = 0;
+        std::vector<Result_Column> columns;
+
+        Result_Column const & column(std::string const & name) const;
+    };
+
+    Result_Table read_result_columns(std::string const & path);
+}   // namespace wincalc
+
+#endif
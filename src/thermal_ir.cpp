@@ -1,11 +1,15 @@
 #include "thermal_ir.h"
 #include "convert_optics_parser.h"
+#include "instrumentation.h"
+#include "trace.h"
 
 
 wincalc::ThermalIRResults
   wincalc::calc_thermal_ir(window_standards::Optical_Standard const & standard,
                            Product_Data_Optical_Thermal const & product_data)
 {
+    WINCALC_TIME_STAGE(THERMAL_IR);
+    WINCALC_TRACE_SCOPE("calc_thermal_ir");
     auto method = standard.methods.at("THERMAL IR");
     auto bsdf = SingleLayerOptics::CBSDFHemisphere::create(SingleLayerOptics::BSDFBasis::Full);
 
@@ -69,7 +73,7 @@ wincalc::ThermalIRResults
     auto emissivity_back_hemispheric =
       ir_layer.emissivity(FenestrationCommon::Side::Back, polynomial_back);
 
-    if(product_data.optical_data->flipped)
+    if(product_data.is_flipped())
     {
         std::swap(tf, tb);
         std::swap(emissivity_front_hemispheric, emissivity_back_hemispheric);
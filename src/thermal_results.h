@@ -2,6 +2,7 @@
 #define WINCALC_THERMAL_RESULT_H
 
 #include <vector>
+#include "deflection_results.h"
 
 namespace wincalc
 {
@@ -11,5 +12,33 @@ namespace wincalc
         double t_sol;
         std::vector<double> layer_solar_absorptances;
     };
+
+    // Every thermal result for one set of environmental conditions.  Values ending in _u are
+    // for the Tarcog U-value system (no solar) and values ending in _shgc are for the SHGC
+    // system (with solar absorptances).
+    struct Thermal_Environment_Results
+    {
+        double u;
+        double shgc;
+        double relative_heat_gain;
+        double system_effective_conductivity_u;
+        double system_effective_conductivity_shgc;
+        std::vector<double> solid_layers_effective_conductivities_u;
+        std::vector<double> solid_layers_effective_conductivities_shgc;
+        std::vector<double> gap_layers_effective_conductivities_u;
+        std::vector<double> gap_layers_effective_conductivities_shgc;
+        std::vector<double> layer_temperatures_u;
+        std::vector<double> layer_temperatures_shgc;
+        Deflection_Results deflection_u;
+        Deflection_Results deflection_shgc;
+    };
+
+    // Results for the two environments a report needs.  The rated U-factor is
+    // u_environment.u and the rated SHGC is shgc_environment.shgc.
+    struct Thermal_Report
+    {
+        Thermal_Environment_Results u_environment;
+        Thermal_Environment_Results shgc_environment;
+    };
 }   // namespace wincalc
 #endif
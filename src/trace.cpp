@@ -0,0 +1,208 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+#include "trace.h"
+
+namespace wincalc::trace
+{
+    namespace
+    {
+        struct Recorder
+        {
+            std::mutex mutex;
+            std::vector<Event> events;
+            std::chrono::steady_clock::time_point start;
+            std::atomic<bool> recording{false};
+            std::atomic<uint32_t> next_thread{1};
+        };
+
+        Recorder & recorder()
+        {
+            static Recorder instance;
+            return instance;
+        }
+
+        uint32_t thread_number()
+        {
+            thread_local uint32_t number = recorder().next_thread++;
+            return number;
+        }
+
+        void record(char phase, char const * name, Arguments arguments)
+        {
+            auto & state = recorder();
+            auto now = std::chrono::steady_clock::now();
+            auto thread = thread_number();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            double timestamp =
+              std::chrono::duration<double, std::micro>(now - state.start).count();
+            state.events.push_back(Event{phase, name, timestamp, thread, std::move(arguments)});
+        }
+
+        void write_string(std::ostream & output, std::string const & value)
+        {
+            output << '"';
+            for(char c : value)
+            {
+                switch(c)
+                {
+                    case '"':
+                        output << "\\\"";
+                        break;
+                    case '\\':
+                        output << "\\\\";
+                        break;
+                    case '\n':
+                        output << "\\n";
+                        break;
+                    case '\r':
+                        output << "\\r";
+                        break;
+                    case '\t':
+                        output << "\\t";
+                        break;
+                    default:
+                        if(static_cast<unsigned char>(c) < 0x20)
+                        {
+                            char escaped[8];
+                            std::snprintf(
+                              escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                            output << escaped;
+                        }
+                        else
+                        {
+                            output << c;
+                        }
+                }
+            }
+            output << '"';
+        }
+
+        void write_value(std::ostream & output, Argument_Value const & value)
+        {
+            if(auto text = std::get_if<std::string>(&value))
+            {
+                write_string(output, *text);
+            }
+            else if(auto integer = std::get_if<int64_t>(&value))
+            {
+                output << *integer;
+            }
+            else
+            {
+                output << std::get<double>(value);
+            }
+        }
+    }   // namespace
+
+    bool enabled()
+    {
+#ifdef WINCALC_ENABLE_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void start()
+    {
+        auto & state = recorder();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.events.clear();
+        state.start = std::chrono::steady_clock::now();
+        state.recording = enabled();
+    }
+
+    void stop()
+    {
+        recorder().recording = false;
+    }
+
+    bool recording()
+    {
+        return recorder().recording;
+    }
+
+    std::vector<Event> events()
+    {
+        auto & state = recorder();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        return state.events;
+    }
+
+    void write_chrome_trace(std::ostream & stream)
+    {
+        auto recorded = events();
+        // Formatted separately so the caller's stream settings are not changed
+        std::ostringstream output;
+        output.precision(3);
+        output << std::fixed;
+        output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        for(size_t i = 0; i < recorded.size(); ++i)
+        {
+            auto const & event = recorded[i];
+            output << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+            write_string(output, event.name);
+            output << ",\"cat\":\"wincalc\",\"ph\":\"" << event.phase
+                   << "\",\"ts\":" << event.timestamp << ",\"pid\":1,\"tid\":" << event.thread;
+            if(!event.arguments.empty())
+            {
+                output << ",\"args\":{";
+                for(size_t j = 0; j < event.arguments.size(); ++j)
+                {
+                    output << (j == 0 ? "" : ",");
+                    write_string(output, event.arguments[j].first);
+                    output << ':';
+                    write_value(output, event.arguments[j].second);
+                }
+                output << '}';
+            }
+            output << '}';
+        }
+        output << "\n]}\n";
+        stream << output.str();
+    }
+
+    void write_chrome_trace(std::string const & path)
+    {
+        std::ofstream output(path, std::ios::binary);
+        if(!output)
+        {
+            std::stringstream msg;
+            msg << "Unable to open " << path;
+            throw std::runtime_error(msg.str());
+        }
+        write_chrome_trace(output);
+    }
+
+    void begin(char const * name, Arguments arguments)
+    {
+        record('B', name, std::move(arguments));
+    }
+
+    void end(char const * name)
+    {
+        record('E', name, Arguments());
+    }
+
+    Scoped_Event::Scoped_Event(char const * name) : name(name), active(recording())
+    {
+        if(active)
+        {
+            begin(name);
+        }
+    }
+
+    Scoped_Event::~Scoped_Event()
+    {
+        if(active)
+        {
+            end(name);
+        }
+    }
+}   // namespace wincalc::trace
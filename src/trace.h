@@ -0,0 +1,100 @@
+#ifndef WINCALC_TRACE_H_
+#define WINCALC_TRACE_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Timeline of the calculations run while tracing, written as Chrome trace-event JSON that can
+// be opened in Perfetto (ui.perfetto.dev) or chrome://tracing.  Built with
+// WINCALC_ENABLE_TRACING defined (the CMake option of the same name) the WINCALC_TRACE_SCOPE
+// macros record a begin event when the scope is entered and an end event when it is left,
+// but only between start() and stop().  Without it the macros expand to nothing and start()
+// records nothing.
+//
+// Each thread that records an event gets its own track so parallel runs show every worker.
+// Arguments are only built while recording.
+
+namespace wincalc::trace
+{
+    using Argument_Value = std::variant<int64_t, double, std::string>;
+    using Arguments = std::vector<std::pair<std::string, Argument_Value>>;
+
+    struct Event
+    {
+        // 'B' for begin, 'E' for end
+        char phase;
+        std::string name;
+        // Microseconds since start()
+        double timestamp;
+        // Small number unique to the thread that recorded the event
+        uint32_t thread;
+        Arguments arguments;
+    };
+
+    // True if the library was built with WINCALC_ENABLE_TRACING
+    bool enabled();
+
+    // Discards any recorded events and starts recording
+    void start();
+    void stop();
+    bool recording();
+
+    std::vector<Event> events();
+
+    // The recorded events as a trace-event JSON object
+    void write_chrome_trace(std::ostream & output);
+    void write_chrome_trace(std::string const & path);
+
+    // Used by the macros
+    void begin(char const * name, Arguments arguments = Arguments());
+    void end(char const * name);
+
+    class Scoped_Event
+    {
+    public:
+        explicit Scoped_Event(char const * name);
+
+        // make_arguments returns the Arguments of the begin event and is only called while
+        // recording
+        template<typename Make_Arguments>
+        Scoped_Event(char const * name, Make_Arguments && make_arguments) :
+            name(name), active(recording())
+        {
+            if(active)
+            {
+                begin(name, make_arguments());
+            }
+        }
+
+        ~Scoped_Event();
+
+        Scoped_Event(Scoped_Event const &) = delete;
+        Scoped_Event & operator=(Scoped_Event const &) = delete;
+
+    private:
+        char const * name;
+        // An event that began is always ended even if recording stops in between
+        bool active;
+    };
+}   // namespace wincalc::trace
+
+#define WINCALC_TRACE_JOIN_(a, b) a##b
+#define WINCALC_TRACE_JOIN(a, b) WINCALC_TRACE_JOIN_(a, b)
+
+#ifdef WINCALC_ENABLE_TRACING
+#    define WINCALC_TRACE_SCOPE(name) \
+        ::wincalc::trace::Scoped_Event WINCALC_TRACE_JOIN(wincalc_trace_event_, __LINE__)(name)
+// The arguments after name are the (name, value) pairs of a trace::Arguments
+#    define WINCALC_TRACE_SCOPE_ARGUMENTS(name, ...)                                      \
+        ::wincalc::trace::Scoped_Event WINCALC_TRACE_JOIN(wincalc_trace_event_, __LINE__)( \
+          name, [&]() { return ::wincalc::trace::Arguments{__VA_ARGS__}; })
+#else
+#    define WINCALC_TRACE_SCOPE(name) static_cast<void>(0)
+#    define WINCALC_TRACE_SCOPE_ARGUMENTS(name, ...) static_cast<void>(0)
+#endif
+
+#endif
@@ -1,6 +1,10 @@
 #include "util.h"
 #include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
 #include "convert_optics_parser.h"
+#include "instrumentation.h"
 
 namespace wincalc
 {
@@ -17,6 +21,16 @@ namespace wincalc
         return optical_layers;
     }
 
+    std::vector<bool> get_flipped_layers(std::vector<Product_Data_Optical_Thermal> const & layers)
+    {
+        std::vector<bool> flipped_layers;
+        for(auto const & layer : layers)
+        {
+            flipped_layers.push_back(layer.is_flipped());
+        }
+        return flipped_layers;
+    }
+
     std::vector<std::shared_ptr<Product_Data_Thermal>>
       get_thermal_layers(std::vector<Product_Data_Optical_Thermal> const & layers)
     {
@@ -101,4 +115,92 @@ namespace wincalc
 
 		return res;
 	}
+
+    size_t thread_count(size_t number_of_threads, size_t number_of_items)
+    {
+        if(number_of_threads == 0)
+        {
+            number_of_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        return std::max(size_t(1), std::min(number_of_threads, number_of_items));
+    }
+
+    void parallel_for(size_t count,
+                      size_t number_of_threads,
+                      std::function<void(size_t begin, size_t end)> const & work)
+    {
+        if(count == 0)
+        {
+            return;
+        }
+        number_of_threads = thread_count(number_of_threads, count);
+        if(number_of_threads == 1)
+        {
+            work(0, count);
+            return;
+        }
+
+        std::exception_ptr first_error;
+        std::mutex error_mutex;
+#ifdef WINCALC_ENABLE_INSTRUMENTATION
+        // Each worker is a new thread so its statistics are all from its chunk
+        instrumentation::Statistics worker_statistics;
+        std::mutex statistics_mutex;
+        auto chunk = [&work, &worker_statistics, &statistics_mutex](size_t begin, size_t end) {
+            work(begin, end);
+            std::lock_guard<std::mutex> lock(statistics_mutex);
+            worker_statistics += instrumentation::thread_statistics();
+        };
+#else
+        auto const & chunk = work;
+#endif
+        std::vector<std::thread> threads;
+        threads.reserve(number_of_threads);
+        size_t chunk_size = count / number_of_threads;
+        size_t remainder = count % number_of_threads;
+        auto join_all = [&threads]() {
+            for(auto & thread : threads)
+            {
+                thread.join();
+            }
+        };
+        try
+        {
+            size_t begin = 0;
+            for(size_t i = 0; i < number_of_threads; ++i)
+            {
+                size_t end = begin + chunk_size + (i < remainder ? 1 : 0);
+                threads.emplace_back([&chunk, &first_error, &error_mutex, begin, end]() {
+                    try
+                    {
+                        chunk(begin, end);
+                    }
+                    catch(...)
+                    {
+                        std::lock_guard<std::mutex> lock(error_mutex);
+                        if(!first_error)
+                        {
+                            first_error = std::current_exception();
+                        }
+                    }
+                });
+                begin = end;
+            }
+        }
+        catch(...)
+        {
+            // Starting a thread failed.  The threads already started use this frame so they
+            // must finish before the exception leaves it.
+            join_all();
+            throw;
+        }
+        join_all();
+#ifdef WINCALC_ENABLE_INSTRUMENTATION
+        instrumentation::add(worker_statistics);
+#endif
+        if(first_error)
+        {
+            std::rethrow_exception(first_error);
+        }
+    }
 }   // namespace wincalc
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <functional>
 #include <OpticsParser.hpp>
 #include "product_data.h"
 
@@ -10,6 +11,9 @@ namespace wincalc
     std::vector<std::shared_ptr<wincalc::Product_Data_Optical>>
       get_optical_layers(std::vector<wincalc::Product_Data_Optical_Thermal> const & layers);
 
+    // Orientation of each layer, see Product_Data_Optical_Thermal::is_flipped
+    std::vector<bool> get_flipped_layers(std::vector<Product_Data_Optical_Thermal> const & layers);
+
     std::vector<std::shared_ptr<Product_Data_Thermal>>
       get_thermal_layers(std::vector<Product_Data_Optical_Thermal> const & layers);
 
@@ -41,4 +45,16 @@ namespace wincalc
 
     std::vector<std::vector<double>> get_wavelengths(
       std::vector<std::shared_ptr<wincalc::Product_Data_Optical>> const & product_data);
+
+    // Number of threads to use when a caller asks for number_of_threads.  Zero means one per
+    // hardware thread.  Never more than the number of work items.
+    size_t thread_count(size_t number_of_threads, size_t number_of_items);
+
+    // Splits [0, count) into contiguous chunks, one per thread, and calls
+    // work(begin, end) for each chunk.  Chunks are contiguous so neighbouring items are
+    // processed in order by the same thread.  If any chunk throws the first exception
+    // is rethrown on the calling thread after all threads have finished.
+    void parallel_for(size_t count,
+                      size_t number_of_threads,
+                      std::function<void(size_t begin, size_t end)> const & work);
 }   // namespace wincalc
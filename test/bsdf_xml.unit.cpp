@@ -0,0 +1,120 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+
+using namespace wincalc;
+using namespace window_standards;
+
+class TestBSDFXML : public testing::Test
+{
+protected:
+    std::filesystem::path product_path(std::string const & file_name) const
+    {
+        std::filesystem::path path(test_dir);
+        path /= "products";
+        path /= file_name;
+        return path;
+    }
+
+    std::string read_file(std::string const & file_name) const
+    {
+        std::ifstream in(product_path(file_name));
+        std::stringstream contents;
+        contents << in.rdbuf();
+        return contents.str();
+    }
+
+    std::string
+      replace(std::string contents, std::string const & from, std::string const & to) const
+    {
+        auto position = contents.find(from);
+        EXPECT_NE(position, std::string::npos);
+        contents.replace(position, from.size(), to);
+        return contents;
+    }
+};
+
+TEST_F(TestBSDFXML, Same_As_OpticsParser)
+{
+    for(auto const & file_name : {"2011-SA1.XML",
+                                  "2011-SA1_same_solar_and_visible_only_normal.XML",
+                                  "2011-SA45.XML",
+                                  "46016 SEATEX Midnight.xml",
+                                  "CS03_genBSDF.xml",
+                                  "shade_full.xml"})
+    {
+        SCOPED_TRACE(file_name);
+        auto path = product_path(file_name).string();
+        auto expected = convert_to_solid_layer(OpticsParser::parseBSDFXMLFile(path));
+        EXPECT_EQ(encode_product(load_bsdf_xml_file(path)), encode_product(expected));
+        EXPECT_EQ(encode_product(load_bsdf_xml_file(path, 1)), encode_product(expected));
+    }
+}
+
+TEST_F(TestBSDFXML, Same_System_Results)
+{
+    auto path = product_path("2011-SA1.XML").string();
+    std::filesystem::path standard_path(test_dir);
+    standard_path /= "standards";
+    standard_path /= "W5_NFRC_2003.std";
+    auto standard = load_optical_standard(standard_path.string());
+    auto clear_3 = convert_to_solid_layer(
+      OpticsParser::parseJSONFile(product_path("CLEAR_3.json").string()));
+    auto bsdf_hemisphere =
+      SingleLayerOptics::CBSDFHemisphere::create(SingleLayerOptics::BSDFBasis::Quarter);
+    std::vector<Engine_Gap_Info> gaps{Engine_Gap_Info(Gases::GasDef::Air, 0.0127)};
+
+    std::vector<Product_Data_Optical_Thermal> parsed_layers{
+      convert_to_solid_layer(OpticsParser::parseBSDFXMLFile(path)), clear_3};
+    std::vector<Product_Data_Optical_Thermal> loaded_layers{load_bsdf_xml_file(path), clear_3};
+
+    Glazing_System parsed(standard,
+                          parsed_layers,
+                          gaps,
+                          1.0,
+                          1.0,
+                          90,
+                          nfrc_shgc_environments(),
+                          bsdf_hemisphere);
+    Glazing_System loaded(standard,
+                          loaded_layers,
+                          gaps,
+                          1.0,
+                          1.0,
+                          90,
+                          nfrc_shgc_environments(),
+                          bsdf_hemisphere);
+    EXPECT_EQ(parsed.u(), loaded.u());
+    EXPECT_EQ(parsed.shgc(), loaded.shgc());
+}
+
+TEST_F(TestBSDFXML, Errors)
+{
+    auto contents = read_file("2011-SA1.XML");
+    EXPECT_NO_THROW(load_bsdf_xml_string(contents));
+
+    EXPECT_THROW(load_bsdf_xml_file(product_path("does_not_exist.xml").string()),
+                 std::runtime_error);
+    EXPECT_THROW(load_bsdf_xml_string(contents.substr(0, contents.size() / 2)),
+                 std::runtime_error);
+    EXPECT_THROW(load_bsdf_xml_string(replace(contents,
+                                              "<RowAngleBasis>LBNL/Klems Full",
+                                              "<RowAngleBasis>LBNL/Klems Half")),
+                 std::runtime_error);
+    EXPECT_THROW(load_bsdf_xml_string(replace(contents,
+                                              "<WavelengthDataDirection>Transmission Back",
+                                              "<WavelengthDataDirection>Transmission Front")),
+                 std::runtime_error);
+    EXPECT_THROW(
+      load_bsdf_xml_string(replace(contents, "<ScatteringData>", "<ScatteringData>1, ")),
+      std::runtime_error);
+    EXPECT_THROW(
+      load_bsdf_xml_string(replace(contents, "<ScatteringData>", "<ScatteringData>x, ")),
+      std::runtime_error);
+}
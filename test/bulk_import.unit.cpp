@@ -0,0 +1,200 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+
+using namespace wincalc;
+
+class TestBulkImport : public testing::Test
+{
+protected:
+    std::vector<std::string> product_files{
+      "CLEAR_3.json", "igsdb_5051.json", "generic_pv.json", "woven_shade.json"};
+    std::filesystem::path library_path;
+
+    std::filesystem::path product_path(std::string const & file_name) const
+    {
+        std::filesystem::path path(test_dir);
+        path /= "products";
+        path /= file_name;
+        return path;
+    }
+
+    std::string read_file(std::filesystem::path const & path) const
+    {
+        std::ifstream in(path);
+        std::stringstream contents;
+        contents << in.rdbuf();
+        return contents.str();
+    }
+
+    // A JSON array with each test product repeated, like an IGSDB export
+    std::string create_dump(size_t repeats, bool include_invalid = false) const
+    {
+        std::stringstream dump;
+        dump << "[\n";
+        for(size_t i = 0; i < repeats; ++i)
+        {
+            for(size_t j = 0; j < product_files.size(); ++j)
+            {
+                if(i > 0 || j > 0)
+                {
+                    dump << ",\n";
+                }
+                dump << read_file(product_path(product_files[j]));
+            }
+        }
+        if(include_invalid)
+        {
+            dump << ",\n{\"name\": \"Not a product\"}";
+        }
+        dump << "\n]";
+        return dump.str();
+    }
+
+    virtual void SetUp()
+    {
+        library_path = std::filesystem::temp_directory_path() / "wincalc_bulk_import_test.wcpl";
+    }
+
+    virtual void TearDown()
+    {
+        std::filesystem::remove(library_path);
+    }
+};
+
+TEST_F(TestBulkImport, Json_Array_Reader)
+{
+    std::stringstream input(" [ {\"a\": \"x,]}\\\"\"}, [1, 2] ,\n3, \"s\" ] ");
+    Json_Array_Reader reader(input, 4);
+    std::string element;
+    std::vector<std::string> elements;
+    while(reader.next(element))
+    {
+        elements.push_back(element);
+    }
+    std::vector<std::string> expected{"{\"a\": \"x,]}\\\"\"}", "[1, 2]", "3", "\"s\""};
+    EXPECT_EQ(elements, expected);
+    EXPECT_EQ(reader.count(), 4u);
+
+    std::stringstream empty("[]");
+    EXPECT_FALSE(Json_Array_Reader(empty).next(element));
+
+    std::stringstream not_array("{}");
+    EXPECT_THROW(Json_Array_Reader(not_array).next(element), std::runtime_error);
+
+    std::stringstream truncated("[{\"a\": 1}, {\"b\"");
+    Json_Array_Reader truncated_reader(truncated);
+    EXPECT_TRUE(truncated_reader.next(element));
+    EXPECT_THROW(truncated_reader.next(element), std::runtime_error);
+}
+
+TEST_F(TestBulkImport, Same_As_Individual_Conversion)
+{
+    const size_t repeats = 3;
+    std::stringstream input(create_dump(repeats));
+
+    std::vector<std::vector<char>> expected;
+    for(auto const & file : product_files)
+    {
+        expected.push_back(encode_product(
+          convert_to_solid_layer(OpticsParser::parseJSONFile(product_path(file).string()))));
+    }
+
+    std::vector<size_t> indices;
+    Bulk_Import_Options options;
+    options.number_of_threads = 4;
+    options.queue_size = 2;
+    auto summary = import_igsdb_json(
+      input,
+      [&](size_t index,
+          OpticsParser::ProductData const &,
+          Product_Data_Optical_Thermal const & product) {
+          indices.push_back(index);
+          EXPECT_EQ(encode_product(product), expected[index % expected.size()]);
+      },
+      nullptr,
+      options);
+
+    EXPECT_EQ(summary.products, repeats * product_files.size());
+    EXPECT_EQ(summary.converted, repeats * product_files.size());
+    EXPECT_EQ(summary.failed, 0u);
+    // Callbacks are made in input order
+    for(size_t i = 0; i < indices.size(); ++i)
+    {
+        EXPECT_EQ(indices[i], i);
+    }
+}
+
+TEST_F(TestBulkImport, Errors)
+{
+    Bulk_Import_Options options;
+    options.number_of_threads = 2;
+
+    std::stringstream input(create_dump(1, true));
+    std::vector<size_t> failed;
+    auto summary = import_igsdb_json(
+      input,
+      [](size_t, OpticsParser::ProductData const &, Product_Data_Optical_Thermal const &) {},
+      [&failed](size_t index, std::string const &) { failed.push_back(index); },
+      options);
+    EXPECT_EQ(summary.converted, product_files.size());
+    EXPECT_EQ(summary.failed, 1u);
+    EXPECT_EQ(failed, std::vector<size_t>{product_files.size()});
+
+    // Without an error callback the first error stops the import
+    std::stringstream stop_input(create_dump(1, true));
+    EXPECT_ANY_THROW(import_igsdb_json(
+      stop_input,
+      [](size_t, OpticsParser::ProductData const &, Product_Data_Optical_Thermal const &) {},
+      nullptr,
+      options));
+
+    auto ignore_product =
+      [](size_t, OpticsParser::ProductData const &, Product_Data_Optical_Thermal const &) {};
+    auto ignore_error = [](size_t, std::string const &) {};
+    std::stringstream not_array("{\"a\": 1}");
+    EXPECT_THROW(import_igsdb_json(not_array, ignore_product, ignore_error, options),
+                 std::runtime_error);
+}
+
+TEST_F(TestBulkImport, Import_To_Library)
+{
+    auto dump_path = std::filesystem::temp_directory_path() / "wincalc_bulk_import_test.json";
+    {
+        std::ofstream out(dump_path);
+        out << create_dump(2);
+    }
+
+    std::vector<std::string> errors;
+    Bulk_Import_Summary summary;
+    {
+        Product_Library_Writer writer(library_path.string());
+        summary = import_igsdb_json_to_library(
+          dump_path.string(),
+          writer,
+          [&errors](size_t, std::string const & message) { errors.push_back(message); },
+          Bulk_Import_Options{},
+          [](size_t index, OpticsParser::ProductData const & parsed) {
+              return std::to_string(index) + " " + parsed.productName;
+          });
+        writer.finish();
+    }
+    std::filesystem::remove(dump_path);
+
+    EXPECT_TRUE(errors.empty());
+    EXPECT_EQ(summary.converted, 2 * product_files.size());
+
+    Product_Library library(library_path.string());
+    EXPECT_EQ(library.size(), 2 * product_files.size());
+    auto clear_3 =
+      convert_to_solid_layer(OpticsParser::parseJSONFile(product_path("CLEAR_3.json").string()));
+    auto name = OpticsParser::parseJSONFile(product_path("CLEAR_3.json").string())->productName;
+    auto id = "0 " + name;
+    EXPECT_EQ(encode_product(library.product(id)), encode_product(clear_3));
+}
@@ -0,0 +1,93 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <filesystem>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+
+using namespace wincalc;
+
+class TestCMAFrameLibrary : public testing::Test
+{
+protected:
+    std::string top_frame_path;
+    std::string bottom_frame_path;
+    std::string jamb_frame_path;
+    std::string spacer_path;
+
+    virtual void SetUp()
+    {
+        std::filesystem::path products(test_dir);
+        products /= "products";
+
+        top_frame_path = (products / "sample-head_CMA.thmx").string();
+        bottom_frame_path = (products / "sample-sill_CMA.thmx").string();
+        jamb_frame_path = (products / "sample-jamb_CMA.thmx").string();
+        spacer_path = (products / "Spacer_CMA.thmx").string();
+    }
+};
+
+TEST_F(TestCMAFrameLibrary, Same_As_Parsed_Files)
+{
+    double glazing_system_u = 1.25800;
+    double glazing_system_shgc = 0.341;
+    double tvis = 0.53500;
+    double width = 1.2;
+    double height = 1.5;
+
+    auto top_frame = thmxParser::parseFile(top_frame_path);
+    auto bottom_frame = thmxParser::parseFile(bottom_frame_path);
+    auto jamb_frame = thmxParser::parseFile(jamb_frame_path);
+    auto spacer = thmxParser::parseFile(spacer_path);
+
+    auto expected_window = get_cma_window_single_vision(
+      top_frame, bottom_frame, jamb_frame, jamb_frame, width, height);
+    auto expected = calc_cma(
+      expected_window, glazing_system_u, glazing_system_shgc, tvis, get_spacer_keff(spacer));
+
+    CMA_Frame_Library library;
+    auto window = get_cma_window_single_vision(*library.frame(top_frame_path),
+                                               *library.frame(bottom_frame_path),
+                                               *library.frame(jamb_frame_path),
+                                               *library.frame(jamb_frame_path),
+                                               width,
+                                               height);
+    auto results = calc_cma(
+      window, glazing_system_u, glazing_system_shgc, tvis, library.spacer_keff(spacer_path));
+
+    EXPECT_EQ(results.u, expected.u);
+    EXPECT_EQ(results.shgc, expected.shgc);
+    EXPECT_EQ(results.vt, expected.vt);
+    EXPECT_NEAR(results.u, 1.451714, 1e-6);
+    EXPECT_NEAR(results.shgc, 0.299620, 1e-6);
+    EXPECT_NEAR(results.vt, 0.468371, 1e-6);
+}
+
+TEST_F(TestCMAFrameLibrary, Files_Parsed_Once)
+{
+    CMA_Frame_Library library;
+    auto first = library.frame(jamb_frame_path);
+    // The same file through a different path is the same entry
+    std::filesystem::path other_path(jamb_frame_path);
+    other_path = other_path.parent_path() / "." / other_path.filename();
+    auto second = library.frame(other_path.string());
+    EXPECT_EQ(first, second);
+
+    auto keff = library.spacer_keff(spacer_path);
+    EXPECT_EQ(library.spacer_keff(spacer_path), keff);
+    EXPECT_EQ(library.size(), 2u);
+
+    library.clear();
+    EXPECT_EQ(library.size(), 0u);
+    EXPECT_NE(library.frame(jamb_frame_path), first);
+}
+
+TEST_F(TestCMAFrameLibrary, Frame_Without_Options)
+{
+    CMA_Frame_Library library;
+    auto frame = library.frame(jamb_frame_path);
+    CMA_Frame_Data no_options{frame->frame, std::nullopt};
+    EXPECT_THROW(get_cma_window_single_vision(no_options, *frame, *frame, *frame, 1.2, 1.5),
+                 std::runtime_error);
+}
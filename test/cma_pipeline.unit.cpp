@@ -0,0 +1,100 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <filesystem>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+
+using namespace wincalc;
+using namespace window_standards;
+
+class TestCMAPipeline : public testing::Test
+{
+protected:
+    std::vector<std::shared_ptr<Glazing_System>> glazing_systems;
+    CMA_Frame_Library library;
+    std::optional<CMA_Frame_Set> frames;
+    double spacer_keff;
+
+    virtual void SetUp()
+    {
+        std::filesystem::path products(test_dir);
+        products /= "products";
+
+        OpticsParser::Parser parser;
+        auto clear_3 = parser.parseJSONFile((products / "CLEAR_3.json").string());
+
+        std::filesystem::path standard_path(test_dir);
+        standard_path /= "standards";
+        standard_path /= "W5_NFRC_2003.std";
+        Optical_Standard standard = load_optical_standard(standard_path.string());
+
+        std::vector<std::shared_ptr<OpticsParser::ProductData>> single{clear_3};
+        std::vector<std::shared_ptr<OpticsParser::ProductData>> double_clear{clear_3, clear_3};
+        std::vector<Engine_Gap_Info> gaps{Engine_Gap_Info(Gases::GasDef::Air, 0.0127)};
+
+        glazing_systems.push_back(std::make_shared<Glazing_System>(standard, single));
+        glazing_systems.push_back(std::make_shared<Glazing_System>(standard, double_clear, gaps));
+        glazing_systems.push_back(
+          std::make_shared<Glazing_System>(standard, double_clear, gaps, 1.0, 1.0, 45));
+
+        auto top_frame = library.frame((products / "sample-head_CMA.thmx").string());
+        auto bottom_frame = library.frame((products / "sample-sill_CMA.thmx").string());
+        auto jamb_frame = library.frame((products / "sample-jamb_CMA.thmx").string());
+        frames = cma_single_vision_frames(top_frame, bottom_frame, jamb_frame, jamb_frame);
+        spacer_keff = library.spacer_keff((products / "Spacer_CMA.thmx").string());
+    }
+};
+
+TEST_F(TestCMAPipeline, Glazing_Values_Same_As_Separate_Calculations)
+{
+    const double tolerance = 1e-6;
+    for(auto & system : glazing_systems)
+    {
+        auto values = system->cma_glazing();
+
+        system->environments(nfrc_u_environments());
+        EXPECT_NEAR(values.u, system->u(), tolerance);
+        system->environments(nfrc_shgc_environments());
+        EXPECT_NEAR(values.shgc, system->shgc(), tolerance);
+        auto photopic = system->optical_method_results("PHOTOPIC");
+        EXPECT_NEAR(values.visible_front_direct_hemispheric_transmittance,
+                    photopic.system_results.front.transmittance.direct_hemispherical,
+                    tolerance);
+    }
+}
+
+TEST_F(TestCMAPipeline, Table)
+{
+    std::vector<double> spacer_keffs{spacer_keff, 1.0};
+    std::vector<CMA_Window_Size> sizes{{1.2, 1.5}, {0.6, 1.2}};
+
+    auto results = calc_cma_pipeline(glazing_systems, frames.value(), spacer_keffs, sizes, 2);
+    ASSERT_EQ(results.glazings.size(), glazing_systems.size());
+    EXPECT_EQ(results.table.glazings, glazing_systems.size());
+    EXPECT_EQ(results.table.spacers, spacer_keffs.size());
+    EXPECT_EQ(results.table.sizes, sizes.size());
+
+    auto expected_table = calc_cma_table(frames.value(), results.glazings, spacer_keffs, sizes);
+    ASSERT_EQ(results.table.results.size(), expected_table.results.size());
+    for(size_t i = 0; i < expected_table.results.size(); ++i)
+    {
+        EXPECT_EQ(results.table.results[i].u, expected_table.results[i].u);
+        EXPECT_EQ(results.table.results[i].shgc, expected_table.results[i].shgc);
+        EXPECT_EQ(results.table.results[i].vt, expected_table.results[i].vt);
+    }
+
+    for(size_t i = 0; i < glazing_systems.size(); ++i)
+    {
+        auto expected = glazing_systems[i]->cma_glazing();
+        EXPECT_EQ(results.glazings[i].u, expected.u);
+        EXPECT_EQ(results.glazings[i].shgc, expected.shgc);
+        EXPECT_EQ(results.glazings[i].visible_front_direct_hemispheric_transmittance,
+                  expected.visible_front_direct_hemispheric_transmittance);
+    }
+
+    glazing_systems.push_back(nullptr);
+    EXPECT_THROW(calc_cma_pipeline(glazing_systems, frames.value(), spacer_keffs, sizes),
+                 std::runtime_error);
+}
@@ -0,0 +1,100 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <filesystem>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+
+using namespace wincalc;
+
+class TestCMATable : public testing::Test
+{
+protected:
+    CMA_Frame_Library library;
+    std::shared_ptr<CMA_Frame_Data const> top_frame;
+    std::shared_ptr<CMA_Frame_Data const> bottom_frame;
+    std::shared_ptr<CMA_Frame_Data const> jamb_frame;
+    double spacer_keff;
+
+    std::vector<CMA_Glazing> glazings{{1.258, 0.341, 0.535}, {2.8, 0.7, 0.8}, {0.9, 0.25, 0.4}};
+    std::vector<CMA_Window_Size> sizes{{1.2, 1.5}, {0.6, 1.2}, {1.5, 1.2}, {2.0, 2.4}};
+
+    virtual void SetUp()
+    {
+        std::filesystem::path products(test_dir);
+        products /= "products";
+
+        top_frame = library.frame((products / "sample-head_CMA.thmx").string());
+        bottom_frame = library.frame((products / "sample-sill_CMA.thmx").string());
+        jamb_frame = library.frame((products / "sample-jamb_CMA.thmx").string());
+        spacer_keff = library.spacer_keff((products / "Spacer_CMA.thmx").string());
+    }
+
+    void check_table(CMA_Frame_Set const & frames, size_t number_of_threads)
+    {
+        std::vector<double> spacer_keffs{spacer_keff, 0.01, 10.0};
+        auto table = calc_cma_table(frames, glazings, spacer_keffs, sizes, number_of_threads);
+        ASSERT_EQ(table.results.size(), sizes.size() * spacer_keffs.size() * glazings.size());
+
+        for(size_t size = 0; size < sizes.size(); ++size)
+        {
+            for(size_t spacer = 0; spacer < spacer_keffs.size(); ++spacer)
+            {
+                for(size_t glazing = 0; glazing < glazings.size(); ++glazing)
+                {
+                    auto window = frames.window(sizes[size].width, sizes[size].height);
+                    auto expected =
+                      calc_cma(window,
+                               glazings[glazing].u,
+                               glazings[glazing].shgc,
+                               glazings[glazing].visible_front_direct_hemispheric_transmittance,
+                               spacer_keffs[spacer]);
+                    auto const & result = table.at(size, spacer, glazing);
+                    EXPECT_EQ(result.u, expected.u);
+                    EXPECT_EQ(result.shgc, expected.shgc);
+                    EXPECT_EQ(result.vt, expected.vt);
+                }
+            }
+        }
+    }
+};
+
+TEST_F(TestCMATable, Single_Vision)
+{
+    auto frames = cma_single_vision_frames(top_frame, bottom_frame, jamb_frame, jamb_frame);
+    check_table(frames, 1);
+    check_table(frames, 3);
+
+    // Same as Test_CMA_Single_Vision in cma.unit.cpp
+    auto table = calc_cma_table(frames, {glazings[0]}, {spacer_keff}, {sizes[0]});
+    EXPECT_NEAR(table.at(0, 0, 0).u, 1.451714, 1e-6);
+    EXPECT_NEAR(table.at(0, 0, 0).shgc, 0.299620, 1e-6);
+    EXPECT_NEAR(table.at(0, 0, 0).vt, 0.468371, 1e-6);
+}
+
+TEST_F(TestCMATable, Double_Vision)
+{
+    auto vertical = cma_double_vision_vertical_frames(
+      top_frame, bottom_frame, jamb_frame, jamb_frame, jamb_frame, jamb_frame, jamb_frame);
+    check_table(vertical, 2);
+
+    auto horizontal = cma_double_vision_horizontal_frames(
+      top_frame, top_frame, bottom_frame, bottom_frame, jamb_frame, jamb_frame, jamb_frame);
+    check_table(horizontal, 2);
+}
+
+TEST_F(TestCMATable, Empty_And_Out_Of_Range)
+{
+    auto frames = cma_single_vision_frames(top_frame, bottom_frame, jamb_frame, jamb_frame);
+    auto empty = calc_cma_table(frames, glazings, {}, sizes);
+    EXPECT_TRUE(empty.results.empty());
+
+    auto table = calc_cma_table(frames, glazings, {spacer_keff}, sizes);
+    EXPECT_THROW(table.at(sizes.size(), 0, 0), std::out_of_range);
+    EXPECT_THROW(table.at(0, 1, 0), std::out_of_range);
+    EXPECT_THROW(table.at(0, 0, glazings.size()), std::out_of_range);
+
+    EXPECT_THROW(cma_single_vision_frames(top_frame, nullptr, jamb_frame, jamb_frame),
+                 std::runtime_error);
+}
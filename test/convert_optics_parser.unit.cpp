@@ -0,0 +1,82 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <filesystem>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+
+using namespace wincalc;
+
+class TestConvertOpticsParser : public testing::Test
+{
+protected:
+    std::string shade_path;
+
+    std::vector<std::vector<double>> const &
+      solar_tf(std::shared_ptr<OpticsParser::ProductData> const & product) const
+    {
+        return std::get<OpticsParser::DualBandBSDF>(product->measurements.value()).solar.tf.data;
+    }
+
+    virtual void SetUp()
+    {
+        std::filesystem::path path(test_dir);
+        path /= "products";
+        path /= "2011-SA1.XML";
+        shade_path = path.string();
+    }
+};
+
+TEST_F(TestConvertOpticsParser, Sole_Owner_Measurements_Moved)
+{
+    auto reference = OpticsParser::parseBSDFXMLFile(shade_path);
+    auto expected = encode_product(convert_to_solid_layer(reference));
+
+    // Converting through the rvalue overload does not release the caller's pointer so the
+    // parsed product can still be inspected afterwards.
+    auto parsed = OpticsParser::parseBSDFXMLFile(shade_path);
+    auto converted = convert_to_solid_layer(std::move(parsed));
+    EXPECT_TRUE(solar_tf(parsed).empty());
+    EXPECT_EQ(encode_product(converted), expected);
+}
+
+TEST_F(TestConvertOpticsParser, Shared_Measurements_Copied)
+{
+    auto parsed = OpticsParser::parseBSDFXMLFile(shade_path);
+    auto shared = parsed;
+    auto converted = convert_to_solid_layer(std::move(parsed));
+    EXPECT_EQ(solar_tf(shared).size(), 145u);
+
+    auto lvalue_converted = convert_to_solid_layer(shared);
+    EXPECT_EQ(solar_tf(shared).size(), 145u);
+    EXPECT_EQ(encode_product(lvalue_converted), encode_product(converted));
+}
+
+TEST_F(TestConvertOpticsParser, Glazing_System_From_Parsed_Products)
+{
+    std::filesystem::path products(test_dir);
+    products /= "products";
+    auto clear_3_path = (products / "CLEAR_3.json").string();
+    auto igsdb_5051_path = (products / "igsdb_5051.json").string();
+
+    std::vector<std::shared_ptr<OpticsParser::ProductData>> kept{
+      OpticsParser::parseJSONFile(clear_3_path), OpticsParser::parseJSONFile(igsdb_5051_path)};
+    std::vector<std::shared_ptr<OpticsParser::ProductData>> moved{
+      OpticsParser::parseJSONFile(clear_3_path), OpticsParser::parseJSONFile(igsdb_5051_path)};
+
+    std::filesystem::path standard_path(test_dir);
+    standard_path /= "standards";
+    standard_path /= "W5_NFRC_2003.std";
+    auto standard = window_standards::load_optical_standard(standard_path.string());
+
+    Engine_Gap_Info air_gap(Gases::GasDef::Air, 0.0127);
+    std::vector<Engine_Gap_Info> gaps{air_gap};
+    Glazing_System from_copy(standard, kept, gaps);
+    Glazing_System from_move(standard, std::move(moved), std::move(gaps));
+
+    // Products passed by reference are left untouched
+    EXPECT_TRUE(kept[0]->measurements.has_value());
+    EXPECT_NEAR(from_move.u(), from_copy.u(), 1e-12);
+    EXPECT_NEAR(from_move.shgc(), from_copy.shgc(), 1e-12);
+}
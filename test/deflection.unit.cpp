@@ -62,3 +62,35 @@ TEST_F(TestDeflection, Test_Deflection_On)
     test_deflection_results(
       "NFRC_102_NFRC_102", "deflection/deflection_on", glazing_system, update_results);
 }
+
+TEST_F(TestDeflection, Test_Deflection_Off_Repeated_Queries_Do_Not_Resolve)
+{
+    // Without deflection the system is only cleared when it changes so asking for the same
+    // results again must return exactly the same values instead of solving again.
+    auto u = glazing_system->u();
+    auto first = glazing_system->statistics();
+    auto temperatures = glazing_system->layer_temperatures(Tarcog::ISO15099::System::Uvalue);
+    EXPECT_EQ(u, glazing_system->u());
+    EXPECT_EQ(temperatures,
+              glazing_system->layer_temperatures(Tarcog::ISO15099::System::Uvalue));
+    auto repeated = glazing_system->statistics();
+    repeated -= first;
+
+    if(instrumentation::enabled())
+    {
+        // Each query counts the iterations of the solution it returned.  Solving again would
+        // start from the converged solution and take fewer iterations than the first solve,
+        // so three repeated queries that each count the first solve's iterations did not solve.
+        auto iterations = first[instrumentation::Counter::TARCOG_ITERATIONS];
+        EXPECT_GT(iterations, 0u);
+        EXPECT_EQ(repeated[instrumentation::Counter::TARCOG_QUERIES], 3u);
+        EXPECT_EQ(repeated[instrumentation::Counter::TARCOG_ITERATIONS], 3 * iterations);
+        EXPECT_EQ(repeated[instrumentation::Counter::IGU_CACHE_MISS], 0u);
+    }
+
+    // Turning deflection on does apply it
+    glazing_system->enable_deflection(true);
+    auto deflection_results =
+      glazing_system->calc_deflection_properties(Tarcog::ISO15099::System::Uvalue);
+    EXPECT_NE(deflection_results.deflection_max, std::vector<double>(2, 0.0));
+}
@@ -74,3 +74,122 @@ TEST_F(TestDeflectionLoad, Test_Deflection_On)
                             glazing_system,
                             update_results);
 }
+
+TEST_F(TestDeflectionLoad, Test_Deflection_Default_Single_Pass)
+{
+    glazing_system->enable_deflection(true);
+    glazing_system->set_applied_loads({12, 23});
+    auto results = glazing_system->calc_deflection_properties(Tarcog::ISO15099::System::Uvalue);
+    EXPECT_EQ(results.passes, 1u);
+    EXPECT_GE(results.solver_iterations, 1u);
+    EXPECT_TRUE(results.converged);
+}
+
+TEST_F(TestDeflectionLoad, Test_Deflection_Off_Is_Converged)
+{
+    Deflection_Solver_Settings settings;
+    settings.max_passes = 50;
+    glazing_system->set_deflection_solver_settings(settings);
+    auto results = glazing_system->calc_deflection_properties(Tarcog::ISO15099::System::Uvalue);
+    EXPECT_EQ(results.passes, 1u);
+    EXPECT_TRUE(results.converged);
+}
+
+TEST_F(TestDeflectionLoad, Test_Deflection_Converged_Load_Sweep)
+{
+    glazing_system->enable_deflection(true);
+    Deflection_Solver_Settings settings;
+    settings.tolerance = 1e-8;
+    settings.max_passes = 50;
+    glazing_system->set_deflection_solver_settings(settings);
+
+    glazing_system->set_applied_loads({12, 23});
+    auto first = glazing_system->calc_deflection_properties(Tarcog::ISO15099::System::Uvalue);
+    EXPECT_TRUE(first.converged);
+    EXPECT_GT(first.passes, 1u);
+    EXPECT_GE(first.solver_iterations, first.passes);
+
+    for(double load : {20.0, 40.0, 60.0, 80.0})
+    {
+        glazing_system->set_applied_loads({load, load});
+        auto results =
+          glazing_system->calc_deflection_properties(Tarcog::ISO15099::System::Uvalue);
+        EXPECT_TRUE(results.converged);
+        EXPECT_GE(results.solver_iterations, results.passes);
+
+        // Passes stop once the change is within the tolerance so asking again moves the
+        // result by about that much
+        auto repeated =
+          glazing_system->calc_deflection_properties(Tarcog::ISO15099::System::Uvalue);
+        EXPECT_TRUE(repeated.converged);
+        for(size_t i = 0; i < results.deflection_max.size(); ++i)
+        {
+            EXPECT_NEAR(results.deflection_max[i], repeated.deflection_max[i], 1e-6);
+        }
+    }
+}
+
+TEST_F(TestDeflectionLoad, Test_Deflection_Solver_Settings_Validation)
+{
+    Deflection_Solver_Settings settings;
+    settings.max_passes = 0;
+    EXPECT_THROW(glazing_system->set_deflection_solver_settings(settings), std::runtime_error);
+    settings.max_passes = 10;
+    settings.tolerance = -1;
+    EXPECT_THROW(glazing_system->set_deflection_solver_settings(settings), std::runtime_error);
+}
+
+TEST_F(TestDeflectionLoad, Test_Deflection_Sweep_Matches_Single_Calculation)
+{
+    auto points = deflection_sweep_grid({{12, 23}, {1, 1000}}, {293.15}, {101325}, {90});
+    auto sweep = glazing_system->deflection_sweep(points, Tarcog::ISO15099::System::Uvalue);
+    ASSERT_EQ(sweep.size(), points.size());
+
+    // Every point is solved from scratch so a later point does not depend on the one before
+    auto second = glazing_system->deflection_sweep({points[1]}, Tarcog::ISO15099::System::Uvalue);
+    for(size_t i = 0; i < second[0].deflection_max.size(); ++i)
+    {
+        EXPECT_NEAR(second[0].deflection_max[i], sweep[1].deflection_max[i], 1e-12);
+        EXPECT_NEAR(second[0].deflection_mean[i], sweep[1].deflection_mean[i], 1e-12);
+    }
+
+    // and the first point must match a system set up the same way by hand
+    glazing_system->enable_deflection(true);
+    glazing_system->set_applied_loads({12, 23});
+    auto expected = glazing_system->calc_deflection_properties(Tarcog::ISO15099::System::Uvalue);
+    for(size_t i = 0; i < expected.deflection_max.size(); ++i)
+    {
+        EXPECT_NEAR(expected.deflection_max[i], sweep[0].deflection_max[i], 1e-9);
+        EXPECT_NEAR(expected.deflection_mean[i], sweep[0].deflection_mean[i], 1e-9);
+        EXPECT_NEAR(expected.panes_load[i], sweep[0].panes_load[i], 1e-6);
+    }
+}
+
+TEST_F(TestDeflectionLoad, Test_Deflection_Sweep_Parallel_Matches_Serial)
+{
+    Deflection_Solver_Settings settings;
+    settings.tolerance = 1e-7;
+    settings.max_passes = 50;
+    glazing_system->set_deflection_solver_settings(settings);
+
+    auto points = deflection_sweep_grid({{0, 0}, {12, 23}, {50, 50}, {1, 1000}},
+                                        {283.15, 293.15},
+                                        {90000, 101325},
+                                        {60, 90});
+    auto serial = glazing_system->deflection_sweep(points, Tarcog::ISO15099::System::Uvalue);
+    auto parallel =
+      glazing_system->deflection_sweep(points, Tarcog::ISO15099::System::Uvalue, 0, 0, 4);
+    ASSERT_EQ(serial.size(), points.size());
+    ASSERT_EQ(parallel.size(), points.size());
+    for(size_t i = 0; i < points.size(); ++i)
+    {
+        EXPECT_TRUE(serial[i].converged);
+        EXPECT_TRUE(parallel[i].converged);
+        for(size_t j = 0; j < serial[i].deflection_max.size(); ++j)
+        {
+            // Deflections are mm-scale, each point is solved the same way on any thread
+            EXPECT_NEAR(serial[i].deflection_max[j], parallel[i].deflection_max[j], 1e-12);
+            EXPECT_NEAR(serial[i].deflection_mean[j], parallel[i].deflection_mean[j], 1e-12);
+        }
+    }
+}
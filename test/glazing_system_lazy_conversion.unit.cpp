@@ -0,0 +1,96 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <variant>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+
+using namespace wincalc;
+using namespace window_standards;
+
+using Layer =
+  std::variant<std::shared_ptr<OpticsParser::ProductData>, Product_Data_Optical_Thermal>;
+
+class TestGlazingSystemLazyConversion : public testing::Test
+{
+protected:
+    std::shared_ptr<OpticsParser::ProductData> clear_3;
+    std::shared_ptr<OpticsParser::ProductData> igsdb_5051;
+    Optical_Standard standard;
+    std::vector<Engine_Gap_Info> gaps;
+
+    virtual void SetUp()
+    {
+        std::filesystem::path products(test_dir);
+        products /= "products";
+        clear_3 = OpticsParser::parseJSONFile((products / "CLEAR_3.json").string());
+        igsdb_5051 = OpticsParser::parseJSONFile((products / "igsdb_5051.json").string());
+
+        std::filesystem::path standard_path(test_dir);
+        standard_path /= "standards";
+        standard_path /= "W5_NFRC_2003.std";
+        standard = load_optical_standard(standard_path.string());
+
+        gaps.push_back(Engine_Gap_Info(Gases::GasDef::Air, 0.0127));
+    }
+};
+
+TEST_F(TestGlazingSystemLazyConversion, Same_As_Converted_Layers)
+{
+    std::vector<Product_Data_Optical_Thermal> converted{convert_to_solid_layer(clear_3),
+                                                        convert_to_solid_layer(igsdb_5051)};
+    std::vector<Layer> mixed{Layer(clear_3), Layer(convert_to_solid_layer(igsdb_5051))};
+
+    Glazing_System eager(standard, converted, gaps);
+    Glazing_System lazy(standard, mixed, gaps);
+
+    // Optical results first so only the optical part of the parsed layer has been converted
+    // when they are calculated
+    auto eager_solar = eager.optical_method_results("SOLAR");
+    auto lazy_solar = lazy.optical_method_results("SOLAR");
+    EXPECT_EQ(lazy_solar.system_results.front.transmittance.direct_direct,
+              eager_solar.system_results.front.transmittance.direct_direct);
+    EXPECT_EQ(lazy_solar.system_results.back.reflectance.direct_hemispherical,
+              eager_solar.system_results.back.reflectance.direct_hemispherical);
+    EXPECT_EQ(lazy.u(), eager.u());
+    EXPECT_EQ(lazy.shgc(), eager.shgc());
+
+    auto layers = lazy.solid_layers();
+    ASSERT_EQ(layers.size(), 2u);
+    for(auto const & layer : layers)
+    {
+        EXPECT_TRUE(layer.optical_data);
+        EXPECT_TRUE(layer.thermal_data);
+    }
+}
+
+TEST_F(TestGlazingSystemLazyConversion, Flip_Before_Conversion)
+{
+    std::vector<Product_Data_Optical_Thermal> converted{convert_to_solid_layer(clear_3),
+                                                        convert_to_solid_layer(igsdb_5051)};
+    std::vector<std::shared_ptr<OpticsParser::ProductData>> parsed{clear_3, igsdb_5051};
+
+    Glazing_System eager(standard, converted, gaps);
+    Glazing_System lazy(standard, parsed, gaps);
+    eager.flip_layer(1, true);
+    lazy.flip_layer(1, true);
+
+    EXPECT_EQ(lazy.u(), eager.u());
+    EXPECT_EQ(lazy.shgc(), eager.shgc());
+    EXPECT_TRUE(lazy.solid_layers()[1].is_flipped());
+}
+
+TEST_F(TestGlazingSystemLazyConversion, Construction_Does_Not_Convert)
+{
+    // Products are only checked when they are converted so a product without measurements
+    // can be used to build a system but not to calculate with it
+    auto no_measurements = OpticsParser::parseJSONFile(
+      (std::filesystem::path(test_dir) / "products" / "CLEAR_3.json").string());
+    no_measurements->measurements = std::nullopt;
+    std::vector<std::shared_ptr<OpticsParser::ProductData>> parsed{no_measurements};
+
+    Glazing_System system(standard, parsed);
+    EXPECT_THROW(system.optical_method_results("SOLAR"), std::runtime_error);
+}
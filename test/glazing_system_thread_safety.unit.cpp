@@ -0,0 +1,238 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+
+using namespace wincalc;
+using namespace window_standards;
+
+class TestGlazingSystemThreadSafety : public testing::Test
+{
+protected:
+    std::vector<std::shared_ptr<OpticsParser::ProductData>> products;
+    Optical_Standard standard;
+
+    virtual void SetUp()
+    {
+        std::filesystem::path clear_3_path(test_dir);
+        clear_3_path /= "products";
+        clear_3_path /= "CLEAR_3.json";
+
+        OpticsParser::Parser parser;
+        auto clear_3 = parser.parseJSONFile(clear_3_path.string());
+        products.push_back(clear_3);
+        products.push_back(clear_3);
+
+        std::filesystem::path standard_path(test_dir);
+        standard_path /= "standards";
+        standard_path /= "W5_NFRC_2003.std";
+        standard = load_optical_standard(standard_path.string());
+    }
+
+    // Every system shares the same parsed products and standard but uses a different gap
+    // width so the results differ between systems.
+    std::vector<std::shared_ptr<Glazing_System>> create_systems(size_t count) const
+    {
+        std::vector<std::shared_ptr<Glazing_System>> systems;
+        for(size_t i = 0; i < count; ++i)
+        {
+            Engine_Gap_Info air_gap(Gases::GasDef::Air, 0.006 + 0.001 * i);
+            std::vector<Engine_Gap_Info> gaps;
+            gaps.push_back(air_gap);
+            systems.push_back(std::make_shared<Glazing_System>(
+              standard, products, gaps, 1.0, 1.0, 90, nfrc_u_environments()));
+        }
+        return systems;
+    }
+};
+
+struct U_SHGC
+{
+    double u;
+    double shgc;
+};
+
+TEST_F(TestGlazingSystemThreadSafety, Concurrent_Matches_Serial)
+{
+    const size_t number_of_systems = 16;
+
+    std::vector<U_SHGC> serial_results;
+    for(auto & system : create_systems(number_of_systems))
+    {
+        serial_results.push_back({system->u(), system->shgc()});
+    }
+
+    auto systems = create_systems(number_of_systems);
+    std::vector<U_SHGC> concurrent_results(number_of_systems);
+    std::vector<std::thread> threads;
+    for(size_t i = 0; i < number_of_systems; ++i)
+    {
+        threads.emplace_back([&systems, &concurrent_results, i]() {
+            concurrent_results[i] = {systems[i]->u(), systems[i]->shgc()};
+        });
+    }
+    for(auto & thread : threads)
+    {
+        thread.join();
+    }
+
+    for(size_t i = 0; i < number_of_systems; ++i)
+    {
+        EXPECT_EQ(serial_results[i].u, concurrent_results[i].u);
+        EXPECT_EQ(serial_results[i].shgc, concurrent_results[i].shgc);
+    }
+}
+
+TEST_F(TestGlazingSystemThreadSafety, Concurrent_Construction)
+{
+    // Constructing systems from shared products must not race either so build each system on
+    // its own thread as well.
+    const size_t number_of_systems = 16;
+
+    std::vector<double> serial_u;
+    for(auto & system : create_systems(number_of_systems))
+    {
+        serial_u.push_back(system->u());
+    }
+
+    std::vector<double> concurrent_u(number_of_systems);
+    std::vector<std::thread> threads;
+    for(size_t i = 0; i < number_of_systems; ++i)
+    {
+        threads.emplace_back([this, &concurrent_u, i]() {
+            Engine_Gap_Info air_gap(Gases::GasDef::Air, 0.006 + 0.001 * i);
+            std::vector<Engine_Gap_Info> gaps;
+            gaps.push_back(air_gap);
+            Glazing_System system(standard, products, gaps, 1.0, 1.0, 90, nfrc_u_environments());
+            concurrent_u[i] = system.u();
+        });
+    }
+    for(auto & thread : threads)
+    {
+        thread.join();
+    }
+
+    for(size_t i = 0; i < number_of_systems; ++i)
+    {
+        EXPECT_EQ(serial_u[i], concurrent_u[i]);
+    }
+}
+
+TEST_F(TestGlazingSystemThreadSafety, Flip_Does_Not_Affect_Shared_Products)
+{
+    // Both systems use the same converted products.  Flipping the low-e layer in one system
+    // must not change the products or the results of the other system.
+    std::filesystem::path lowe_path(test_dir);
+    lowe_path /= "products";
+    lowe_path /= "igsdb_5051.json";
+    OpticsParser::Parser parser;
+    auto lowe = convert_to_solid_layer(parser.parseJSONFile(lowe_path.string()));
+    auto clear_3 = convert_to_solid_layer(products[0]);
+    std::vector<Product_Data_Optical_Thermal> layers{lowe, clear_3};
+
+    Engine_Gap_Info air_gap(Gases::GasDef::Air, 0.0127);
+    std::vector<Engine_Gap_Info> gaps{air_gap};
+
+    Glazing_System unflipped(standard, layers, gaps, 1.0, 1.0, 90, nfrc_shgc_environments());
+    Glazing_System flipped(standard, layers, gaps, 1.0, 1.0, 90, nfrc_shgc_environments());
+    double unflipped_u = unflipped.u();
+    double unflipped_shgc = unflipped.shgc();
+    double unflipped_tf = unflipped.optical_method_results("SOLAR")
+                            .system_results.front.transmittance.direct_direct;
+
+    flipped.flip_layer(0, true);
+    double flipped_u = flipped.u();
+    double flipped_shgc = flipped.shgc();
+
+    EXPECT_FALSE(lowe.optical_data->flipped);
+    EXPECT_FALSE(lowe.thermal_data->flipped);
+    EXPECT_TRUE(flipped.solid_layers()[0].is_flipped());
+    EXPECT_FALSE(unflipped.solid_layers()[0].is_flipped());
+    EXPECT_NE(unflipped_u, flipped_u);
+    EXPECT_NE(unflipped_shgc, flipped_shgc);
+
+    // A system built from the same products after the flip still sees them unflipped
+    Glazing_System later(standard, layers, gaps, 1.0, 1.0, 90, nfrc_shgc_environments());
+    EXPECT_EQ(unflipped_u, later.u());
+    EXPECT_EQ(unflipped_shgc, later.shgc());
+    EXPECT_EQ(
+      unflipped_tf,
+      later.optical_method_results("SOLAR").system_results.front.transmittance.direct_direct);
+}
+
+TEST_F(TestGlazingSystemThreadSafety, Concurrent_Standards_And_Shade_Factories)
+{
+    // Every thread loads its own standard and makes a shade from the same parsed material,
+    // two threads for each kind of shade.
+    const size_t number_of_systems = 6;
+
+    std::filesystem::path material_path(test_dir);
+    material_path /= "products";
+    material_path /= "igsdb_12852.json";
+    auto material = OpticsParser::parseJSONFile(material_path.string());
+
+    std::filesystem::path standard_path(test_dir);
+    standard_path /= "standards";
+    standard_path /= "W5_NFRC_2003.std";
+
+    auto create_shade = [&material](size_t i) {
+        if(i % 3 == 0)
+        {
+            return create_venetian_blind(Venetian_Geometry{45, 0.05, 0.07, 0.03}, material);
+        }
+        if(i % 3 == 1)
+        {
+            return create_woven_shade(Woven_Geometry{0.002, 0.003, 0.002}, material);
+        }
+        return create_perforated_screen(
+          Perforated_Geometry{0.02, 0.03, 0.002, 0.003, Perforated_Geometry::Type::RECTANGULAR},
+          material);
+    };
+
+    auto u_with_shade = [&](size_t i) {
+        auto shade = create_shade(i);
+        auto loaded_standard = load_optical_standard(standard_path.string());
+        std::vector<
+          std::variant<std::shared_ptr<OpticsParser::ProductData>, Product_Data_Optical_Thermal>>
+          layers{shade, products[0]};
+        Engine_Gap_Info air_gap(Gases::GasDef::Air, 0.0127);
+        std::vector<Engine_Gap_Info> gaps{air_gap};
+        auto bsdf_hemisphere =
+          SingleLayerOptics::CBSDFHemisphere::create(SingleLayerOptics::BSDFBasis::Quarter);
+        Glazing_System system(
+          loaded_standard, layers, gaps, 1.0, 1.0, 90, nfrc_u_environments(), bsdf_hemisphere);
+        return std::make_pair(loaded_standard.methods.size(), system.u());
+    };
+
+    std::vector<std::pair<size_t, double>> serial_results;
+    for(size_t i = 0; i < number_of_systems; ++i)
+    {
+        serial_results.push_back(u_with_shade(i));
+    }
+
+    std::vector<std::pair<size_t, double>> concurrent_results(number_of_systems);
+    std::vector<std::thread> threads;
+    for(size_t i = 0; i < number_of_systems; ++i)
+    {
+        threads.emplace_back(
+          [&u_with_shade, &concurrent_results, i]() { concurrent_results[i] = u_with_shade(i); });
+    }
+    for(auto & thread : threads)
+    {
+        thread.join();
+    }
+
+    for(size_t i = 0; i < number_of_systems; ++i)
+    {
+        EXPECT_EQ(serial_results[i].first, standard.methods.size());
+        EXPECT_EQ(serial_results[i].first, concurrent_results[i].first);
+        EXPECT_EQ(serial_results[i].second, concurrent_results[i].second);
+    }
+}
@@ -0,0 +1,122 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <filesystem>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+
+using namespace wincalc;
+using namespace window_standards;
+
+class TestInstrumentation : public testing::Test
+{
+protected:
+    std::shared_ptr<Glazing_System> glazing_system;
+
+    virtual void SetUp()
+    {
+        std::filesystem::path products(test_dir);
+        products /= "products";
+
+        OpticsParser::Parser parser;
+        auto clear_3 = parser.parseJSONFile((products / "CLEAR_3.json").string());
+
+        std::filesystem::path standard_path(test_dir);
+        standard_path /= "standards";
+        standard_path /= "W5_NFRC_2003.std";
+        Optical_Standard standard = load_optical_standard(standard_path.string());
+
+        std::vector<std::shared_ptr<OpticsParser::ProductData>> products_list{clear_3, clear_3};
+        std::vector<Engine_Gap_Info> gaps{Engine_Gap_Info(Gases::GasDef::Air, 0.0127)};
+
+        glazing_system = std::make_shared<Glazing_System>(standard, products_list, gaps);
+    }
+};
+
+TEST_F(TestInstrumentation, Statistics_Add_And_Subtract)
+{
+    instrumentation::Statistics a;
+    a.stages[static_cast<size_t>(instrumentation::Stage::TARCOG_SOLVE)] = {2, 100};
+    a.counters[static_cast<size_t>(instrumentation::Counter::TARCOG_ITERATIONS)] = 7;
+
+    instrumentation::Statistics b = a;
+    b += a;
+    EXPECT_EQ(b[instrumentation::Stage::TARCOG_SOLVE].calls, 4u);
+    EXPECT_EQ(b[instrumentation::Stage::TARCOG_SOLVE].nanoseconds, 200u);
+    EXPECT_EQ(b[instrumentation::Counter::TARCOG_ITERATIONS], 14u);
+
+    b -= a;
+    EXPECT_EQ(b[instrumentation::Stage::TARCOG_SOLVE].calls, 2u);
+    EXPECT_EQ(b[instrumentation::Counter::TARCOG_ITERATIONS], 7u);
+}
+
+TEST_F(TestInstrumentation, Names)
+{
+    EXPECT_EQ(instrumentation::name(instrumentation::Stage::TARCOG_SOLVE), "tarcog_solve");
+    EXPECT_EQ(instrumentation::name(instrumentation::Counter::IGU_CACHE_HIT), "igu_cache_hit");
+}
+
+TEST_F(TestInstrumentation, Glazing_System_Statistics)
+{
+    glazing_system->u();
+    glazing_system->u();
+    auto statistics = glazing_system->statistics();
+
+    if(!instrumentation::enabled())
+    {
+        EXPECT_EQ(statistics[instrumentation::Stage::TARCOG_SOLVE].calls, 0u);
+        EXPECT_EQ(statistics[instrumentation::Counter::TARCOG_QUERIES], 0u);
+        return;
+    }
+
+    EXPECT_EQ(statistics[instrumentation::Stage::TARCOG_SOLVE].calls, 2u);
+    EXPECT_EQ(statistics[instrumentation::Counter::TARCOG_QUERIES], 2u);
+    EXPECT_GT(statistics[instrumentation::Counter::TARCOG_ITERATIONS], 0u);
+    EXPECT_EQ(statistics[instrumentation::Counter::IGU_CACHE_MISS], 1u);
+    EXPECT_GE(statistics[instrumentation::Counter::IGU_CACHE_HIT], 1u);
+    EXPECT_GE(statistics[instrumentation::Stage::CREATE_IGU].calls, 1u);
+
+    glazing_system->reset_statistics();
+    EXPECT_EQ(glazing_system->statistics()[instrumentation::Counter::TARCOG_QUERIES], 0u);
+}
+
+TEST_F(TestInstrumentation, Thread_Statistics_Include_Parallel_Work)
+{
+    instrumentation::reset_thread_statistics();
+    std::vector<Deflection_Sweep_Point> points(4);
+    glazing_system->deflection_sweep(points, Tarcog::ISO15099::System::Uvalue, 0, 0, 2);
+    auto statistics = instrumentation::thread_statistics();
+
+    if(!instrumentation::enabled())
+    {
+        EXPECT_EQ(statistics[instrumentation::Counter::TARCOG_QUERIES], 0u);
+        return;
+    }
+
+    EXPECT_GE(statistics[instrumentation::Counter::TARCOG_QUERIES], points.size());
+    EXPECT_EQ(glazing_system->statistics()[instrumentation::Counter::TARCOG_QUERIES],
+              statistics[instrumentation::Counter::TARCOG_QUERIES]);
+}
+
+TEST_F(TestInstrumentation, Allocations_Counted_Per_Stage)
+{
+    auto start = instrumentation::thread_allocations();
+    glazing_system->u();
+    auto end = instrumentation::thread_allocations();
+    auto statistics = glazing_system->statistics();
+
+    if(!instrumentation::allocation_profiling_enabled())
+    {
+        EXPECT_EQ(end.count, start.count);
+        EXPECT_EQ(statistics[instrumentation::Stage::CREATE_IGU].allocations, 0u);
+        return;
+    }
+
+    EXPECT_GT(end.count, start.count);
+    EXPECT_GT(end.bytes, start.bytes);
+    auto const & igu = statistics[instrumentation::Stage::CREATE_IGU];
+    EXPECT_GT(igu.allocations, 0u);
+    EXPECT_GT(igu.allocated_bytes, 0u);
+    EXPECT_LE(igu.allocations, end.count - start.count);
+}
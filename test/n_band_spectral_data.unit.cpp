@@ -0,0 +1,150 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+
+using namespace wincalc;
+
+class TestNBandSpectralData : public testing::Test
+{
+protected:
+    std::shared_ptr<OpticsParser::ProductData> parse(std::string const & file_name)
+    {
+        std::filesystem::path path(test_dir);
+        path /= "products";
+        path /= file_name;
+        return OpticsParser::parseJSONFile(path.string());
+    }
+};
+
+TEST_F(TestNBandSpectralData, Rows_Sorted_Into_Columns)
+{
+    std::vector<OpticsParser::WLData> rows;
+    rows.emplace_back(0.5, OpticsParser::MeasurementComponent{0.5, 0.51, 0.05, 0.06});
+    rows.emplace_back(0.3, OpticsParser::MeasurementComponent{0.3, 0.31, 0.03, 0.04});
+    rows.emplace_back(0.4, OpticsParser::MeasurementComponent{0.4, 0.41, 0.04, 0.05});
+
+    N_Band_Spectral_Data data(rows);
+
+    EXPECT_EQ(data.size(), 3u);
+    EXPECT_EQ(data.wavelengths(), std::vector<double>({0.3, 0.4, 0.5}));
+    EXPECT_EQ(data.tf(), std::vector<double>({0.3, 0.4, 0.5}));
+    EXPECT_EQ(data.tb(), std::vector<double>({0.31, 0.41, 0.51}));
+    EXPECT_EQ(data.rf(), std::vector<double>({0.03, 0.04, 0.05}));
+    EXPECT_EQ(data.rb(), std::vector<double>({0.04, 0.05, 0.06}));
+    EXPECT_FALSE(data.has_pv());
+}
+
+TEST_F(TestNBandSpectralData, Rows_Without_Direct_Component_Kept)
+{
+    std::vector<OpticsParser::WLData> rows;
+    rows.emplace_back(0.4, OpticsParser::MeasurementComponent{0.4, 0.4, 0.04, 0.04});
+    OpticsParser::WLData pv_only(0.35, OpticsParser::MeasurementComponent{0, 0, 0, 0});
+    pv_only.directComponent.reset();
+    pv_only.pvComponent = OpticsParser::PVWavelengthData{0.8, 0.7};
+    rows.push_back(pv_only);
+    rows.emplace_back(0.3,
+                      OpticsParser::MeasurementComponent{0.3, 0.3, 0.03, 0.03},
+                      OpticsParser::MeasurementComponent{0.1, 0.1, 0.01, 0.01});
+
+    N_Band_Spectral_Data data(rows);
+
+    // Every row is kept and wavelengths has all of them, the same as before the rows were
+    // stored in columns
+    EXPECT_EQ(data.size(), 3u);
+    EXPECT_EQ(data.wavelengths(), std::vector<double>({0.3, 0.35, 0.4}));
+    std::sort(rows.begin(), rows.end(), [](auto const & v1, auto const & v2) {
+        return v1.wavelength < v2.wavelength;
+    });
+
+    EXPECT_EQ(data.direct_wavelengths(), std::vector<double>({0.3, 0.4}));
+    EXPECT_EQ(data.tf(), std::vector<double>({0.3, 0.4}));
+    EXPECT_TRUE(data.has_pv());
+    EXPECT_EQ(data.pv_wavelengths(), std::vector<double>({0.35}));
+    EXPECT_EQ(data.eqef(), std::vector<double>({0.8}));
+    EXPECT_EQ(data.eqeb(), std::vector<double>({0.7}));
+
+    auto rebuilt = data.rows();
+    ASSERT_EQ(rebuilt.size(), rows.size());
+    for(size_t i = 0; i < rows.size(); ++i)
+    {
+        EXPECT_EQ(rebuilt[i].wavelength, rows[i].wavelength);
+        EXPECT_EQ(rebuilt[i].directComponent.has_value(), rows[i].directComponent.has_value());
+        EXPECT_EQ(rebuilt[i].diffuseComponent.has_value(),
+                  rows[i].diffuseComponent.has_value());
+        EXPECT_EQ(rebuilt[i].pvComponent.has_value(), rows[i].pvComponent.has_value());
+    }
+    EXPECT_EQ(rebuilt[0].diffuseComponent.value().tf, 0.1);
+    EXPECT_EQ(rebuilt[1].pvComponent.value().eqeb, 0.7);
+    EXPECT_EQ(rebuilt[2].directComponent.value().rb, 0.04);
+}
+
+TEST_F(TestNBandSpectralData, Validated_On_Construction)
+{
+    EXPECT_NO_THROW(N_Band_Spectral_Data(std::vector<OpticsParser::WLData>()));
+
+    // A row without direct values is only a problem when the data is converted
+    OpticsParser::WLData no_direct(0.3, OpticsParser::MeasurementComponent{0, 0, 0, 0});
+    no_direct.directComponent.reset();
+    N_Band_Spectral_Data data({no_direct});
+    EXPECT_EQ(data.wavelengths(), std::vector<double>({0.3}));
+    EXPECT_TRUE(data.direct_wavelengths().empty());
+
+    std::vector<OpticsParser::WLData> duplicated;
+    duplicated.emplace_back(0.4, OpticsParser::MeasurementComponent{0.4, 0.4, 0.04, 0.04});
+    duplicated.emplace_back(0.3, OpticsParser::MeasurementComponent{0.3, 0.3, 0.03, 0.03});
+    duplicated.emplace_back(0.4, OpticsParser::MeasurementComponent{0.5, 0.5, 0.05, 0.05});
+    EXPECT_THROW(N_Band_Spectral_Data{duplicated}, std::runtime_error);
+
+    std::vector<OpticsParser::WLData> not_finite;
+    not_finite.emplace_back(0.3, OpticsParser::MeasurementComponent{0.3, 0.3, 0.03, 0.03});
+    not_finite.emplace_back(std::nan(""), OpticsParser::MeasurementComponent{0, 0, 0, 0});
+    EXPECT_THROW(N_Band_Spectral_Data{not_finite}, std::runtime_error);
+}
+
+TEST_F(TestNBandSpectralData, Wavelength_Data_Member_Kept)
+{
+    auto product = convert_to_solid_layer(parse("CLEAR_3.json"));
+    auto n_band = std::dynamic_pointer_cast<Product_Data_N_Band_Optical>(product.optical_data);
+    ASSERT_TRUE(n_band);
+
+    // Code written before spectral_data still finds the sorted rows in wavelength_data
+    ASSERT_EQ(n_band->wavelength_data.size(), n_band->spectral_data.size());
+    for(size_t i = 0; i < n_band->wavelength_data.size(); ++i)
+    {
+        EXPECT_EQ(n_band->wavelength_data[i].wavelength, n_band->wavelengths()[i]);
+    }
+}
+
+TEST_F(TestNBandSpectralData, Wavelengths_Not_Copied)
+{
+    auto product = convert_to_solid_layer(parse("CLEAR_3.json"));
+    auto n_band = std::dynamic_pointer_cast<Product_Data_N_Band_Optical>(product.optical_data);
+    ASSERT_TRUE(n_band);
+
+    // Every call returns the same column owned by the product
+    auto const & first = n_band->wavelengths();
+    auto const & second = product.optical_data->wavelengths();
+    EXPECT_EQ(&first, &second);
+    EXPECT_EQ(&first, &n_band->spectral_data.wavelengths());
+    EXPECT_TRUE(std::is_sorted(first.begin(), first.end()));
+    EXPECT_EQ(first, n_band->spectral_data.direct_wavelengths());
+}
+
+TEST_F(TestNBandSpectralData, PV_Columns)
+{
+    auto product = convert_to_solid_layer(parse("generic_pv.json"));
+    auto n_band = std::dynamic_pointer_cast<Product_Data_N_Band_Optical>(product.optical_data);
+    ASSERT_TRUE(n_band);
+
+    auto const & data = n_band->spectral_data;
+    EXPECT_TRUE(data.has_pv());
+    EXPECT_EQ(data.pv_wavelengths().size(), data.eqef().size());
+    EXPECT_EQ(data.pv_wavelengths().size(), data.eqeb().size());
+    EXPECT_TRUE(std::is_sorted(data.pv_wavelengths().begin(), data.pv_wavelengths().end()));
+}
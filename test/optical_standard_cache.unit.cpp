@@ -0,0 +1,166 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+
+using namespace wincalc;
+using namespace window_standards;
+
+class TestOpticalStandardCache : public testing::Test
+{
+protected:
+    std::filesystem::path directory;
+    std::filesystem::path standard_path;
+    std::filesystem::path cache_path;
+
+    virtual void SetUp()
+    {
+        // Work on a copy of the standard so its files can be modified
+        directory = std::filesystem::temp_directory_path() / "wincalc_optical_standard_cache_test";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        std::filesystem::path source(test_dir);
+        source /= "standards";
+        std::filesystem::copy(source, directory);
+        standard_path = directory / "W5_NFRC_2003.std";
+        cache_path = directory / "W5_NFRC_2003.std.cache";
+    }
+
+    virtual void TearDown()
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    void expect_same_spectrum(Spectrum const & cached, Spectrum const & loaded) const
+    {
+        EXPECT_EQ(cached.type, loaded.type);
+        EXPECT_EQ(cached.values, loaded.values);
+        EXPECT_EQ(cached.t, loaded.t);
+        EXPECT_EQ(cached.a, loaded.a);
+        EXPECT_EQ(cached.b, loaded.b);
+    }
+
+    void expect_same_standard(Optical_Standard const & cached,
+                              Optical_Standard const & loaded) const
+    {
+        EXPECT_EQ(cached.name, loaded.name);
+        EXPECT_EQ(cached.description, loaded.description);
+        EXPECT_EQ(cached.file, loaded.file);
+        ASSERT_EQ(cached.methods.size(), loaded.methods.size());
+        for(auto const & entry : loaded.methods)
+        {
+            auto const & method = entry.second;
+            auto const & cached_method = cached.methods.at(entry.first);
+            EXPECT_EQ(cached_method.name, method.name);
+            EXPECT_EQ(cached_method.description, method.description);
+            expect_same_spectrum(cached_method.source_spectrum, method.source_spectrum);
+            expect_same_spectrum(cached_method.detector_spectrum, method.detector_spectrum);
+            EXPECT_EQ(cached_method.wavelength_set.type, method.wavelength_set.type);
+            EXPECT_EQ(cached_method.wavelength_set.values, method.wavelength_set.values);
+            EXPECT_EQ(cached_method.integration_rule.type, method.integration_rule.type);
+            EXPECT_EQ(cached_method.integration_rule.k, method.integration_rule.k);
+            EXPECT_EQ(cached_method.min_wavelength.type, method.min_wavelength.type);
+            EXPECT_EQ(cached_method.min_wavelength.value, method.min_wavelength.value);
+            EXPECT_EQ(cached_method.max_wavelength.type, method.max_wavelength.type);
+            EXPECT_EQ(cached_method.max_wavelength.value, method.max_wavelength.value);
+        }
+    }
+};
+
+TEST_F(TestOpticalStandardCache, Same_As_Text_Files)
+{
+    auto loaded = load_optical_standard(standard_path.string());
+    compile_optical_standard(standard_path.string(), cache_path.string());
+    EXPECT_TRUE(optical_standard_cache_is_current(cache_path.string()));
+    auto cached = read_optical_standard_cache(cache_path.string());
+    expect_same_standard(cached, loaded);
+
+    std::filesystem::path clear_3_path(test_dir);
+    clear_3_path /= "products";
+    clear_3_path /= "CLEAR_3.json";
+    auto clear_3 = OpticsParser::parseJSONFile(clear_3_path.string());
+    std::vector<std::shared_ptr<OpticsParser::ProductData>> products{clear_3};
+    Glazing_System from_text(loaded, products);
+    Glazing_System from_cache(cached, products);
+    EXPECT_EQ(from_cache.u(), from_text.u());
+    EXPECT_EQ(from_cache.shgc(), from_text.shgc());
+    auto text_solar = from_text.optical_method_results("SOLAR");
+    auto cache_solar = from_cache.optical_method_results("SOLAR");
+    EXPECT_EQ(cache_solar.system_results.front.transmittance.direct_direct,
+              text_solar.system_results.front.transmittance.direct_direct);
+}
+
+TEST_F(TestOpticalStandardCache, Source_Files)
+{
+    auto files = optical_standard_source_files(standard_path.string());
+    ASSERT_FALSE(files.empty());
+    EXPECT_EQ(std::filesystem::path(files[0]), std::filesystem::absolute(standard_path));
+    auto referenced = [&files](std::string const & name) {
+        for(auto const & file : files)
+        {
+            if(std::filesystem::path(file).filename() == name)
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+    EXPECT_TRUE(referenced("ASTM E891 Table 1 Direct AM1_5.ssp"));
+    EXPECT_TRUE(referenced("ASTM E308 1931 Y.dsp"));
+    EXPECT_TRUE(referenced("Color 5nm.wvl"));
+    // Only referenced files, not everything in the directory
+    EXPECT_FALSE(referenced("ASTM E308 1931 X.loc"));
+}
+
+TEST_F(TestOpticalStandardCache, Stale_When_Source_Changes)
+{
+    auto loaded = load_optical_standard(standard_path.string());
+    load_optical_standard_cached(standard_path.string());
+    ASSERT_TRUE(std::filesystem::exists(cache_path));
+    EXPECT_TRUE(optical_standard_cache_is_current(cache_path.string()));
+
+    auto spectrum = directory / "CIE Illuminant D65 1nm.ssp";
+    std::filesystem::last_write_time(
+      spectrum, std::filesystem::last_write_time(spectrum) + std::chrono::hours(1));
+    EXPECT_FALSE(optical_standard_cache_is_current(cache_path.string()));
+
+    // Loading again rebuilds the cache
+    auto reloaded = load_optical_standard_cached(standard_path.string());
+    EXPECT_TRUE(optical_standard_cache_is_current(cache_path.string()));
+    expect_same_standard(reloaded, loaded);
+}
+
+TEST_F(TestOpticalStandardCache, Cache_For_Another_Standard)
+{
+    auto other_standard_path = directory / "CENblackbody.std";
+    auto w5 = load_optical_standard(standard_path.string());
+    auto cen = load_optical_standard(other_standard_path.string());
+
+    // One cache path shared by two standards is rebuilt for each rather than returning the
+    // standard it was last written for
+    expect_same_standard(load_optical_standard_cached(standard_path.string(), cache_path.string()),
+                         w5);
+    expect_same_standard(
+      load_optical_standard_cached(other_standard_path.string(), cache_path.string()), cen);
+    expect_same_standard(load_optical_standard_cached(standard_path.string(), cache_path.string()),
+                         w5);
+}
+
+TEST_F(TestOpticalStandardCache, Invalid_Cache)
+{
+    {
+        std::ofstream out(cache_path, std::ios::binary);
+        out << "not a cache";
+    }
+    EXPECT_FALSE(optical_standard_cache_is_current(cache_path.string()));
+    EXPECT_THROW(read_optical_standard_cache(cache_path.string()), std::runtime_error);
+
+    // An invalid cache is replaced
+    auto standard = load_optical_standard_cached(standard_path.string());
+    EXPECT_TRUE(optical_standard_cache_is_current(cache_path.string()));
+    EXPECT_FALSE(standard.methods.empty());
+}
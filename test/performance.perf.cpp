@@ -0,0 +1,275 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+
+#include <nlohmann/json.hpp>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+// Performance regression tests.  Each test times U, SHGC and the solar optical results of one
+// representative system and compares them with JSON baselines kept in the repository.  A test
+// fails if an operation takes longer than its baseline by more than the tolerance, or makes
+// more allocations than its baseline by more than the allocation tolerance.
+//
+// Baselines live under test/performance_baselines:
+//   allocations/<system>.json          allocation counts, compared when the library is built
+//                                      with WINCALC_ENABLE_ALLOCATION_PROFILING
+//   timings/<machine>/<system>.json    timings in ms for one machine, compared when
+//                                      WINCALC_PERFORMANCE_MACHINE names that machine
+// A missing baseline fails the test.  Record or refresh baselines by running with
+// WINCALC_UPDATE_PERFORMANCE_BASELINES=1 and commit them.  A test with nothing to compare, no
+// allocation profiling and no machine, is skipped.  Environment variables:
+//   WINCALC_PERFORMANCE_BASELINE_DIR         where baselines are kept, default
+//                                            test/performance_baselines
+//   WINCALC_PERFORMANCE_MACHINE              name of the timings directory to use
+//   WINCALC_UPDATE_PERFORMANCE_BASELINES=1   record new baselines instead of comparing
+//   WINCALC_PERFORMANCE_TOLERANCE            allowed slowdown as a fraction, default 0.25
+//   WINCALC_ALLOCATION_TOLERANCE             allowed extra allocations as a fraction,
+//                                            default 0.05
+//   WINCALC_PERFORMANCE_REPETITIONS          runs per operation, the fastest is kept,
+//                                            default 5
+
+using namespace wincalc;
+using namespace window_standards;
+
+namespace
+{
+    struct Measurement
+    {
+        double milliseconds;
+        uint64_t allocations;
+    };
+
+    double environment_value(char const * name, double default_value)
+    {
+        char const * value = std::getenv(name);
+        return value ? std::stod(value) : default_value;
+    }
+
+    std::string environment_string(char const * name)
+    {
+        char const * value = std::getenv(name);
+        return value ? std::string(value) : std::string();
+    }
+
+    std::filesystem::path baseline_directory()
+    {
+        auto directory = environment_string("WINCALC_PERFORMANCE_BASELINE_DIR");
+        if(directory.empty())
+        {
+            return std::filesystem::path(test_dir) / "performance_baselines";
+        }
+        return directory;
+    }
+
+    Measurement measure(std::function<void()> const & operation)
+    {
+        auto repetitions = static_cast<size_t>(
+          std::max(1.0, environment_value("WINCALC_PERFORMANCE_REPETITIONS", 5)));
+        Measurement measurement{std::numeric_limits<double>::max(), 0};
+        for(size_t i = 0; i < repetitions; ++i)
+        {
+            auto allocations = instrumentation::thread_allocations();
+            auto start = std::chrono::steady_clock::now();
+            operation();
+            auto milliseconds = std::chrono::duration<double, std::milli>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count();
+            measurement.milliseconds = std::min(measurement.milliseconds, milliseconds);
+            measurement.allocations = instrumentation::thread_allocations().count
+                                      - allocations.count;
+        }
+        return measurement;
+    }
+
+    // Compares each value with the baseline at path, or writes them as the new baseline
+    void compare_with_baseline(std::string const & description,
+                               std::filesystem::path const & path,
+                               std::map<std::string, double> const & values,
+                               double tolerance)
+    {
+        if(environment_value("WINCALC_UPDATE_PERFORMANCE_BASELINES", 0) != 0)
+        {
+            nlohmann::json baseline(values);
+            std::filesystem::create_directories(path.parent_path());
+            std::ofstream output(path);
+            output << std::setw(4) << baseline << std::endl;
+            std::cout << "Recorded " << description << " baseline " << path.string()
+                      << std::endl;
+            return;
+        }
+
+        if(!std::filesystem::exists(path))
+        {
+            ADD_FAILURE() << "No " << description << " baseline " << path.string()
+                          << ".  Run with WINCALC_UPDATE_PERFORMANCE_BASELINES=1 to record it.";
+            return;
+        }
+        std::ifstream input(path);
+        auto baseline = nlohmann::json::parse(input);
+        for(auto const & [operation, value] : values)
+        {
+            if(baseline.count(operation) == 0)
+            {
+                ADD_FAILURE() << "No " << description << " baseline for " << operation
+                              << " in " << path.string()
+                              << ".  Run with WINCALC_UPDATE_PERFORMANCE_BASELINES=1 to record "
+                                 "it.";
+                continue;
+            }
+            double expected = baseline.at(operation);
+            EXPECT_LE(value, expected * (1 + tolerance))
+              << operation << " " << description << " " << value << " is over its baseline of "
+              << expected << " in " << path.string();
+        }
+    }
+
+    void check_baseline(std::string const & system_name,
+                        std::map<std::string, Measurement> const & measurements)
+    {
+        std::map<std::string, double> milliseconds;
+        std::map<std::string, double> allocations;
+        for(auto const & [operation, measurement] : measurements)
+        {
+            std::cout << system_name << " " << operation << ": " << measurement.milliseconds
+                      << " ms, " << measurement.allocations << " allocations" << std::endl;
+            milliseconds[operation] = measurement.milliseconds;
+            allocations[operation] = static_cast<double>(measurement.allocations);
+        }
+
+        auto directory = baseline_directory();
+        auto machine = environment_string("WINCALC_PERFORMANCE_MACHINE");
+        bool profiling = instrumentation::allocation_profiling_enabled();
+        if(!profiling && machine.empty())
+        {
+            GTEST_SKIP() << "Nothing to compare.  Build with WINCALC_ENABLE_ALLOCATION_PROFILING "
+                            "to compare allocation counts or set WINCALC_PERFORMANCE_MACHINE "
+                            "to compare timings.";
+        }
+
+        if(profiling)
+        {
+            compare_with_baseline("allocation count",
+                                  directory / "allocations" / (system_name + ".json"),
+                                  allocations,
+                                  environment_value("WINCALC_ALLOCATION_TOLERANCE", 0.05));
+        }
+        else
+        {
+            std::cout << "Allocation counts not compared, the library was built without "
+                         "WINCALC_ENABLE_ALLOCATION_PROFILING"
+                      << std::endl;
+        }
+
+        if(!machine.empty())
+        {
+            compare_with_baseline("time (ms)",
+                                  directory / "timings" / machine / (system_name + ".json"),
+                                  milliseconds,
+                                  environment_value("WINCALC_PERFORMANCE_TOLERANCE", 0.25));
+        }
+        else
+        {
+            std::cout << "Timings not compared, WINCALC_PERFORMANCE_MACHINE is not set"
+                      << std::endl;
+        }
+    }
+}   // namespace
+
+class TestPerformance : public testing::Test
+{
+protected:
+    Optical_Standard standard;
+
+    virtual void SetUp()
+    {
+        std::filesystem::path standard_path(test_dir);
+        standard_path /= "standards";
+        standard_path /= "W5_NFRC_2003.std";
+        standard = load_optical_standard(standard_path.string());
+    }
+
+    std::shared_ptr<OpticsParser::ProductData> parse(std::string const & file_name)
+    {
+        std::filesystem::path path(test_dir);
+        path /= "products";
+        path /= file_name;
+        if(path.extension() == ".json")
+        {
+            return OpticsParser::parseJSONFile(path.string());
+        }
+        return OpticsParser::parseBSDFXMLFile(path.string());
+    }
+
+    // Every measurement builds a new system from already converted layers so nothing cached
+    // by an earlier run is reused
+    void check_system(std::string const & system_name,
+                      std::vector<Product_Data_Optical_Thermal> const & layers,
+                      std::vector<Engine_Gap_Info> const & gaps,
+                      std::optional<SingleLayerOptics::CBSDFHemisphere> const & bsdf_hemisphere =
+                        std::optional<SingleLayerOptics::CBSDFHemisphere>())
+    {
+        auto create = [&](Environments const & environments) {
+            return Glazing_System(
+              standard, layers, gaps, 1.0, 1.0, 90, environments, bsdf_hemisphere);
+        };
+        std::map<std::string, Measurement> measurements;
+        measurements["u"] = measure([&]() { create(nfrc_u_environments()).u(); });
+        measurements["shgc"] = measure([&]() { create(nfrc_shgc_environments()).shgc(); });
+        measurements["optical_solar"] = measure(
+          [&]() { create(nfrc_u_environments()).optical_method_results("SOLAR"); });
+        check_baseline(system_name, measurements);
+    }
+};
+
+TEST_F(TestPerformance, NFRC_102_Single)
+{
+    check_system("nfrc_102_single", {convert_to_solid_layer(parse("CLEAR_3.json"))}, {});
+}
+
+TEST_F(TestPerformance, Triple_Low_E)
+{
+    auto low_e = convert_to_solid_layer(parse("igsdb_5051.json"));
+    auto clear = convert_to_solid_layer(parse("CLEAR_3.json"));
+    check_system("triple_low_e",
+                 {low_e, clear, low_e},
+                 {Engine_Gap_Info(Gases::GasDef::Argon, 0.0127),
+                  Engine_Gap_Info(Gases::GasDef::Argon, 0.0127)});
+}
+
+TEST_F(TestPerformance, Venetian_Clear)
+{
+    auto venetian =
+      create_venetian_blind(Venetian_Geometry{45, 0.05, 0.07, 0.03}, parse("igsdb_12852.json"));
+    check_system("venetian_clear",
+                 {venetian, convert_to_solid_layer(parse("CLEAR_3.json"))},
+                 {Engine_Gap_Info(Gases::GasDef::Air, 0.0127)},
+                 SingleLayerOptics::CBSDFHemisphere::create(SingleLayerOptics::BSDFBasis::Quarter));
+}
+
+TEST_F(TestPerformance, BSDF_XML)
+{
+    auto shade = convert_to_solid_layer(parse("2011-SA1.XML"));
+    shade.thermal_data->opening_top = 0.01;
+    shade.thermal_data->opening_bottom = 0.01;
+    check_system("bsdf_xml",
+                 {convert_to_solid_layer(parse("CLEAR_3.json")), shade},
+                 {Engine_Gap_Info(Gases::GasDef::Air, 0.0127)},
+                 SingleLayerOptics::CBSDFHemisphere::create(SingleLayerOptics::BSDFBasis::Full));
+}
+
+TEST_F(TestPerformance, PV_Single)
+{
+    check_system("pv_single", {convert_to_solid_layer(parse("generic_pv.json"))}, {});
+}
@@ -0,0 +1,171 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+
+using namespace wincalc;
+using namespace window_standards;
+
+class TestProductLibrary : public testing::Test
+{
+protected:
+    std::vector<std::pair<std::string, Product_Data_Optical_Thermal>> products;
+    std::filesystem::path library_path;
+
+    std::shared_ptr<OpticsParser::ProductData> parse(std::string const & file_name)
+    {
+        std::filesystem::path path(test_dir);
+        path /= "products";
+        path /= file_name;
+        return OpticsParser::parseJSONFile(path.string());
+    }
+
+    virtual void SetUp()
+    {
+        products.emplace_back("CLEAR_3", convert_to_solid_layer(parse("CLEAR_3.json")));
+        products.emplace_back("generic_pv", convert_to_solid_layer(parse("generic_pv.json")));
+        products.emplace_back("woven_shade", convert_to_solid_layer(parse("woven_shade.json")));
+        products.emplace_back("perforated_screen",
+                              convert_to_solid_layer(parse("perforated_screen.json")));
+
+        std::filesystem::path bsdf_path(test_dir);
+        bsdf_path /= "products";
+        bsdf_path /= "2011-SA1.XML";
+        products.emplace_back(
+          "2011-SA1", convert_to_solid_layer(OpticsParser::parseBSDFXMLFile(bsdf_path.string())));
+
+        Venetian_Geometry geometry{45, 0.05, 0.07, 0.03};
+        products.emplace_back("venetian",
+                              create_venetian_blind(geometry, parse("igsdb_12852.json")));
+
+        auto hemispheric = std::make_shared<Product_Data_Dual_Band_Optical_Hemispheric>(
+          0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.003, 0.0, 0.0, 0.84, 0.84, 0.1);
+        auto hemispheric_thermal = std::make_shared<Product_Data_Thermal>(1.0, 0.003);
+        products.emplace_back("hemispheric",
+                              Product_Data_Optical_Thermal{hemispheric, hemispheric_thermal});
+
+        // A row without a direct component has to be stored as well
+        auto clear_3 = products.front().second;
+        auto rows = std::dynamic_pointer_cast<Product_Data_N_Band_Optical>(clear_3.optical_data)
+                      ->wavelength_data;
+        OpticsParser::WLData no_direct(2.6, OpticsParser::MeasurementComponent{0, 0, 0, 0});
+        no_direct.directComponent.reset();
+        rows.push_back(no_direct);
+        auto missing_direct = std::make_shared<Product_Data_N_Band_Optical>(
+          FenestrationCommon::MaterialType::Monolithic, 0.003048, rows);
+        products.emplace_back("missing_direct",
+                              Product_Data_Optical_Thermal{missing_direct, clear_3.thermal_data});
+
+        library_path = std::filesystem::temp_directory_path() / "wincalc_test_library.wcpl";
+        write_product_library(library_path.string(), products);
+    }
+
+    virtual void TearDown()
+    {
+        std::filesystem::remove(library_path);
+    }
+};
+
+TEST_F(TestProductLibrary, Round_Trip)
+{
+    Product_Library library(library_path.string());
+    EXPECT_EQ(library.size(), products.size());
+    for(auto const & product : products)
+    {
+        ASSERT_TRUE(library.contains(product.first));
+        auto loaded = library.product(product.first);
+        // Encoding covers every stored value so equal encodings mean equal products
+        EXPECT_EQ(encode_product(product.second), encode_product(loaded)) << product.first;
+    }
+}
+
+TEST_F(TestProductLibrary, Products_Are_Cached)
+{
+    Product_Library library(library_path.string());
+    auto first = library.product("CLEAR_3");
+    auto second = library.product("CLEAR_3");
+    EXPECT_EQ(first.optical_data, second.optical_data);
+    EXPECT_EQ(first.thermal_data, second.thermal_data);
+}
+
+TEST_F(TestProductLibrary, Same_Results_As_Parsed_Products)
+{
+    std::filesystem::path standard_path(test_dir);
+    standard_path /= "standards";
+    standard_path /= "W5_NFRC_2003.std";
+    Optical_Standard standard = load_optical_standard(standard_path.string());
+
+    Engine_Gap_Info air_gap(Gases::GasDef::Air, 0.0127);
+    std::vector<Engine_Gap_Info> gaps{air_gap};
+
+    Product_Library library(library_path.string());
+    auto clear_3 = products.front().second;
+    Glazing_System parsed(
+      standard, std::vector<Product_Data_Optical_Thermal>{clear_3, clear_3}, gaps);
+    Glazing_System loaded(standard, library.products({"CLEAR_3", "CLEAR_3"}), gaps);
+    EXPECT_EQ(parsed.u(), loaded.u());
+    EXPECT_EQ(parsed.shgc(), loaded.shgc());
+}
+
+TEST_F(TestProductLibrary, Rows_Without_Direct_Component)
+{
+    std::filesystem::path standard_path(test_dir);
+    standard_path /= "standards";
+    standard_path /= "W5_NFRC_2003.std";
+    Optical_Standard standard = load_optical_standard(standard_path.string());
+
+    Product_Library library(library_path.string());
+    auto stored = products.back().second;
+    auto loaded = library.product("missing_direct");
+    EXPECT_EQ(stored.optical_data->wavelengths(), loaded.optical_data->wavelengths());
+    EXPECT_EQ(stored.optical_data->wavelengths().back(), 2.6);
+
+    Glazing_System from_rows(standard, std::vector<Product_Data_Optical_Thermal>{stored});
+    Glazing_System from_library(standard, std::vector<Product_Data_Optical_Thermal>{loaded});
+    EXPECT_EQ(from_rows.optical_method_results("SOLAR")
+                .system_results.front.transmittance.direct_hemispherical,
+              from_library.optical_method_results("SOLAR")
+                .system_results.front.transmittance.direct_hemispherical);
+    EXPECT_EQ(from_rows.u(), from_library.u());
+}
+
+TEST_F(TestProductLibrary, Errors)
+{
+    Product_Library library(library_path.string());
+    EXPECT_THROW(library.product("missing"), std::runtime_error);
+
+    Product_Library_Writer writer(library_path.string() + ".duplicate");
+    writer.add("CLEAR_3", products.front().second);
+    EXPECT_THROW(writer.add("CLEAR_3", products.front().second), std::runtime_error);
+    writer.finish();
+    std::filesystem::remove(library_path.string() + ".duplicate");
+}
+
+TEST_F(TestProductLibrary, Corrupt_Record_Detected)
+{
+    {
+        // Change a byte in the first record.  The first record starts right after the 48
+        // byte header and is much larger than 100 bytes.
+        std::fstream file(library_path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekg(100);
+        char c;
+        file.read(&c, 1);
+        c = static_cast<char>(c ^ 0xFF);
+        file.seekp(100);
+        file.write(&c, 1);
+    }
+    Product_Library library(library_path.string());
+    EXPECT_THROW(library.product(products.front().first), std::runtime_error);
+}
+
+TEST_F(TestProductLibrary, Not_A_Library)
+{
+    std::filesystem::path clear_3_path(test_dir);
+    clear_3_path /= "products";
+    clear_3_path /= "CLEAR_3.json";
+    EXPECT_THROW(Product_Library library(clear_3_path.string()), std::runtime_error);
+}
@@ -0,0 +1,176 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <filesystem>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+
+using namespace wincalc;
+
+class TestResultColumns : public testing::Test
+{
+protected:
+    std::filesystem::path result_path;
+
+    // Results with values that depend on the row so rows can be told apart when read back
+    WCE_Optical_Results optical_results(size_t row, size_t layers) const
+    {
+        WCE_Optical_Results results;
+        auto simple = [row](double offset) {
+            return WCE_Optical_Result_Simple<double>{row + offset,
+                                                     row + offset + 0.1,
+                                                     row + offset + 0.2,
+                                                     row + offset + 0.3,
+                                                     std::nullopt};
+        };
+        results.system_results.front.transmittance = simple(0);
+        results.system_results.front.reflectance = simple(1);
+        results.system_results.back.transmittance = simple(2);
+        results.system_results.back.reflectance = simple(3);
+        for(size_t i = 0; i < layers; ++i)
+        {
+            WCE_Optical_Result_By_Side<WCE_Optical_Result_Layer<double>> layer;
+            layer.front.absorptance = {row + i * 0.01, 0, 0, 0, 0, 0};
+            layer.back.absorptance = {0, row - i * 0.01, 0, 0, 0, 0};
+            results.layer_results.push_back(layer);
+        }
+        return results;
+    }
+
+    Thermal_Report thermal_report(size_t row) const
+    {
+        Thermal_Report report{};
+        report.u_environment.u = 1.0 + row;
+        report.shgc_environment.shgc = 0.5 + row;
+        report.u_environment.layer_temperatures_u = std::vector<double>(row % 3, 280.0 + row);
+        report.shgc_environment.deflection_shgc.deflection_max = {0.001 * row};
+        report.shgc_environment.deflection_shgc.passes = row;
+        return report;
+    }
+
+    virtual void SetUp()
+    {
+        result_path = std::filesystem::temp_directory_path() / "wincalc_result_columns_test.wcrt";
+    }
+
+    virtual void TearDown()
+    {
+        std::filesystem::remove(result_path);
+    }
+};
+
+TEST_F(TestResultColumns, Round_Trip)
+{
+    const size_t rows = 7;
+    {
+        // Batches smaller than the number of rows so several batches are written and read
+        Result_Column_Writer writer(result_path.string(), 3);
+        Result_Row row;
+        for(size_t i = 0; i < rows; ++i)
+        {
+            row.clear();
+            row.add("id", static_cast<double>(i));
+            row.add("solar", optical_results(i, 1 + i % 2));
+            row.add("thermal", thermal_report(i));
+            writer.add(row);
+        }
+        EXPECT_EQ(writer.rows(), rows);
+        writer.finish();
+    }
+
+    auto table = read_result_columns(result_path.string());
+    EXPECT_EQ(table.rows, rows);
+    EXPECT_EQ(table.columns.front().name, "id");
+
+    auto const & t_dd = table.column("solar_system_front_transmittance_direct_direct");
+    auto const & r_dh = table.column("solar_system_back_reflectance_direct_hemispherical");
+    auto const & u = table.column("thermal_u_environment_u");
+    auto const & passes = table.column("thermal_shgc_environment_deflection_shgc_passes");
+    EXPECT_FALSE(t_dd.list);
+    ASSERT_EQ(t_dd.values.size(), rows);
+    for(size_t i = 0; i < rows; ++i)
+    {
+        EXPECT_DOUBLE_EQ(t_dd.values[i], i);
+        EXPECT_DOUBLE_EQ(r_dh.values[i], i + 3.3);
+        EXPECT_DOUBLE_EQ(u.values[i], 1.0 + i);
+        EXPECT_DOUBLE_EQ(passes.values[i], i);
+    }
+
+    auto const & absorptance = table.column("solar_layer_front_absorptance_total_direct");
+    auto const & temperatures = table.column("thermal_u_environment_layer_temperatures_u");
+    EXPECT_TRUE(absorptance.list);
+    ASSERT_EQ(absorptance.offsets.size(), rows + 1);
+    ASSERT_EQ(temperatures.offsets.size(), rows + 1);
+    for(size_t i = 0; i < rows; ++i)
+    {
+        auto layers = 1 + i % 2;
+        ASSERT_EQ(absorptance.offsets[i + 1] - absorptance.offsets[i], layers);
+        for(size_t layer = 0; layer < layers; ++layer)
+        {
+            EXPECT_DOUBLE_EQ(absorptance.values[absorptance.offsets[i] + layer],
+                             i + layer * 0.01);
+        }
+        EXPECT_EQ(temperatures.offsets[i + 1] - temperatures.offsets[i], i % 3);
+    }
+}
+
+TEST_F(TestResultColumns, Color_Columns)
+{
+    WCE_Color_Results color{};
+    color.system_results.front.transmittance.direct_direct =
+      Color_Result(Trichromatic{}, WinCalc_RGB{}, Lab{});
+    color.system_results.front.transmittance.direct_direct.lab.L = 95.5;
+    color.system_results.front.transmittance.direct_direct.rgb.G = 250;
+    {
+        Result_Column_Writer writer(result_path.string());
+        Result_Row row;
+        row.add("color", color);
+        writer.add(row);
+    }
+    auto table = read_result_columns(result_path.string());
+    EXPECT_EQ(table.columns.size(), 4u * 4u * 9u);
+    EXPECT_DOUBLE_EQ(table.column("color_system_front_transmittance_direct_direct_L").values[0],
+                     95.5);
+    EXPECT_DOUBLE_EQ(table.column("color_system_front_transmittance_direct_direct_G").values[0],
+                     250);
+}
+
+TEST_F(TestResultColumns, Errors)
+{
+    Result_Column_Writer writer(result_path.string());
+    Result_Row row;
+    row.add("u", 1.0);
+    row.add("layers", std::vector<double>{1, 2});
+    writer.add(row);
+
+    // A reused row checks the names of the columns it already has
+    row.clear();
+    EXPECT_THROW(row.add("shgc", 1.0), std::runtime_error);
+
+    // Rows must match the columns of the first row
+    Result_Row missing_column;
+    missing_column.add("u", 2.0);
+    EXPECT_THROW(writer.add(missing_column), std::runtime_error);
+    Result_Row other_columns;
+    other_columns.add("u", 2.0);
+    other_columns.add("temperatures", std::vector<double>{1, 2});
+    EXPECT_THROW(writer.add(other_columns), std::runtime_error);
+    writer.finish();
+    EXPECT_THROW(writer.add(row), std::runtime_error);
+
+    auto table = read_result_columns(result_path.string());
+    EXPECT_EQ(table.rows, 1u);
+
+    EXPECT_THROW(read_result_columns((result_path.string() + ".missing")), std::runtime_error);
+}
+
+TEST_F(TestResultColumns, Empty)
+{
+    {
+        Result_Column_Writer writer(result_path.string());
+    }
+    auto table = read_result_columns(result_path.string());
+    EXPECT_EQ(table.rows, 0u);
+    EXPECT_TRUE(table.columns.empty());
+}
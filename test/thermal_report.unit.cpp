@@ -0,0 +1,154 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <filesystem>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+
+using namespace wincalc;
+using namespace window_standards;
+
+class TestThermalReport : public testing::Test
+{
+protected:
+    std::shared_ptr<Glazing_System> glazing_system_u;
+    std::shared_ptr<Glazing_System> glazing_system_shgc;
+
+    virtual void SetUp()
+    {
+        std::filesystem::path clear_3_path(test_dir);
+        clear_3_path /= "products";
+        clear_3_path /= "CLEAR_3.json";
+
+        std::vector<std::shared_ptr<OpticsParser::ProductData>> products;
+        OpticsParser::Parser parser;
+        auto clear_3 = parser.parseJSONFile(clear_3_path.string());
+        products.push_back(clear_3);
+        products.push_back(clear_3);
+
+        Engine_Gap_Info air_gap(Gases::GasDef::Air, 0.0127);
+        std::vector<Engine_Gap_Info> gaps;
+        gaps.push_back(air_gap);
+
+        std::filesystem::path standard_path(test_dir);
+        standard_path /= "standards";
+        standard_path /= "W5_NFRC_2003.std";
+        Optical_Standard standard = load_optical_standard(standard_path.string());
+
+        glazing_system_u = std::make_shared<Glazing_System>(
+          standard, products, gaps, 1.0, 1.0, 90, nfrc_u_environments());
+        glazing_system_shgc = std::make_shared<Glazing_System>(
+          standard, products, gaps, 1.0, 1.0, 90, nfrc_shgc_environments());
+    }
+};
+
+void compare_environment_results(Thermal_Environment_Results const & report,
+                                 std::shared_ptr<Glazing_System> const & glazing_system,
+                                 double theta,
+                                 double phi)
+{
+    using Tarcog::ISO15099::System;
+    const double tolerance = 1e-6;
+
+    EXPECT_NEAR(report.u, glazing_system->u(theta, phi), tolerance);
+    EXPECT_NEAR(report.shgc, glazing_system->shgc(theta, phi), tolerance);
+    EXPECT_NEAR(
+      report.relative_heat_gain, glazing_system->relative_heat_gain(theta, phi), tolerance);
+    EXPECT_NEAR(report.system_effective_conductivity_u,
+                glazing_system->system_effective_conductivity(System::Uvalue, theta, phi),
+                tolerance);
+    EXPECT_NEAR(report.system_effective_conductivity_shgc,
+                glazing_system->system_effective_conductivity(System::SHGC, theta, phi),
+                tolerance);
+
+    auto compare = [tolerance](std::vector<double> const & expected,
+                               std::vector<double> const & actual) {
+        ASSERT_EQ(expected.size(), actual.size());
+        for(size_t i = 0; i < expected.size(); ++i)
+        {
+            EXPECT_NEAR(expected[i], actual[i], tolerance);
+        }
+    };
+    compare(glazing_system->solid_layers_effective_conductivities(System::Uvalue, theta, phi),
+            report.solid_layers_effective_conductivities_u);
+    compare(glazing_system->solid_layers_effective_conductivities(System::SHGC, theta, phi),
+            report.solid_layers_effective_conductivities_shgc);
+    compare(glazing_system->gap_layers_effective_conductivities(System::Uvalue, theta, phi),
+            report.gap_layers_effective_conductivities_u);
+    compare(glazing_system->gap_layers_effective_conductivities(System::SHGC, theta, phi),
+            report.gap_layers_effective_conductivities_shgc);
+    compare(glazing_system->layer_temperatures(System::Uvalue, theta, phi),
+            report.layer_temperatures_u);
+    compare(glazing_system->layer_temperatures(System::SHGC, theta, phi),
+            report.layer_temperatures_shgc);
+}
+
+TEST_F(TestThermalReport, Matches_Individual_Calculations)
+{
+    auto report = glazing_system_u->thermal_report();
+    compare_environment_results(report.u_environment, glazing_system_u, 0, 0);
+    compare_environment_results(report.shgc_environment, glazing_system_shgc, 0, 0);
+}
+
+TEST_F(TestThermalReport, Matches_Individual_Calculations_Off_Normal)
+{
+    auto report = glazing_system_u->thermal_report(
+      nfrc_u_environments(), nfrc_shgc_environments(), 15, 270);
+    compare_environment_results(report.u_environment, glazing_system_u, 15, 270);
+    compare_environment_results(report.shgc_environment, glazing_system_shgc, 15, 270);
+}
+
+TEST_F(TestThermalReport, Each_Environment_Solved_Once)
+{
+    auto report = glazing_system_u->thermal_report();
+    auto statistics = glazing_system_u->statistics();
+
+    if(!instrumentation::enabled())
+    {
+        EXPECT_EQ(statistics[instrumentation::Counter::TARCOG_QUERIES], 0u);
+        return;
+    }
+
+    // One IGU for both environments and one U and one SHGC query for each
+    EXPECT_EQ(statistics[instrumentation::Counter::IGU_CACHE_MISS], 1u);
+    EXPECT_EQ(statistics[instrumentation::Counter::TARCOG_QUERIES], 4u);
+    // The iterations counted by the queries are the ones each solved system still reports
+    // once all of its results were read, so reading them did not solve anything again
+    auto reported_iterations = report.u_environment.deflection_u.solver_iterations
+                               + report.u_environment.deflection_shgc.solver_iterations
+                               + report.shgc_environment.deflection_u.solver_iterations
+                               + report.shgc_environment.deflection_shgc.solver_iterations;
+    EXPECT_GT(reported_iterations, 0u);
+    EXPECT_EQ(statistics[instrumentation::Counter::TARCOG_ITERATIONS], reported_iterations);
+}
+
+TEST_F(TestThermalReport, Deflection)
+{
+    glazing_system_u->enable_deflection(true);
+    glazing_system_u->set_applied_loads({12, 23});
+    auto report = glazing_system_u->thermal_report();
+
+    for(auto const & environment : {report.u_environment, report.shgc_environment})
+    {
+        for(auto const & deflection : {environment.deflection_u, environment.deflection_shgc})
+        {
+            EXPECT_EQ(deflection.passes, 1u);
+            EXPECT_TRUE(deflection.converged);
+            ASSERT_EQ(deflection.deflection_max.size(), 2u);
+            EXPECT_NE(deflection.deflection_max, std::vector<double>(2, 0.0));
+            EXPECT_EQ(deflection.panes_load.size(), 2u);
+        }
+    }
+
+    // The U-factor environment's deflection is the same as the individual calculation's
+    auto expected =
+      glazing_system_u->calc_deflection_properties(Tarcog::ISO15099::System::Uvalue);
+    auto const & actual = report.u_environment.deflection_u;
+    for(size_t i = 0; i < expected.deflection_max.size(); ++i)
+    {
+        EXPECT_NEAR(expected.deflection_max[i], actual.deflection_max[i], 1e-9);
+        EXPECT_NEAR(expected.deflection_mean[i], actual.deflection_mean[i], 1e-9);
+        EXPECT_NEAR(expected.panes_load[i], actual.panes_load[i], 1e-6);
+    }
+}
@@ -0,0 +1,116 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <map>
+#include <sstream>
+
+#include "wincalc/wincalc.h"
+#include "paths.h"
+
+
+using namespace wincalc;
+using namespace window_standards;
+
+class TestTrace : public testing::Test
+{
+protected:
+    std::shared_ptr<Glazing_System> glazing_system;
+
+    virtual void SetUp()
+    {
+        std::filesystem::path products(test_dir);
+        products /= "products";
+
+        OpticsParser::Parser parser;
+        auto clear_3 = parser.parseJSONFile((products / "CLEAR_3.json").string());
+
+        std::filesystem::path standard_path(test_dir);
+        standard_path /= "standards";
+        standard_path /= "W5_NFRC_2003.std";
+        Optical_Standard standard = load_optical_standard(standard_path.string());
+
+        std::vector<std::shared_ptr<OpticsParser::ProductData>> products_list{clear_3, clear_3};
+        std::vector<Engine_Gap_Info> gaps{Engine_Gap_Info(Gases::GasDef::Air, 0.0127)};
+
+        glazing_system = std::make_shared<Glazing_System>(standard, products_list, gaps);
+    }
+
+    virtual void TearDown()
+    {
+        trace::stop();
+    }
+};
+
+TEST_F(TestTrace, Nothing_Recorded_Unless_Started)
+{
+    trace::start();
+    trace::stop();
+    glazing_system->u();
+    EXPECT_TRUE(trace::events().empty());
+}
+
+TEST_F(TestTrace, Begin_And_End_Events_Balance_On_Each_Thread)
+{
+    trace::start();
+    glazing_system->shgc();
+    std::vector<Deflection_Sweep_Point> points(4);
+    glazing_system->deflection_sweep(points, Tarcog::ISO15099::System::Uvalue, 0, 0, 2);
+    trace::stop();
+
+    auto events = trace::events();
+    if(!trace::enabled())
+    {
+        EXPECT_TRUE(events.empty());
+        return;
+    }
+
+    std::map<uint32_t, std::vector<std::string>> open_events;
+    bool found_shgc = false;
+    for(auto const & event : events)
+    {
+        auto & open = open_events[event.thread];
+        if(event.phase == 'B')
+        {
+            open.push_back(event.name);
+            found_shgc = found_shgc || event.name == "Glazing_System::shgc";
+        }
+        else
+        {
+            ASSERT_FALSE(open.empty());
+            EXPECT_EQ(open.back(), event.name);
+            open.pop_back();
+        }
+    }
+    EXPECT_TRUE(found_shgc);
+    // The calling thread and the two sweep workers
+    EXPECT_EQ(open_events.size(), 3u);
+    for(auto const & open : open_events)
+    {
+        EXPECT_TRUE(open.second.empty());
+    }
+}
+
+TEST_F(TestTrace, Chrome_Trace_Format)
+{
+    trace::start();
+    {
+        WINCALC_TRACE_SCOPE_ARGUMENTS("test \"event\"",
+                                      {"layer", static_cast<int64_t>(2)},
+                                      {"method", std::string("SOLAR")});
+    }
+    trace::stop();
+
+    std::stringstream output;
+    trace::write_chrome_trace(output);
+    auto json = output.str();
+    EXPECT_EQ(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0u);
+    if(!trace::enabled())
+    {
+        EXPECT_EQ(json.find("\"ph\""), std::string::npos);
+        return;
+    }
+    EXPECT_NE(json.find("\"name\":\"test \\\"event\\\"\""), std::string::npos);
+    EXPECT_NE(json.find("\"ph\":\"B\""), std::string::npos);
+    EXPECT_NE(json.find("\"ph\":\"E\""), std::string::npos);
+    EXPECT_NE(json.find("\"args\":{\"layer\":2,\"method\":\"SOLAR\"}"), std::string::npos);
+}
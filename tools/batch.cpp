@@ -0,0 +1,604 @@
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+
+#include "batch.h"
+#include "util.h"
+
+namespace wincalc::batch
+{
+    namespace
+    {
+        nlohmann::json const & required(nlohmann::json const & object, char const * key)
+        {
+            if(!object.is_object() || !object.contains(key))
+            {
+                std::stringstream msg;
+                msg << "Missing \"" << key << "\" in " << object.dump();
+                throw std::runtime_error(msg.str());
+            }
+            return object.at(key);
+        }
+
+        Gases::GasDef gas(std::string const & name)
+        {
+            auto lower = to_lower(name);
+            if(lower == "air")
+            {
+                return Gases::GasDef::Air;
+            }
+            if(lower == "argon")
+            {
+                return Gases::GasDef::Argon;
+            }
+            if(lower == "krypton")
+            {
+                return Gases::GasDef::Krypton;
+            }
+            if(lower == "xenon")
+            {
+                return Gases::GasDef::Xenon;
+            }
+            std::stringstream msg;
+            msg << "Unknown gas " << name;
+            throw std::runtime_error(msg.str());
+        }
+
+        Engine_Gap_Info gap(nlohmann::json const & definition)
+        {
+            double thickness = required(definition, "thickness");
+            double pressure = definition.value("pressure", Gases::DefaultPressure);
+            if(definition.contains("gases"))
+            {
+                std::vector<Predefined_Gas_Mixture_Component> components;
+                for(auto const & component : definition.at("gases"))
+                {
+                    components.push_back(
+                      {gas(required(component, "gas")), required(component, "percent")});
+                }
+                return Engine_Gap_Info(components, thickness, pressure);
+            }
+            return Engine_Gap_Info(gas(required(definition, "gas")), thickness, pressure);
+        }
+
+        Tarcog::ISO15099::BoundaryConditionsCoeffModel
+          coefficient_model(std::string const & name)
+        {
+            auto lower = to_lower(name);
+            if(lower == "calculate_h")
+            {
+                return Tarcog::ISO15099::BoundaryConditionsCoeffModel::CalculateH;
+            }
+            if(lower == "h_prescribed")
+            {
+                return Tarcog::ISO15099::BoundaryConditionsCoeffModel::HPrescribed;
+            }
+            if(lower == "hc_prescribed")
+            {
+                return Tarcog::ISO15099::BoundaryConditionsCoeffModel::HcPrescribed;
+            }
+            std::stringstream msg;
+            msg << "Unknown coefficient model " << name;
+            throw std::runtime_error(msg.str());
+        }
+
+        Tarcog::ISO15099::AirHorizontalDirection air_direction(std::string const & name)
+        {
+            auto lower = to_lower(name);
+            if(lower == "none")
+            {
+                return Tarcog::ISO15099::AirHorizontalDirection::None;
+            }
+            if(lower == "leeward")
+            {
+                return Tarcog::ISO15099::AirHorizontalDirection::Leeward;
+            }
+            if(lower == "windward")
+            {
+                return Tarcog::ISO15099::AirHorizontalDirection::Windward;
+            }
+            std::stringstream msg;
+            msg << "Unknown air direction " << name;
+            throw std::runtime_error(msg.str());
+        }
+
+        Environment environment(nlohmann::json const & definition)
+        {
+            return Environment(required(definition, "air_temperature"),
+                               required(definition, "pressure"),
+                               required(definition, "convection_coefficient"),
+                               coefficient_model(required(definition, "coefficient_model")),
+                               required(definition, "radiation_temperature"),
+                               required(definition, "emissivity"),
+                               definition.value("air_speed", 0.0),
+                               air_direction(definition.value("air_direction", "none")),
+                               definition.value("direct_solar_radiation", 0.0));
+        }
+
+        Environments environments(nlohmann::json const & request,
+                                  char const * key,
+                                  Environments const & default_environments)
+        {
+            if(!request.contains(key))
+            {
+                return default_environments;
+            }
+            auto const & definition = request.at(key);
+            if(definition.is_string())
+            {
+                auto name = to_lower(definition);
+                if(name == "nfrc_u")
+                {
+                    return nfrc_u_environments();
+                }
+                if(name == "nfrc_shgc")
+                {
+                    return nfrc_shgc_environments();
+                }
+                std::stringstream msg;
+                msg << "Unknown environments " << name;
+                throw std::runtime_error(msg.str());
+            }
+            return Environments(environment(required(definition, "outside")),
+                                environment(required(definition, "inside")));
+        }
+
+        SingleLayerOptics::BSDFBasis bsdf_basis(std::string const & name)
+        {
+            auto lower = to_lower(name);
+            if(lower == "small")
+            {
+                return SingleLayerOptics::BSDFBasis::Small;
+            }
+            if(lower == "quarter")
+            {
+                return SingleLayerOptics::BSDFBasis::Quarter;
+            }
+            if(lower == "half")
+            {
+                return SingleLayerOptics::BSDFBasis::Half;
+            }
+            if(lower == "full")
+            {
+                return SingleLayerOptics::BSDFBasis::Full;
+            }
+            std::stringstream msg;
+            msg << "Unknown BSDF basis " << name;
+            throw std::runtime_error(msg.str());
+        }
+
+        Perforated_Geometry::Type perforation_type(std::string const & name)
+        {
+            auto lower = to_lower(name);
+            if(lower == "circular")
+            {
+                return Perforated_Geometry::Type::CIRCULAR;
+            }
+            if(lower == "rectangular")
+            {
+                return Perforated_Geometry::Type::RECTANGULAR;
+            }
+            if(lower == "square")
+            {
+                return Perforated_Geometry::Type::SQUARE;
+            }
+            std::stringstream msg;
+            msg << "Unknown perforation type " << name;
+            throw std::runtime_error(msg.str());
+        }
+
+        std::shared_ptr<OpticsParser::ProductData> parse_product(std::string const & path)
+        {
+            if(to_lower(std::filesystem::path(path).extension().string()) == ".xml")
+            {
+                return OpticsParser::parseBSDFXMLFile(path);
+            }
+            return OpticsParser::parseJSONFile(path);
+        }
+
+        void add_columns(nlohmann::json & result, Result_Row const & row)
+        {
+            auto const & values = row.values();
+            for(auto const & column : row.columns())
+            {
+                if(column.list)
+                {
+                    result[column.name] =
+                      std::vector<double>(values.begin() + column.offset,
+                                          values.begin() + column.offset + column.size);
+                }
+                else
+                {
+                    result[column.name] = values[column.offset];
+                }
+            }
+        }
+
+        // Thermal outputs that need the system set to the U-factor or SHGC environment.  Setting
+        // the environment resets the system, so calculate groups these by environment.
+        bool is_u_output(std::string const & output)
+        {
+            return output == "u" || output == "layer_temperatures_u";
+        }
+
+        bool is_shgc_output(std::string const & output)
+        {
+            return output == "shgc" || output == "relative_heat_gain"
+                   || output == "layer_temperatures_shgc";
+        }
+
+        nlohmann::json thermal_output(Glazing_System & system,
+                                      std::string const & output,
+                                      double theta,
+                                      double phi)
+        {
+            if(output == "u")
+            {
+                return system.u(theta, phi);
+            }
+            if(output == "shgc")
+            {
+                return system.shgc(theta, phi);
+            }
+            if(output == "relative_heat_gain")
+            {
+                return system.relative_heat_gain(theta, phi);
+            }
+            if(output == "layer_temperatures_u")
+            {
+                return system.layer_temperatures(Tarcog::ISO15099::System::Uvalue, theta, phi);
+            }
+            return system.layer_temperatures(Tarcog::ISO15099::System::SHGC, theta, phi);
+        }
+    }   // namespace
+
+    Calculation_Cache::Calculation_Cache(std::string base_directory,
+                                         std::string const & library_path,
+                                         std::string default_standard,
+                                         std::string standard_cache_directory) :
+        base_directory(std::move(base_directory)),
+        default_standard_path(std::move(default_standard)),
+        standard_cache_directory(std::move(standard_cache_directory))
+    {
+        if(!library_path.empty())
+        {
+            library = std::make_unique<Product_Library>(resolve(library_path));
+        }
+        if(!this->standard_cache_directory.empty())
+        {
+            std::filesystem::create_directories(this->standard_cache_directory);
+        }
+    }
+
+    std::string Calculation_Cache::resolve(std::string const & path) const
+    {
+        std::filesystem::path result(path);
+        if(result.is_relative() && !base_directory.empty())
+        {
+            result = std::filesystem::path(base_directory) / result;
+        }
+        return result.lexically_normal().string();
+    }
+
+    std::string Calculation_Cache::standard_cache_path(std::string const & standard_path) const
+    {
+        if(standard_cache_directory.empty())
+        {
+            return std::string();
+        }
+        // Standards with the same file name in different directories need their own caches
+        std::stringstream name;
+        name << std::filesystem::path(standard_path).filename().string() << "." << std::hex
+             << std::hash<std::string>()(standard_path) << ".cache";
+        return (std::filesystem::path(standard_cache_directory) / name.str()).string();
+    }
+
+    template<typename T, typename Load>
+    T Calculation_Cache::cached(std::map<std::string, std::shared_future<T>> & entries,
+                                std::string const & key,
+                                uint64_t & hits,
+                                uint64_t & misses,
+                                Load const & load)
+    {
+        std::promise<T> promise;
+        std::shared_future<T> future;
+        bool loading = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto entry = entries.find(key);
+            if(entry != entries.end())
+            {
+                ++hits;
+                future = entry->second;
+            }
+            else
+            {
+                ++misses;
+                future = promise.get_future().share();
+                entries.emplace(key, future);
+                loading = true;
+            }
+        }
+        if(loading)
+        {
+            try
+            {
+                promise.set_value(load());
+            }
+            catch(...)
+            {
+                promise.set_exception(std::current_exception());
+                std::lock_guard<std::mutex> lock(mutex);
+                entries.erase(key);
+            }
+        }
+        return future.get();
+    }
+
+    std::shared_ptr<window_standards::Optical_Standard const>
+      Calculation_Cache::standard(std::string const & path)
+    {
+        auto resolved = resolve(path);
+        return cached(standards,
+                      resolved,
+                      cache_statistics.standard_hits,
+                      cache_statistics.standard_misses,
+                      [this, &resolved]() {
+                          return std::make_shared<window_standards::Optical_Standard const>(
+                            load_optical_standard_cached(resolved, standard_cache_path(resolved)));
+                      });
+    }
+
+    Product_Data_Optical_Thermal Calculation_Cache::product_file(std::string const & path)
+    {
+        auto resolved = resolve(path);
+        return cached(products,
+                      "file:" + resolved,
+                      cache_statistics.product_hits,
+                      cache_statistics.product_misses,
+                      [&resolved]() { return convert_to_solid_layer(parse_product(resolved)); });
+    }
+
+    Product_Data_Optical_Thermal Calculation_Cache::library_product(std::string const & id)
+    {
+        if(!library)
+        {
+            std::stringstream msg;
+            msg << "Product " << id << " requested by id but no product library is open";
+            throw std::runtime_error(msg.str());
+        }
+        // The library keeps its own decoded products, this only counts the lookups
+        return cached(products,
+                      "id:" + id,
+                      cache_statistics.product_hits,
+                      cache_statistics.product_misses,
+                      [this, &id]() { return library->product(id); });
+    }
+
+    Product_Data_Optical_Thermal Calculation_Cache::shade(nlohmann::json const & definition)
+    {
+        return cached(
+          shades,
+          definition.dump(),
+          cache_statistics.shade_hits,
+          cache_statistics.shade_misses,
+          [this, &definition]() {
+              auto type = to_lower(required(definition, "shade"));
+              auto material = parse_product(resolve(required(definition, "material")));
+              auto const & geometry = required(definition, "geometry");
+              if(type == "venetian")
+              {
+                  return create_venetian_blind(
+                    Venetian_Geometry(required(geometry, "slat_tilt"),
+                                      required(geometry, "slat_width"),
+                                      required(geometry, "slat_spacing"),
+                                      required(geometry, "slat_curvature"),
+                                      geometry.value("is_horizontal", true)),
+                    material);
+              }
+              if(type == "woven")
+              {
+                  return create_woven_shade(Woven_Geometry(required(geometry, "thread_diameter"),
+                                                           required(geometry, "thread_spacing"),
+                                                           required(geometry, "shade_thickness")),
+                                            material);
+              }
+              if(type == "perforated")
+              {
+                  return create_perforated_screen(
+                    Perforated_Geometry(required(geometry, "spacing_x"),
+                                        required(geometry, "spacing_y"),
+                                        required(geometry, "dimension_x"),
+                                        required(geometry, "dimension_y"),
+                                        perforation_type(required(geometry, "type"))),
+                    material);
+              }
+              std::stringstream msg;
+              msg << "Unknown shade type " << type;
+              throw std::runtime_error(msg.str());
+          });
+    }
+
+    std::string const & Calculation_Cache::default_standard() const
+    {
+        return default_standard_path;
+    }
+
+    Cache_Statistics Calculation_Cache::statistics() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return cache_statistics;
+    }
+
+    void Calculation_Cache::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        standards.clear();
+        products.clear();
+        shades.clear();
+    }
+
+    Glazing_System create_glazing_system(nlohmann::json const & request,
+                                         Calculation_Cache & cache)
+    {
+        auto standard_path = request.value("standard", cache.default_standard());
+        if(standard_path.empty())
+        {
+            throw std::runtime_error("No standard given in the request or as a default");
+        }
+        auto standard = cache.standard(standard_path);
+
+        std::vector<Product_Data_Optical_Thermal> layers;
+        std::vector<size_t> flipped;
+        bool has_shade = false;
+        for(auto const & layer : required(request, "layers"))
+        {
+            if(layer.is_string())
+            {
+                layers.push_back(cache.product_file(layer));
+                continue;
+            }
+            if(layer.contains("shade"))
+            {
+                layers.push_back(cache.shade(layer));
+                has_shade = true;
+            }
+            else if(layer.contains("id"))
+            {
+                layers.push_back(cache.library_product(layer.at("id")));
+            }
+            else
+            {
+                layers.push_back(cache.product_file(required(layer, "file")));
+            }
+            if(layer.value("flipped", false))
+            {
+                flipped.push_back(layers.size() - 1);
+            }
+        }
+
+        std::vector<Engine_Gap_Info> gaps;
+        for(auto const & definition : request.value("gaps", nlohmann::json::array()))
+        {
+            gaps.push_back(gap(definition));
+        }
+
+        std::optional<SingleLayerOptics::CBSDFHemisphere> bsdf_hemisphere;
+        if(request.contains("bsdf_basis") || has_shade)
+        {
+            bsdf_hemisphere = SingleLayerOptics::CBSDFHemisphere::create(
+              bsdf_basis(request.value("bsdf_basis", "full")));
+        }
+
+        Glazing_System system(*standard,
+                              std::move(layers),
+                              std::move(gaps),
+                              request.value("width", 1.0),
+                              request.value("height", 1.0),
+                              request.value("tilt", 90.0),
+                              environments(request, "u_environment", nfrc_u_environments()),
+                              bsdf_hemisphere);
+        for(auto index : flipped)
+        {
+            system.flip_layer(index, true);
+        }
+        return system;
+    }
+
+    nlohmann::json calculate(nlohmann::json const & request, Glazing_System & system)
+    {
+        auto angles = request.value("angles", std::vector<double>{0});
+        auto phi = request.value("phi", 0.0);
+        auto outputs = request.value("outputs", std::vector<std::string>{"u", "shgc"});
+        auto u_environments = environments(request, "u_environment", nfrc_u_environments());
+        auto shgc_environments =
+          environments(request, "shgc_environment", nfrc_shgc_environments());
+
+        std::vector<nlohmann::json> angle_results;
+        for(auto theta : angles)
+        {
+            angle_results.push_back(nlohmann::json{{"theta", theta}, {"phi", phi}});
+        }
+
+        // Each environment is set once for all angles and all of its outputs
+        auto add_thermal_outputs = [&](Environments const & environment,
+                                       bool (*uses_environment)(std::string const &)) {
+            if(std::none_of(outputs.begin(), outputs.end(), uses_environment))
+            {
+                return;
+            }
+            system.environments(environment);
+            for(size_t i = 0; i < angles.size(); ++i)
+            {
+                for(auto const & output : outputs)
+                {
+                    if(uses_environment(output))
+                    {
+                        angle_results[i][output] = thermal_output(system, output, angles[i], phi);
+                    }
+                }
+            }
+        };
+        add_thermal_outputs(u_environments, is_u_output);
+        add_thermal_outputs(shgc_environments, is_shgc_output);
+
+        nlohmann::json results = nlohmann::json::array();
+        Result_Row row;
+        for(size_t i = 0; i < angles.size(); ++i)
+        {
+            auto theta = angles[i];
+            row.clear();
+            for(auto const & output : outputs)
+            {
+                if(is_u_output(output) || is_shgc_output(output))
+                {
+                    continue;
+                }
+                if(output == "thermal_report")
+                {
+                    row.add("thermal",
+                            system.thermal_report(u_environments, shgc_environments, theta, phi));
+                }
+                else if(output == "color")
+                {
+                    row.add("color", system.color(theta, phi));
+                }
+                else
+                {
+                    row.add(to_lower(output), system.optical_method_results(output, theta, phi));
+                }
+            }
+            add_columns(angle_results[i], row);
+            results.push_back(std::move(angle_results[i]));
+        }
+        return results;
+    }
+
+    nlohmann::json calculate(nlohmann::json const & request, Calculation_Cache & cache)
+    {
+        auto system = create_glazing_system(request, cache);
+        return calculate(request, system);
+    }
+
+    nlohmann::json
+      run_request(std::string const & line, size_t line_number, Calculation_Cache & cache)
+    {
+        nlohmann::json result{{"line", line_number}};
+        try
+        {
+            auto request = nlohmann::json::parse(line);
+            if(request.is_object() && request.contains("id"))
+            {
+                result["id"] = request.at("id");
+            }
+            result["results"] = calculate(request, cache);
+        }
+        catch(std::exception const & e)
+        {
+            result["error"] = e.what();
+        }
+        return result;
+    }
+}   // namespace wincalc::batch
@@ -0,0 +1,135 @@
+#ifndef WINCALC_BATCH_H_
+#define WINCALC_BATCH_H_
+
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "wincalc/wincalc.h"
+
+// Headless batch calculations.  A batch is a stream of requests, one JSON object per line,
+// each describing one glazing system and the results wanted from it:
+//
+//   {"id": "triple",                              echoed in the result, optional
+//    "standard": "standards/W5_NFRC_2003.std",    optional if the cache has a default
+//    "layers": ["products/CLEAR_3.json",           product files, .json or BSDF .xml
+//               {"id": "5051", "flipped": true},   products in the cache's product library
+//               {"file": "products/CLEAR_3.json", "flipped": true},
+//               {"shade": "venetian", "material": "products/igsdb_12852.json",
+//                "geometry": {"slat_tilt": 45, "slat_width": 0.05, "slat_spacing": 0.07,
+//                             "slat_curvature": 0.03}}],
+//    "gaps": [{"gas": "argon", "thickness": 0.0127},
+//             {"gases": [{"gas": "argon", "percent": 0.9}, {"gas": "air", "percent": 0.1}],
+//              "thickness": 0.0127}],
+//    "width": 1.0, "height": 1.0, "tilt": 90,
+//    "u_environment": "nfrc_u", "shgc_environment": "nfrc_shgc",
+//    "bsdf_basis": "quarter",                     small, quarter, half or full
+//    "angles": [0, 30, 60], "phi": 0,
+//    "outputs": ["u", "shgc", "SOLAR", "PHOTOPIC"]}
+//
+// Woven shade geometry is thread_diameter, thread_spacing and shade_thickness, perforated
+// screen geometry is type (circular, rectangular or square), spacing_x, spacing_y,
+// dimension_x and dimension_y.  Environments are "nfrc_u", "nfrc_shgc" or an object with
+// outside and inside objects holding the fields of wincalc::Environment, coefficient_model
+// being calculate_h, h_prescribed or hc_prescribed.  The BSDF basis defaults to full when
+// any layer is a shade.
+//
+// Outputs are u, shgc, relative_heat_gain, layer_temperatures_u, layer_temperatures_shgc,
+// thermal_report, color, or the name of any method of the optical standard.  Relative paths
+// are relative to the cache's base directory.
+//
+// Each request gives one result line:
+//
+//   {"id": "triple", "line": 3, "results": [{"theta": 0, "phi": 0, "u": 1.6, ...}, ...]}
+//
+// with one entry per angle.  Optical and thermal report values use the column names of
+// Result_Row, see result_columns.h, with the lower case method name or "thermal" as the
+// prefix.  A request that fails gives {"id": ..., "line": ..., "error": "..."} instead.
+
+namespace wincalc::batch
+{
+    struct Cache_Statistics
+    {
+        uint64_t standard_hits = 0;
+        uint64_t standard_misses = 0;
+        uint64_t product_hits = 0;
+        uint64_t product_misses = 0;
+        uint64_t shade_hits = 0;
+        uint64_t shade_misses = 0;
+    };
+
+    // Standards, converted products and built shades shared by every request of a batch.
+    // Each is loaded the first time a request needs it.  Requests needing something that is
+    // still being loaded by another thread wait for that load instead of repeating it.  A
+    // load that fails is not kept so a later request tries again.  Safe to use from multiple
+    // threads.
+    class Calculation_Cache
+    {
+    public:
+        // library_path is an optional product library, see product_library.h, for layers given
+        // by id.  default_standard is used by requests that do not name a standard.
+        // Standards are loaded through binary caches, see optical_standard_cache.h, kept in
+        // standard_cache_directory, or next to each standard if it is empty.
+        explicit Calculation_Cache(std::string base_directory,
+                                   std::string const & library_path = std::string(),
+                                   std::string default_standard = std::string(),
+                                   std::string standard_cache_directory = std::string());
+
+        std::shared_ptr<window_standards::Optical_Standard const>
+          standard(std::string const & path);
+        // Product in a file, or in the library with id
+        Product_Data_Optical_Thermal product_file(std::string const & path);
+        Product_Data_Optical_Thermal library_product(std::string const & id);
+        // Shade built from a "shade" layer of a request
+        Product_Data_Optical_Thermal shade(nlohmann::json const & definition);
+
+        std::string const & default_standard() const;
+        Cache_Statistics statistics() const;
+        void clear();
+
+    private:
+        template<typename T, typename Load>
+        T cached(std::map<std::string, std::shared_future<T>> & entries,
+                 std::string const & key,
+                 uint64_t & hits,
+                 uint64_t & misses,
+                 Load const & load);
+
+        std::string resolve(std::string const & path) const;
+        std::string standard_cache_path(std::string const & standard_path) const;
+
+        std::string base_directory;
+        std::string default_standard_path;
+        std::string standard_cache_directory;
+        std::unique_ptr<Product_Library> library;
+
+        mutable std::mutex mutex;
+        Cache_Statistics cache_statistics;
+        std::map<std::string,
+                 std::shared_future<std::shared_ptr<window_standards::Optical_Standard const>>>
+          standards;
+        std::map<std::string, std::shared_future<Product_Data_Optical_Thermal>> products;
+        std::map<std::string, std::shared_future<Product_Data_Optical_Thermal>> shades;
+    };
+
+    // Builds the glazing system a request describes.  Throws std::runtime_error for requests
+    // that are not valid.
+    Glazing_System create_glazing_system(nlohmann::json const & request,
+                                         Calculation_Cache & cache);
+
+    // Calculates every output of a request at every angle.  Returns the "results" array of
+    // the result line and throws if the request fails.
+    nlohmann::json calculate(nlohmann::json const & request, Calculation_Cache & cache);
+    nlohmann::json calculate(nlohmann::json const & request, Glazing_System & system);
+
+    // The whole result line for one line of a batch, never throws
+    nlohmann::json run_request(std::string const & line, size_t line_number,
+                               Calculation_Cache & cache);
+}   // namespace wincalc::batch
+
+#endif
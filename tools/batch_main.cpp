@@ -0,0 +1,191 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include "batch.h"
+#include "thread_pool.h"
+
+// Runs every request of a JSON lines manifest and writes one result line per request as soon
+// as it is calculated, so results come out in the order they finish.  Each result has the
+// line number of its request.  See batch.h for the request and result formats and usage()
+// for the options.
+
+namespace
+{
+    void usage(std::ostream & output)
+    {
+        output << "Usage: wincalc-batch [options] [manifest]\n"
+               << "  manifest             JSON lines file of requests, - or none for stdin\n"
+               << "  --output <path>      write results to a file instead of stdout\n"
+               << "  --threads <n>        worker threads, 0 is one per core (0)\n"
+               << "  --base-dir <path>    directory relative paths in requests are relative\n"
+               << "                       to (directory of the manifest)\n"
+               << "  --library <path>     product library for layers given by id\n"
+               << "  --standard <path>    standard for requests that do not name one\n"
+               << "  --standard-cache-dir <path>\n"
+               << "                       directory for binary caches of loaded standards\n"
+               << "                       (next to each standard)\n"
+               << "  --stats              print cache statistics to stderr when done\n";
+    }
+}   // namespace
+
+int main(int argc, char * argv[])
+{
+    std::string manifest_path = "-";
+    std::string output_path;
+    size_t number_of_threads = 0;
+    std::string base_directory;
+    std::string library_path;
+    std::string default_standard;
+    std::string standard_cache_directory;
+    bool print_statistics = false;
+
+    try
+    {
+        for(int i = 1; i < argc; ++i)
+        {
+            std::string argument(argv[i]);
+            auto value = [&]() {
+                if(i + 1 >= argc)
+                {
+                    throw std::runtime_error("Missing value for " + argument);
+                }
+                return std::string(argv[++i]);
+            };
+            if(argument == "--output")
+            {
+                output_path = value();
+            }
+            else if(argument == "--threads")
+            {
+                number_of_threads = std::stoul(value());
+            }
+            else if(argument == "--base-dir")
+            {
+                base_directory = value();
+            }
+            else if(argument == "--library")
+            {
+                library_path = value();
+            }
+            else if(argument == "--standard")
+            {
+                default_standard = value();
+            }
+            else if(argument == "--standard-cache-dir")
+            {
+                standard_cache_directory = value();
+            }
+            else if(argument == "--stats")
+            {
+                print_statistics = true;
+            }
+            else if(argument == "--help")
+            {
+                usage(std::cout);
+                return 0;
+            }
+            else if(argument.size() > 1 && argument[0] == '-')
+            {
+                throw std::runtime_error("Unknown option " + argument);
+            }
+            else
+            {
+                manifest_path = argument;
+            }
+        }
+
+        std::ifstream manifest_file;
+        if(manifest_path != "-")
+        {
+            manifest_file.open(manifest_path);
+            if(!manifest_file)
+            {
+                throw std::runtime_error("Unable to open " + manifest_path);
+            }
+            if(base_directory.empty())
+            {
+                base_directory =
+                  std::filesystem::absolute(manifest_path).parent_path().string();
+            }
+        }
+        std::istream & manifest = manifest_path == "-" ? std::cin : manifest_file;
+
+        std::ofstream output_file;
+        if(!output_path.empty())
+        {
+            output_file.open(output_path);
+            if(!output_file)
+            {
+                throw std::runtime_error("Unable to open " + output_path);
+            }
+        }
+        std::ostream & output = output_path.empty() ? std::cout : output_file;
+
+        wincalc::batch::Calculation_Cache cache(
+          base_directory, library_path, default_standard, standard_cache_directory);
+        std::mutex output_mutex;
+        std::atomic<size_t> failures{0};
+        size_t requests = 0;
+        auto start = std::chrono::steady_clock::now();
+        {
+            wincalc::Work_Stealing_Pool pool(number_of_threads);
+            // Only read ahead of the workers by a few requests so memory use does not depend
+            // on the size of the manifest
+            auto read_ahead = 4 * pool.size();
+            std::string line;
+            size_t line_number = 0;
+            while(std::getline(manifest, line))
+            {
+                ++line_number;
+                if(line.find_first_not_of(" \t\r") == std::string::npos)
+                {
+                    continue;
+                }
+                ++requests;
+                pool.wait_for_pending_below(read_ahead);
+                pool.submit([&, line = std::move(line), line_number]() {
+                    auto result = wincalc::batch::run_request(line, line_number, cache);
+                    if(result.contains("error"))
+                    {
+                        ++failures;
+                    }
+                    auto text = result.dump();
+                    std::lock_guard<std::mutex> lock(output_mutex);
+                    output << text << '\n';
+                    output.flush();
+                });
+            }
+            pool.wait();
+        }
+        auto seconds =
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cerr << requests << " requests, " << failures << " failed, " << seconds
+                  << " s\n";
+        if(print_statistics)
+        {
+            auto statistics = cache.statistics();
+            std::cerr << "standards " << statistics.standard_hits << " hits "
+                      << statistics.standard_misses << " misses\n"
+                      << "products  " << statistics.product_hits << " hits "
+                      << statistics.product_misses << " misses\n"
+                      << "shades    " << statistics.shade_hits << " hits "
+                      << statistics.shade_misses << " misses\n";
+        }
+        return failures == 0 ? 0 : 1;
+    }
+    catch(std::exception const & e)
+    {
+        std::cerr << e.what() << "\n";
+        usage(std::cerr);
+        return 2;
+    }
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "server.h"
+
+// Sends each line of standard input to a calculation server as one request and prints each
+// response on its own line.  Stands in for a real client when trying out a server.
+
+namespace
+{
+    void usage(std::ostream & output)
+    {
+        output << "Usage: wincalc-client [options] < requests\n"
+               << "  --socket <path>    connect to a Unix domain socket\n"
+               << "  --port <n>         connect to 127.0.0.1:<n> (5491)\n";
+    }
+}   // namespace
+
+int main(int argc, char * argv[])
+{
+    std::string socket_path;
+    uint16_t port = 5491;
+
+    try
+    {
+        for(int i = 1; i < argc; ++i)
+        {
+            std::string argument(argv[i]);
+            auto value = [&]() {
+                if(i + 1 >= argc)
+                {
+                    throw std::runtime_error("Missing value for " + argument);
+                }
+                return std::string(argv[++i]);
+            };
+            if(argument == "--socket")
+            {
+                socket_path = value();
+            }
+            else if(argument == "--port")
+            {
+                port = static_cast<uint16_t>(std::stoul(value()));
+            }
+            else if(argument == "--help")
+            {
+                usage(std::cout);
+                return 0;
+            }
+            else
+            {
+                throw std::runtime_error("Unknown option " + argument);
+            }
+        }
+
+        auto client = socket_path.empty()
+                        ? std::make_unique<wincalc::server::Calculation_Client>(port)
+                        : std::make_unique<wincalc::server::Calculation_Client>(socket_path);
+        std::string line;
+        while(std::getline(std::cin, line))
+        {
+            if(line.find_first_not_of(" \t\r") == std::string::npos)
+            {
+                continue;
+            }
+            std::cout << client->request_line(line) << std::endl;
+        }
+    }
+    catch(std::exception const & e)
+    {
+        std::cerr << e.what() << "\n";
+        usage(std::cerr);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,568 @@
+#include <cerrno>
+#include <cstring>
+#include <future>
+#include <sstream>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "server.h"
+
+namespace wincalc::server
+{
+    namespace
+    {
+        // Longest request line accepted, a connection sending more is closed
+        size_t const max_line_size = 16 * 1024 * 1024;
+
+        [[noreturn]] void socket_error(std::string const & what)
+        {
+            std::stringstream msg;
+            msg << what << ": " << std::strerror(errno);
+            throw std::runtime_error(msg.str());
+        }
+
+        sockaddr_un unix_address(std::string const & path)
+        {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if(path.size() >= sizeof(address.sun_path))
+            {
+                std::stringstream msg;
+                msg << "Socket path " << path << " is too long";
+                throw std::runtime_error(msg.str());
+            }
+            std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+            return address;
+        }
+
+        // Removes a socket file left at path.  Anything else there is left alone and is an
+        // error, so a mistyped path never deletes a regular file.
+        void remove_socket_file(std::string const & path)
+        {
+            struct stat status;
+            if(::lstat(path.c_str(), &status) != 0)
+            {
+                return;
+            }
+            if(!S_ISSOCK(status.st_mode))
+            {
+                std::stringstream msg;
+                msg << path << " exists and is not a socket";
+                throw std::runtime_error(msg.str());
+            }
+            ::unlink(path.c_str());
+        }
+
+        sockaddr_in loopback_address(uint16_t port)
+        {
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            return address;
+        }
+
+        bool write_all(int socket, std::string const & data)
+        {
+#ifdef MSG_NOSIGNAL
+            int flags = MSG_NOSIGNAL;
+#else
+            int flags = 0;
+#endif
+            size_t written = 0;
+            while(written < data.size())
+            {
+                auto count = ::send(socket, data.data() + written, data.size() - written, flags);
+                if(count < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if(count <= 0)
+                {
+                    return false;
+                }
+                written += static_cast<size_t>(count);
+            }
+            return true;
+        }
+
+        // Returns false once the other end has closed the connection, the connection failed
+        // or the line is too long.  buffer keeps anything read past the end of the line.
+        bool read_line(int socket, std::string & buffer, std::string & line)
+        {
+            char chunk[64 * 1024];
+            for(;;)
+            {
+                auto end = buffer.find('\n');
+                if(end != std::string::npos)
+                {
+                    line.assign(buffer, 0, end);
+                    buffer.erase(0, end + 1);
+                    return true;
+                }
+                if(buffer.size() > max_line_size)
+                {
+                    return false;
+                }
+                auto count = ::recv(socket, chunk, sizeof(chunk), 0);
+                if(count < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if(count <= 0)
+                {
+                    return false;
+                }
+                buffer.append(chunk, static_cast<size_t>(count));
+            }
+        }
+
+        uint64_t microseconds_since(std::chrono::steady_clock::time_point start)
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                           std::chrono::steady_clock::now() - start)
+                                           .count());
+        }
+    }   // namespace
+
+    Calculation_Server::Calculation_Server(Server_Options options) :
+        options(std::move(options)),
+        cache(this->options.base_directory,
+              this->options.library_path,
+              this->options.default_standard,
+              this->options.standard_cache_directory),
+        pool(this->options.number_of_threads),
+        started(std::chrono::steady_clock::now())
+    {}
+
+    Calculation_Server::~Calculation_Server()
+    {
+        stop();
+        reap_connections(true);
+        if(listen_socket >= 0)
+        {
+            ::close(listen_socket);
+            if(!options.socket_path.empty())
+            {
+                try
+                {
+                    remove_socket_file(options.socket_path);
+                }
+                catch(std::exception const &)
+                {
+                    // Not the socket this server made, leave it
+                }
+            }
+        }
+    }
+
+    void Calculation_Server::listen()
+    {
+        if(!options.socket_path.empty())
+        {
+            auto address = unix_address(options.socket_path);
+            // A socket left behind by a server that did not shut down cleanly
+            remove_socket_file(options.socket_path);
+            listen_socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if(listen_socket < 0)
+            {
+                socket_error("Unable to create socket");
+            }
+            if(::bind(listen_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+            {
+                socket_error("Unable to bind " + options.socket_path);
+            }
+        }
+        else
+        {
+            auto address = loopback_address(options.port);
+            listen_socket = ::socket(AF_INET, SOCK_STREAM, 0);
+            if(listen_socket < 0)
+            {
+                socket_error("Unable to create socket");
+            }
+            int reuse = 1;
+            ::setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            if(::bind(listen_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+            {
+                socket_error("Unable to bind port " + std::to_string(options.port));
+            }
+            socklen_t size = sizeof(address);
+            ::getsockname(listen_socket, reinterpret_cast<sockaddr *>(&address), &size);
+            bound_port = ntohs(address.sin_port);
+        }
+        if(::listen(listen_socket, SOMAXCONN) != 0)
+        {
+            socket_error("Unable to listen");
+        }
+    }
+
+    void Calculation_Server::serve()
+    {
+        if(listen_socket < 0)
+        {
+            listen();
+        }
+        while(!stopping)
+        {
+            // Wakes up regularly to notice stop and to clean up closed connections
+            pollfd ready{listen_socket, POLLIN, 0};
+            auto count = ::poll(&ready, 1, 100);
+            reap_connections(false);
+            if(count <= 0 || !(ready.revents & POLLIN))
+            {
+                continue;
+            }
+            int socket = ::accept(listen_socket, nullptr, nullptr);
+            if(socket < 0)
+            {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(connections_mutex);
+            if(connections.size() >= options.max_connections)
+            {
+                ++rejected_connections;
+                write_all(socket,
+                          nlohmann::json{{"error", "busy"}, {"reason", "too many connections"}}
+                              .dump()
+                            + "\n");
+                ::close(socket);
+                continue;
+            }
+            connections.push_back(std::make_unique<Connection>());
+            auto & connection = *connections.back();
+            connection.socket = socket;
+            connection.thread =
+              std::thread([this, &connection]() { serve_connection(connection); });
+        }
+        reap_connections(true);
+    }
+
+    void Calculation_Server::stop()
+    {
+        stopping = true;
+    }
+
+    uint16_t Calculation_Server::port() const
+    {
+        return bound_port;
+    }
+
+    void Calculation_Server::serve_connection(Connection & connection)
+    {
+        std::string buffer;
+        std::string line;
+        while(!stopping && read_line(connection.socket, buffer, line))
+        {
+            if(line.find_first_not_of(" \t\r") == std::string::npos)
+            {
+                continue;
+            }
+            if(!write_all(connection.socket, handle(line) + "\n"))
+            {
+                break;
+            }
+        }
+        // The socket is closed by reap_connections after the thread has been joined
+        connection.finished = true;
+    }
+
+    void Calculation_Server::reap_connections(bool all)
+    {
+        // Joined without holding the lock, a connection answering a stats request needs it
+        std::list<std::unique_ptr<Connection>> closing;
+        {
+            std::lock_guard<std::mutex> lock(connections_mutex);
+            for(auto connection = connections.begin(); connection != connections.end();)
+            {
+                auto next = std::next(connection);
+                if(all || (*connection)->finished)
+                {
+                    closing.splice(closing.end(), connections, connection);
+                }
+                connection = next;
+            }
+        }
+        for(auto & connection : closing)
+        {
+            // Ends a read the connection is blocked in
+            ::shutdown(connection->socket, SHUT_RDWR);
+            connection->thread.join();
+            ::close(connection->socket);
+        }
+    }
+
+    std::string Calculation_Server::handle(std::string const & line)
+    {
+        ++requests;
+        nlohmann::json response;
+        try
+        {
+            auto request = nlohmann::json::parse(line);
+            if(!request.is_object())
+            {
+                throw std::runtime_error("A request must be a JSON object");
+            }
+            auto type = request.value("type", "calculate");
+            if(type == "calculate")
+            {
+                response = calculate(request);
+            }
+            else if(type == "stats")
+            {
+                response = statistics();
+            }
+            else if(type == "clear_cache")
+            {
+                clear_cache();
+                response = nlohmann::json{{"cleared", true}};
+            }
+            else
+            {
+                std::stringstream msg;
+                msg << "Unknown request type " << type;
+                throw std::runtime_error(msg.str());
+            }
+        }
+        catch(std::exception const & e)
+        {
+            ++failures;
+            response = nlohmann::json{{"error", e.what()}};
+        }
+        return response.dump();
+    }
+
+    nlohmann::json Calculation_Server::calculate(nlohmann::json const & request)
+    {
+        nlohmann::json response = nlohmann::json::object();
+        if(request.contains("id"))
+        {
+            response["id"] = request.at("id");
+        }
+        if(queued++ >= options.max_queued)
+        {
+            --queued;
+            ++rejected;
+            response["error"] = "busy";
+            response["reason"] = "too many queued calculations";
+            return response;
+        }
+
+        // Requests that only differ in what they ask of a system share the built system
+        auto key = request;
+        for(auto name : {"type", "id", "angles", "phi", "outputs"})
+        {
+            key.erase(name);
+        }
+
+        auto promise = std::make_shared<std::promise<nlohmann::json>>();
+        auto future = promise->get_future();
+        pool.submit([this, &request, key = key.dump(), promise]() {
+            auto start = std::chrono::steady_clock::now();
+            nlohmann::json results;
+            std::exception_ptr error;
+            try
+            {
+                auto entry = cached_system(key);
+                std::lock_guard<std::mutex> lock(entry->mutex);
+                if(!entry->system)
+                {
+                    try
+                    {
+                        entry->system = std::make_unique<Glazing_System>(
+                          batch::create_glazing_system(request, cache));
+                    }
+                    catch(...)
+                    {
+                        // An entry without a system must not push built ones out of the cache
+                        drop_cached_system(key, entry);
+                        throw;
+                    }
+                }
+                results = batch::calculate(request, *entry->system);
+            }
+            catch(...)
+            {
+                error = std::current_exception();
+            }
+            // The counters are updated before the response is released so statistics asked
+            // for after a response include its calculation
+            calculation_microseconds += microseconds_since(start);
+            ++calculations;
+            --queued;
+            if(error)
+            {
+                promise->set_exception(error);
+            }
+            else
+            {
+                promise->set_value(std::move(results));
+            }
+        });
+
+        try
+        {
+            response["results"] = future.get();
+        }
+        catch(std::exception const & e)
+        {
+            ++failures;
+            response["error"] = e.what();
+        }
+        return response;
+    }
+
+    std::shared_ptr<Calculation_Server::Cached_System>
+      Calculation_Server::cached_system(std::string const & key)
+    {
+        std::lock_guard<std::mutex> lock(systems_mutex);
+        auto entry = systems.find(key);
+        if(entry != systems.end())
+        {
+            ++system_hits;
+            system_order.splice(system_order.end(), system_order, entry->second.second);
+            return entry->second.first;
+        }
+        ++system_misses;
+        auto system = std::make_shared<Cached_System>();
+        system_order.push_back(key);
+        systems.emplace(key, std::make_pair(system, std::prev(system_order.end())));
+        while(systems.size() > options.max_systems)
+        {
+            // Requests still using a dropped system keep it alive until they finish
+            systems.erase(system_order.front());
+            system_order.pop_front();
+        }
+        return system;
+    }
+
+    void Calculation_Server::drop_cached_system(std::string const & key,
+                                                std::shared_ptr<Cached_System> const & system)
+    {
+        std::lock_guard<std::mutex> lock(systems_mutex);
+        auto entry = systems.find(key);
+        // The entry may already have been dropped and replaced by a newer one
+        if(entry != systems.end() && entry->second.first == system)
+        {
+            system_order.erase(entry->second.second);
+            systems.erase(entry);
+        }
+    }
+
+    void Calculation_Server::clear_cache()
+    {
+        cache.clear();
+        std::lock_guard<std::mutex> lock(systems_mutex);
+        systems.clear();
+        system_order.clear();
+    }
+
+    nlohmann::json Calculation_Server::statistics() const
+    {
+        auto cache_statistics = cache.statistics();
+        size_t number_of_systems = 0;
+        {
+            std::lock_guard<std::mutex> lock(systems_mutex);
+            number_of_systems = systems.size();
+        }
+        size_t number_of_connections = 0;
+        {
+            std::lock_guard<std::mutex> lock(connections_mutex);
+            number_of_connections = connections.size();
+        }
+        uint64_t number_of_calculations = calculations;
+        return nlohmann::json{
+          {"uptime_seconds", microseconds_since(started) / 1e6},
+          {"requests", requests.load()},
+          {"calculations", number_of_calculations},
+          {"failures", failures.load()},
+          {"rejected", rejected.load()},
+          {"rejected_connections", rejected_connections.load()},
+          {"queued", queued.load()},
+          {"connections", number_of_connections},
+          {"mean_calculation_ms",
+           number_of_calculations > 0
+             ? calculation_microseconds / 1e3 / static_cast<double>(number_of_calculations)
+             : 0.0},
+          {"threads", pool.size()},
+          {"steals", pool.steals()},
+          {"limits",
+           {{"max_queued", options.max_queued},
+            {"max_connections", options.max_connections},
+            {"max_systems", options.max_systems}}},
+          {"cache",
+           {{"standards",
+             {{"hits", cache_statistics.standard_hits},
+              {"misses", cache_statistics.standard_misses}}},
+            {"products",
+             {{"hits", cache_statistics.product_hits},
+              {"misses", cache_statistics.product_misses}}},
+            {"shades",
+             {{"hits", cache_statistics.shade_hits}, {"misses", cache_statistics.shade_misses}}},
+            {"systems",
+             {{"hits", system_hits.load()},
+              {"misses", system_misses.load()},
+              {"size", number_of_systems}}}}}};
+    }
+
+    Calculation_Client::Calculation_Client(std::string const & socket_path)
+    {
+        auto address = unix_address(socket_path);
+        socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if(socket < 0)
+        {
+            socket_error("Unable to create socket");
+        }
+        if(::connect(socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            ::close(socket);
+            socket_error("Unable to connect to " + socket_path);
+        }
+    }
+
+    Calculation_Client::Calculation_Client(uint16_t port)
+    {
+        auto address = loopback_address(port);
+        socket = ::socket(AF_INET, SOCK_STREAM, 0);
+        if(socket < 0)
+        {
+            socket_error("Unable to create socket");
+        }
+        if(::connect(socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            ::close(socket);
+            socket_error("Unable to connect to port " + std::to_string(port));
+        }
+    }
+
+    Calculation_Client::~Calculation_Client()
+    {
+        ::close(socket);
+    }
+
+    std::string Calculation_Client::request_line(std::string const & line)
+    {
+        if(!write_all(socket, line + "\n"))
+        {
+            socket_error("Unable to send request");
+        }
+        std::string response;
+        if(!read_line(socket, buffer, response))
+        {
+            throw std::runtime_error("The server closed the connection");
+        }
+        return response;
+    }
+
+    nlohmann::json Calculation_Client::request(nlohmann::json const & request)
+    {
+        return nlohmann::json::parse(request_line(request.dump()));
+    }
+}   // namespace wincalc::server
@@ -0,0 +1,162 @@
+#ifndef WINCALC_SERVER_H_
+#define WINCALC_SERVER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+#include "batch.h"
+#include "thread_pool.h"
+
+// Long running calculation service.  The server listens on a Unix domain socket or a TCP port
+// on the loopback interface and keeps standards, converted products, shades and built glazing
+// systems in memory between requests, so only the first request for a system pays for loading
+// and building it.
+//
+// The protocol is JSON lines in both directions.  Each line a client sends is one request and
+// the server answers each with one line, in order.  A connection can send any number of
+// requests.  Requests are:
+//
+//   {"type": "calculate", ...}    a batch request, see batch.h.  "type" can be left out.
+//                                 The response is a batch result line without "line".
+//   {"type": "stats"}             request counts, cache statistics and limits
+//   {"type": "clear_cache"}       forgets every cached standard, product and system
+//
+// Calculations run on a pool of worker threads.  A calculate request that arrives while
+// max_queued calculations are already waiting or running is answered with
+// {"error": "busy", ...} straight away instead of being queued.  Connections over
+// max_connections are sent the same error and closed.
+//
+// POSIX only.
+
+namespace wincalc::server
+{
+    struct Server_Options
+    {
+        // Unix domain socket to listen on.  If empty the server listens on port instead.  A
+        // socket already at the path is replaced, anything else there is an error.
+        std::string socket_path;
+        // Port on 127.0.0.1, 0 picks a free port, see Calculation_Server::port
+        uint16_t port = 0;
+        // Calculation threads, 0 uses one per core
+        size_t number_of_threads = 0;
+        size_t max_queued = 64;
+        size_t max_connections = 32;
+        // Built glazing systems kept, least recently used ones are dropped first
+        size_t max_systems = 256;
+        // See batch::Calculation_Cache
+        std::string base_directory;
+        std::string library_path;
+        std::string default_standard;
+        std::string standard_cache_directory;
+    };
+
+    class Calculation_Server
+    {
+    public:
+        explicit Calculation_Server(Server_Options options);
+        // Stops the server if it is still serving
+        ~Calculation_Server();
+
+        Calculation_Server(Calculation_Server const &) = delete;
+        Calculation_Server & operator=(Calculation_Server const &) = delete;
+
+        // Opens the socket.  Connections made after this are queued until serve is called.
+        void listen();
+        // Accepts connections until stop is called, each connection on its own thread
+        void serve();
+        // Can be called from any thread.  serve returns once every connection has been
+        // closed.
+        void stop();
+
+        // Port the server listens on, useful when it was started with port 0
+        uint16_t port() const;
+
+        // Answers one request line.  Used by the connections, also usable without a socket.
+        std::string handle(std::string const & line);
+
+        nlohmann::json statistics() const;
+
+    private:
+        struct Cached_System
+        {
+            std::mutex mutex;
+            std::unique_ptr<Glazing_System> system;
+        };
+
+        struct Connection
+        {
+            int socket;
+            std::thread thread;
+            std::atomic<bool> finished{false};
+        };
+
+        nlohmann::json calculate(nlohmann::json const & request);
+        std::shared_ptr<Cached_System> cached_system(std::string const & key);
+        void drop_cached_system(std::string const & key,
+                                std::shared_ptr<Cached_System> const & system);
+        void clear_cache();
+        void serve_connection(Connection & connection);
+        void reap_connections(bool all);
+
+        Server_Options options;
+        batch::Calculation_Cache cache;
+        Work_Stealing_Pool pool;
+        std::chrono::steady_clock::time_point started;
+
+        int listen_socket = -1;
+        uint16_t bound_port = 0;
+        std::atomic<bool> stopping{false};
+        mutable std::mutex connections_mutex;
+        std::list<std::unique_ptr<Connection>> connections;
+
+        // Least recently used first
+        mutable std::mutex systems_mutex;
+        std::list<std::string> system_order;
+        std::map<std::string,
+                 std::pair<std::shared_ptr<Cached_System>, std::list<std::string>::iterator>>
+          systems;
+
+        std::atomic<size_t> queued{0};
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> calculations{0};
+        std::atomic<uint64_t> failures{0};
+        std::atomic<uint64_t> rejected{0};
+        std::atomic<uint64_t> rejected_connections{0};
+        std::atomic<uint64_t> system_hits{0};
+        std::atomic<uint64_t> system_misses{0};
+        std::atomic<uint64_t> calculation_microseconds{0};
+    };
+
+    // Minimal blocking client, one request at a time
+    class Calculation_Client
+    {
+    public:
+        // Connects to a Unix domain socket
+        explicit Calculation_Client(std::string const & socket_path);
+        // Connects to a port on 127.0.0.1
+        explicit Calculation_Client(uint16_t port);
+        ~Calculation_Client();
+
+        Calculation_Client(Calculation_Client const &) = delete;
+        Calculation_Client & operator=(Calculation_Client const &) = delete;
+
+        // Sends one request line and returns the response line
+        std::string request_line(std::string const & line);
+        nlohmann::json request(nlohmann::json const & request);
+
+    private:
+        int socket;
+        std::string buffer;
+    };
+}   // namespace wincalc::server
+
+#endif
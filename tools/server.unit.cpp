@@ -0,0 +1,128 @@
+#include <memory>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "server.h"
+
+// End to end tests of the calculation server.  The server listens on a free port and is
+// talked to with Calculation_Client.
+
+using namespace wincalc::server;
+
+class TestServer : public testing::Test
+{
+protected:
+    Server_Options options;
+    std::unique_ptr<Calculation_Server> server;
+    std::thread serving;
+
+    virtual void SetUp()
+    {
+        options.number_of_threads = 2;
+        options.base_directory = WINCALC_TEST_DIR;
+        options.default_standard = "standards/W5_NFRC_2003.std";
+        // Keeps the binary standard cache out of the test directory
+        options.standard_cache_directory = WINCALC_STANDARD_CACHE_DIR;
+        server = std::make_unique<Calculation_Server>(options);
+        server->listen();
+        serving = std::thread([this]() { server->serve(); });
+    }
+
+    virtual void TearDown()
+    {
+        server->stop();
+        serving.join();
+    }
+
+    static nlohmann::json clear_request()
+    {
+        return nlohmann::json{{"id", "clear"},
+                              {"layers", {"products/CLEAR_3.json"}},
+                              {"angles", {0, 60}},
+                              {"outputs", {"u", "shgc", "SOLAR"}}};
+    }
+};
+
+TEST_F(TestServer, Calculate)
+{
+    Calculation_Client client(server->port());
+    auto response = client.request(clear_request());
+    EXPECT_EQ(response.value("id", ""), "clear");
+    ASSERT_TRUE(response.contains("results"));
+    ASSERT_EQ(response.at("results").size(), 2u);
+
+    auto const & normal = response.at("results").at(0);
+    EXPECT_GT(normal.value("u", 0.0), 5);
+    EXPECT_LT(normal.value("u", 0.0), 6.5);
+    EXPECT_GT(normal.value("shgc", 0.0), 0.8);
+    EXPECT_LT(normal.value("shgc", 0.0), 0.9);
+    // Optical results use the result column names
+    EXPECT_TRUE(normal.contains("solar_system_front_transmittance_direct_hemispherical"));
+}
+
+TEST_F(TestServer, Errors)
+{
+    Calculation_Client client(server->port());
+    EXPECT_TRUE(client.request(nlohmann::json{{"layers", {"products/missing.json"}}})
+                  .contains("error"));
+    EXPECT_TRUE(
+      nlohmann::json::parse(client.request_line("{\"type\": \"restart\"}")).contains("error"));
+    EXPECT_TRUE(nlohmann::json::parse(client.request_line("not json")).contains("error"));
+}
+
+TEST_F(TestServer, Statistics)
+{
+    Calculation_Client client(server->port());
+    client.request(clear_request());
+    // Same system, different outputs, so the built system is reused
+    auto second_request = clear_request();
+    second_request["outputs"] = {"u"};
+    second_request["angles"] = {30};
+    EXPECT_TRUE(client.request(second_request).contains("results"));
+    EXPECT_TRUE(client.request(nlohmann::json{{"layers", {"products/missing.json"}}})
+                  .contains("error"));
+
+    auto statistics = client.request(nlohmann::json{{"type", "stats"}});
+    EXPECT_EQ(statistics.at("calculations"), 3);
+    EXPECT_EQ(statistics.at("failures"), 1);
+    EXPECT_EQ(statistics.at("connections"), 1);
+    EXPECT_EQ(statistics.at("cache").at("systems").at("hits"), 1);
+    // The system that failed to build is not kept
+    EXPECT_EQ(statistics.at("cache").at("systems").at("size"), 1);
+    EXPECT_EQ(statistics.at("cache").at("standards").at("misses"), 1);
+
+    auto cleared = client.request(nlohmann::json{{"type", "clear_cache"}});
+    EXPECT_TRUE(cleared.value("cleared", false));
+    statistics = client.request(nlohmann::json{{"type", "stats"}});
+    EXPECT_EQ(statistics.at("cache").at("systems").at("size"), 0);
+}
+
+TEST_F(TestServer, Busy)
+{
+    // A server that may not queue anything turns every calculation away
+    options.max_queued = 0;
+    Calculation_Server busy_server(options);
+    auto busy = nlohmann::json::parse(busy_server.handle(clear_request().dump()));
+    EXPECT_EQ(busy.value("error", ""), "busy");
+    EXPECT_EQ(busy_server.statistics().at("rejected"), 1);
+}
+
+TEST_F(TestServer, Socket_Path_Is_Not_A_Socket)
+{
+    auto path = std::filesystem::temp_directory_path() / "wincalc_server_test_not_a_socket";
+    {
+        std::ofstream file(path);
+        file << "keep me";
+    }
+    options.socket_path = path.string();
+    {
+        Calculation_Server socket_server(options);
+        EXPECT_THROW(socket_server.listen(), std::runtime_error);
+    }
+    // Neither listen nor the destructor removed the file
+    EXPECT_TRUE(std::filesystem::is_regular_file(path));
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,136 @@
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "server.h"
+
+// Runs a calculation server until it gets SIGINT or SIGTERM.  See server.h for the protocol
+// and usage() for the options.
+
+namespace
+{
+    wincalc::server::Calculation_Server * running_server = nullptr;
+
+    extern "C" void stop_server(int)
+    {
+        if(running_server)
+        {
+            running_server->stop();
+        }
+    }
+
+    void usage(std::ostream & output)
+    {
+        output << "Usage: wincalc-server [options]\n"
+               << "  --socket <path>          listen on a Unix domain socket\n"
+               << "  --port <n>               listen on 127.0.0.1:<n> (5491)\n"
+               << "  --threads <n>            calculation threads, 0 is one per core (0)\n"
+               << "  --max-queued <n>         calculations waiting or running before\n"
+               << "                           requests are turned away (64)\n"
+               << "  --max-connections <n>    open connections (32)\n"
+               << "  --max-systems <n>        built glazing systems kept in memory (256)\n"
+               << "  --base-dir <path>        directory relative paths in requests are\n"
+               << "                           relative to (current directory)\n"
+               << "  --library <path>         product library for layers given by id\n"
+               << "  --standard <path>        standard for requests that do not name one\n"
+               << "  --standard-cache-dir <path>\n"
+               << "                           directory for binary caches of loaded standards\n"
+               << "                           (next to each standard)\n";
+    }
+}   // namespace
+
+int main(int argc, char * argv[])
+{
+    wincalc::server::Server_Options options;
+    options.port = 5491;
+
+    try
+    {
+        for(int i = 1; i < argc; ++i)
+        {
+            std::string argument(argv[i]);
+            auto value = [&]() {
+                if(i + 1 >= argc)
+                {
+                    throw std::runtime_error("Missing value for " + argument);
+                }
+                return std::string(argv[++i]);
+            };
+            if(argument == "--socket")
+            {
+                options.socket_path = value();
+            }
+            else if(argument == "--port")
+            {
+                options.port = static_cast<uint16_t>(std::stoul(value()));
+            }
+            else if(argument == "--threads")
+            {
+                options.number_of_threads = std::stoul(value());
+            }
+            else if(argument == "--max-queued")
+            {
+                options.max_queued = std::stoul(value());
+            }
+            else if(argument == "--max-connections")
+            {
+                options.max_connections = std::stoul(value());
+            }
+            else if(argument == "--max-systems")
+            {
+                options.max_systems = std::stoul(value());
+            }
+            else if(argument == "--base-dir")
+            {
+                options.base_directory = value();
+            }
+            else if(argument == "--library")
+            {
+                options.library_path = value();
+            }
+            else if(argument == "--standard")
+            {
+                options.default_standard = value();
+            }
+            else if(argument == "--standard-cache-dir")
+            {
+                options.standard_cache_directory = value();
+            }
+            else if(argument == "--help")
+            {
+                usage(std::cout);
+                return 0;
+            }
+            else
+            {
+                throw std::runtime_error("Unknown option " + argument);
+            }
+        }
+
+        wincalc::server::Calculation_Server server(options);
+        server.listen();
+        if(options.socket_path.empty())
+        {
+            std::cerr << "Listening on 127.0.0.1:" << server.port() << "\n";
+        }
+        else
+        {
+            std::cerr << "Listening on " << options.socket_path << "\n";
+        }
+        running_server = &server;
+        std::signal(SIGINT, stop_server);
+        std::signal(SIGTERM, stop_server);
+        std::signal(SIGPIPE, SIG_IGN);
+        server.serve();
+        running_server = nullptr;
+    }
+    catch(std::exception const & e)
+    {
+        std::cerr << e.what() << "\n";
+        usage(std::cerr);
+        return 1;
+    }
+    return 0;
+}
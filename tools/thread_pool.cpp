@@ -0,0 +1,191 @@
+#include "thread_pool.h"
+#include "util.h"
+
+namespace wincalc
+{
+    namespace
+    {
+        // Lets submit tell whether it is called from one of a pool's own workers
+        thread_local Work_Stealing_Pool const * current_pool = nullptr;
+        thread_local size_t current_worker = 0;
+    }   // namespace
+
+    Work_Stealing_Pool::Work_Stealing_Pool(size_t number_of_threads)
+    {
+        number_of_threads = thread_count(number_of_threads, SIZE_MAX);
+        for(size_t i = 0; i < number_of_threads; ++i)
+        {
+            queues.push_back(std::make_unique<Worker_Queue>());
+        }
+        threads.reserve(number_of_threads);
+        try
+        {
+            for(size_t i = 0; i < number_of_threads; ++i)
+            {
+                threads.emplace_back([this, i]() { run(i); });
+            }
+        }
+        catch(...)
+        {
+            // The destructor does not run for a pool that failed to construct and the workers
+            // already started use this pool
+            stop_workers();
+            throw;
+        }
+    }
+
+    Work_Stealing_Pool::~Work_Stealing_Pool()
+    {
+        stop_workers();
+    }
+
+    void Work_Stealing_Pool::stop_workers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            stopping = true;
+        }
+        work_available.notify_all();
+        for(auto & thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    void Work_Stealing_Pool::submit(Task task)
+    {
+        auto index = current_pool == this ? current_worker : next_queue++ % queues.size();
+        // Counted before the task can be seen so a worker that takes and finishes it at once
+        // never takes the counts below zero
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            ++queued;
+            ++unfinished;
+        }
+        try
+        {
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(std::move(task));
+        }
+        catch(...)
+        {
+            {
+                std::lock_guard<std::mutex> lock(state_mutex);
+                --queued;
+                --unfinished;
+            }
+            task_finished.notify_all();
+            throw;
+        }
+        work_available.notify_one();
+    }
+
+    void Work_Stealing_Pool::wait()
+    {
+        std::unique_lock<std::mutex> lock(state_mutex);
+        task_finished.wait(lock, [this]() { return unfinished == 0; });
+        if(first_error)
+        {
+            auto error = first_error;
+            first_error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    void Work_Stealing_Pool::wait_for_pending_below(size_t limit)
+    {
+        std::unique_lock<std::mutex> lock(state_mutex);
+        task_finished.wait(lock, [this, limit]() { return unfinished < limit; });
+    }
+
+    size_t Work_Stealing_Pool::size() const
+    {
+        return threads.size();
+    }
+
+    size_t Work_Stealing_Pool::pending() const
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        return unfinished;
+    }
+
+    uint64_t Work_Stealing_Pool::steals() const
+    {
+        return steal_count;
+    }
+
+    bool Work_Stealing_Pool::take(size_t index, Task & task)
+    {
+        {
+            auto & own = *queues[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if(!own.tasks.empty())
+            {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for(size_t offset = 1; offset < queues.size(); ++offset)
+        {
+            auto & other = *queues[(index + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(other.mutex);
+            if(!other.tasks.empty())
+            {
+                task = std::move(other.tasks.front());
+                other.tasks.pop_front();
+                ++steal_count;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Work_Stealing_Pool::finished_task()
+    {
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            --unfinished;
+        }
+        task_finished.notify_all();
+    }
+
+    void Work_Stealing_Pool::run(size_t index)
+    {
+        current_pool = this;
+        current_worker = index;
+        for(;;)
+        {
+            Task task;
+            if(take(index, task))
+            {
+                {
+                    std::lock_guard<std::mutex> lock(state_mutex);
+                    --queued;
+                }
+                try
+                {
+                    task();
+                }
+                catch(...)
+                {
+                    std::lock_guard<std::mutex> lock(state_mutex);
+                    if(!first_error)
+                    {
+                        first_error = std::current_exception();
+                    }
+                }
+                finished_task();
+                continue;
+            }
+            // A task is still counted in queued for a moment after another worker has taken
+            // it, so waking up does not guarantee finding one
+            std::unique_lock<std::mutex> lock(state_mutex);
+            work_available.wait(lock, [this]() { return stopping || queued > 0; });
+            if(stopping && queued == 0)
+            {
+                return;
+            }
+        }
+    }
+}   // namespace wincalc
@@ -0,0 +1,79 @@
+#ifndef WINCALC_THREAD_POOL_H_
+#define WINCALC_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace wincalc
+{
+    // Fixed size pool of worker threads with one task queue per worker.  Tasks submitted from
+    // outside the pool are spread over the queues in turn, tasks submitted by a task go to the
+    // queue of the worker running it.  A worker takes the newest task from its own queue and
+    // when that is empty steals the oldest task from another worker's queue, so a worker that
+    // drew a few slow systems does not hold up the others.
+    class Work_Stealing_Pool
+    {
+    public:
+        using Task = std::function<void()>;
+
+        // 0 uses one thread per core
+        explicit Work_Stealing_Pool(size_t number_of_threads = 0);
+        // Runs every task already submitted before returning
+        ~Work_Stealing_Pool();
+
+        Work_Stealing_Pool(Work_Stealing_Pool const &) = delete;
+        Work_Stealing_Pool & operator=(Work_Stealing_Pool const &) = delete;
+
+        void submit(Task task);
+
+        // Blocks until every submitted task has finished.  If any task threw, the first
+        // exception is rethrown here and forgotten.
+        void wait();
+
+        // Blocks until fewer than limit tasks are submitted and not finished.  Used by
+        // producers to bound the number of queued tasks.
+        void wait_for_pending_below(size_t limit);
+
+        size_t size() const;
+        // Tasks submitted and not yet finished
+        size_t pending() const;
+        // Tasks a worker took from another worker's queue since the pool was created
+        uint64_t steals() const;
+
+    private:
+        struct Worker_Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void stop_workers();
+        void run(size_t index);
+        bool take(size_t index, Task & task);
+        void finished_task();
+
+        std::vector<std::unique_ptr<Worker_Queue>> queues;
+        std::vector<std::thread> threads;
+        mutable std::mutex state_mutex;
+        std::condition_variable work_available;
+        std::condition_variable task_finished;
+        // Both guarded by state_mutex.  queued counts tasks not yet taken by a worker,
+        // unfinished counts tasks not yet finished.
+        size_t queued = 0;
+        size_t unfinished = 0;
+        bool stopping = false;
+        std::exception_ptr first_error;
+        std::atomic<size_t> next_queue{0};
+        std::atomic<uint64_t> steal_count{0};
+    };
+}   // namespace wincalc
+
+#endif
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN
+#    endif
+#    include <windows.h>
+#    include <psapi.h>
+#else
+#    include <sys/resource.h>
+#endif
+
+#include "workload.h"
+#include "util.h"
+
+namespace wincalc::workload
+{
+    namespace
+    {
+        // std::uniform_int_distribution and friends differ between standard libraries, the
+        // engine itself does not, so values are drawn straight from the engine
+        size_t pick(std::mt19937_64 & random, size_t count)
+        {
+            return static_cast<size_t>(random() % count);
+        }
+
+        bool chance(std::mt19937_64 & random, double probability)
+        {
+            return static_cast<double>(random() >> 11) / 9007199254740992.0 < probability;
+        }
+
+        template<typename T>
+        T const & pick_from(std::mt19937_64 & random, std::vector<T> const & values)
+        {
+            return values[pick(random, values.size())];
+        }
+
+        std::string const shade_material = "igsdb_12852.json";
+
+        double percentile(std::vector<double> const & sorted, double fraction)
+        {
+            if(sorted.empty())
+            {
+                return 0;
+            }
+            auto rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+            return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+        }
+    }   // namespace
+
+    std::map<Glazing_Type, std::vector<std::string>> const & glazing_products()
+    {
+        static const std::map<Glazing_Type, std::vector<std::string>> products{
+          {Glazing_Type::CLEAR, {"CLEAR_3.json", "igsdb_5406.json"}},
+          {Glazing_Type::LOW_E,
+           {"igsdb_5051.json", "6046.json", "CG_Prem2_5.json", "SolarEPlusArBl6.json"}},
+          {Glazing_Type::LAMINATE, {"cgdb_18000.json", "igsdb_9817.json"}},
+          {Glazing_Type::PV, {"generic_pv.json"}}};
+        return products;
+    }
+
+    std::vector<System_Definition> generate_workload(Workload_Options const & options)
+    {
+        if(options.max_glazings == 0 || options.angles.empty())
+        {
+            throw std::runtime_error("A workload needs at least one glazing and one angle");
+        }
+        auto const & products = glazing_products();
+        const std::vector<Glazing_Type> pane_types{
+          Glazing_Type::CLEAR, Glazing_Type::LOW_E, Glazing_Type::LAMINATE};
+        const std::vector<Gases::GasDef> gases{
+          Gases::GasDef::Air, Gases::GasDef::Argon, Gases::GasDef::Krypton};
+        const std::vector<double> gap_widths{0.0095, 0.0127, 0.016};
+        const std::vector<Shade_Type> shade_types{
+          Shade_Type::VENETIAN, Shade_Type::WOVEN, Shade_Type::PERFORATED};
+
+        std::mt19937_64 random(options.seed);
+        std::vector<System_Definition> systems(options.number_of_systems);
+        for(auto & system : systems)
+        {
+            auto number_of_glazings = 1 + pick(random, options.max_glazings);
+            for(size_t i = 0; i < number_of_glazings; ++i)
+            {
+                auto type = i == 0 && chance(random, options.pv_fraction)
+                              ? Glazing_Type::PV
+                              : pick_from(random, pane_types);
+                system.glazings.push_back(pick_from(random, products.at(type)));
+                if(i > 0)
+                {
+                    system.gaps.push_back(
+                      Gap_Definition{pick_from(random, gases), pick_from(random, gap_widths)});
+                }
+            }
+            if(chance(random, options.shade_fraction))
+            {
+                system.shade = pick_from(random, shade_types);
+                system.gaps.push_back(Gap_Definition{Gases::GasDef::Air, 0.0127});
+            }
+            system.theta = pick_from(random, options.angles);
+        }
+        return systems;
+    }
+
+    Workload_Products::Workload_Products(std::string const & products_directory)
+    {
+        auto path = [&products_directory](std::string const & file_name) {
+            return (std::filesystem::path(products_directory) / file_name).string();
+        };
+        OpticsParser::Parser parser;
+        for(auto const & type : glazing_products())
+        {
+            for(auto const & file_name : type.second)
+            {
+                glazings.emplace(file_name,
+                                 convert_to_solid_layer(parser.parseJSONFile(path(file_name))));
+            }
+        }
+        auto material = parser.parseJSONFile(path(shade_material));
+        shades.emplace(Shade_Type::VENETIAN,
+                       create_venetian_blind(Venetian_Geometry{45, 0.05, 0.07, 0.03}, material));
+        shades.emplace(Shade_Type::WOVEN,
+                       create_woven_shade(Woven_Geometry{0.002, 0.003, 0.002}, material));
+        shades.emplace(
+          Shade_Type::PERFORATED,
+          create_perforated_screen(
+            Perforated_Geometry{0.02, 0.03, 0.002, 0.003, Perforated_Geometry::Type::RECTANGULAR},
+            material));
+    }
+
+    std::vector<Product_Data_Optical_Thermal>
+      Workload_Products::layers(System_Definition const & system) const
+    {
+        std::vector<Product_Data_Optical_Thermal> result;
+        for(auto const & file_name : system.glazings)
+        {
+            auto glazing = glazings.find(file_name);
+            if(glazing == glazings.end())
+            {
+                std::stringstream msg;
+                msg << "Product " << file_name << " is not part of the workload products";
+                throw std::runtime_error(msg.str());
+            }
+            result.push_back(glazing->second);
+        }
+        if(system.shade != Shade_Type::NONE)
+        {
+            result.push_back(shades.at(system.shade));
+        }
+        return result;
+    }
+
+    Glazing_System create_glazing_system(System_Definition const & system,
+                                         Workload_Products const & products,
+                                         window_standards::Optical_Standard const & standard)
+    {
+        std::vector<Engine_Gap_Info> gaps;
+        for(auto const & gap : system.gaps)
+        {
+            gaps.emplace_back(gap.gas, gap.thickness);
+        }
+        std::optional<SingleLayerOptics::CBSDFHemisphere> bsdf_hemisphere;
+        if(system.shade != Shade_Type::NONE)
+        {
+            static const auto quarter_basis =
+              SingleLayerOptics::CBSDFHemisphere::create(SingleLayerOptics::BSDFBasis::Quarter);
+            bsdf_hemisphere = quarter_basis;
+        }
+        return Glazing_System(standard,
+                              products.layers(system),
+                              std::move(gaps),
+                              1.0,
+                              1.0,
+                              90,
+                              nfrc_u_environments(),
+                              bsdf_hemisphere);
+    }
+
+    Workload_Results run_workload(std::vector<System_Definition> const & systems,
+                                  Workload_Products const & products,
+                                  window_standards::Optical_Standard const & standard,
+                                  size_t number_of_threads)
+    {
+        std::vector<double> latencies(systems.size());
+        std::vector<char> failed(systems.size(), 0);
+        std::vector<std::string> errors(systems.size());
+        auto threads = thread_count(number_of_threads, systems.size());
+        // Systems are handed out one at a time rather than in fixed blocks so the time at a
+        // number of threads does not depend on where the slow shade systems are in the list
+        std::atomic<size_t> next_system{0};
+        auto start = std::chrono::steady_clock::now();
+        parallel_for(threads, threads, [&](size_t, size_t) {
+            for(size_t i = next_system++; i < systems.size(); i = next_system++)
+            {
+                auto system_start = std::chrono::steady_clock::now();
+                try
+                {
+                    auto theta = systems[i].theta;
+                    auto system = create_glazing_system(systems[i], products, standard);
+                    system.u(theta);
+                    system.environments(nfrc_shgc_environments());
+                    system.shgc(theta);
+                    system.optical_method_results("SOLAR", theta);
+                }
+                catch(std::exception const & e)
+                {
+                    failed[i] = 1;
+                    errors[i] = e.what();
+                }
+                latencies[i] = std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() - system_start)
+                                 .count();
+            }
+        });
+        auto seconds =
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        Workload_Results results;
+        results.number_of_threads = threads;
+        results.number_of_systems = systems.size();
+        results.seconds = seconds;
+        results.systems_per_second = seconds > 0 ? systems.size() / seconds : 0;
+        std::vector<double> succeeded;
+        for(size_t i = 0; i < systems.size(); ++i)
+        {
+            if(failed[i])
+            {
+                if(results.failures == 0)
+                {
+                    std::stringstream msg;
+                    msg << "System " << i << ": " << errors[i];
+                    results.first_error = msg.str();
+                }
+                ++results.failures;
+            }
+            else
+            {
+                succeeded.push_back(latencies[i]);
+            }
+        }
+        std::sort(succeeded.begin(), succeeded.end());
+        results.latency_p50_ms = percentile(succeeded, 0.5);
+        results.latency_p90_ms = percentile(succeeded, 0.9);
+        results.latency_p99_ms = percentile(succeeded, 0.99);
+        results.latency_max_ms = succeeded.empty() ? 0 : succeeded.back();
+        results.peak_memory_bytes = peak_memory_bytes();
+        return results;
+    }
+
+    uint64_t peak_memory_bytes()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+        }
+        return 0;
+#else
+        rusage usage;
+        if(getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            return 0;
+        }
+#    ifdef __APPLE__
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#    else
+        // Linux reports kilobytes
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#    endif
+#endif
+    }
+}   // namespace wincalc::workload
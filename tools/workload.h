@@ -0,0 +1,118 @@
+#ifndef WINCALC_WORKLOAD_H_
+#define WINCALC_WORKLOAD_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "wincalc/wincalc.h"
+
+// Synthetic workloads for scaling tests.  generate_workload combines the products in
+// test/products into glazing systems of one to max_glazings glazings with gaps of different
+// gases and widths, some with an interior shade, some with a PV outer pane, at different
+// incidence angles.  The same options always give the same systems on every platform.
+//
+// run_workload calculates U, SHGC and the solar optical results of every system on a number
+// of threads, each taking the next system when it finishes one, and reports throughput,
+// latency percentiles and peak memory.
+
+namespace wincalc::workload
+{
+    enum class Glazing_Type
+    {
+        CLEAR,
+        LOW_E,
+        LAMINATE,
+        PV
+    };
+
+    enum class Shade_Type
+    {
+        NONE,
+        VENETIAN,
+        WOVEN,
+        PERFORATED
+    };
+
+    struct Gap_Definition
+    {
+        Gases::GasDef gas;
+        double thickness;
+    };
+
+    struct System_Definition
+    {
+        // Product files in the products directory, outside first
+        std::vector<std::string> glazings;
+        // One less than the number of glazings, plus one more for a shade
+        std::vector<Gap_Definition> gaps;
+        // Interior shade made from the igsdb_12852 slat material, the same shades as the
+        // user shade tests
+        Shade_Type shade = Shade_Type::NONE;
+        double theta = 0;
+    };
+
+    // Product files used for each glazing type
+    std::map<Glazing_Type, std::vector<std::string>> const & glazing_products();
+
+    struct Workload_Options
+    {
+        size_t number_of_systems = 1000;
+        uint64_t seed = 1;
+        size_t max_glazings = 3;
+        // Chance of a system having an interior shade or a PV outer pane
+        double shade_fraction = 0.25;
+        double pv_fraction = 0.05;
+        std::vector<double> angles{0, 30, 45, 60};
+    };
+
+    std::vector<System_Definition> generate_workload(Workload_Options const & options);
+
+    // Converted products for building the systems of a workload.  Every product is parsed and
+    // converted once when this is created and shared by every system built from it, so
+    // layers can be called from several threads at the same time.
+    class Workload_Products
+    {
+    public:
+        explicit Workload_Products(std::string const & products_directory);
+
+        std::vector<Product_Data_Optical_Thermal> layers(System_Definition const & system) const;
+
+    private:
+        std::map<std::string, Product_Data_Optical_Thermal> glazings;
+        std::map<Shade_Type, Product_Data_Optical_Thermal> shades;
+    };
+
+    Glazing_System create_glazing_system(System_Definition const & system,
+                                         Workload_Products const & products,
+                                         window_standards::Optical_Standard const & standard);
+
+    struct Workload_Results
+    {
+        size_t number_of_threads = 0;
+        size_t number_of_systems = 0;
+        // Systems that threw while being calculated and the error of the first of them
+        size_t failures = 0;
+        std::string first_error;
+        double seconds = 0;
+        double systems_per_second = 0;
+        // Time to calculate one system
+        double latency_p50_ms = 0;
+        double latency_p90_ms = 0;
+        double latency_p99_ms = 0;
+        double latency_max_ms = 0;
+        // Peak resident memory of the process so far, not just of this run.  Zero where the
+        // platform does not report it.
+        uint64_t peak_memory_bytes = 0;
+    };
+
+    Workload_Results run_workload(std::vector<System_Definition> const & systems,
+                                  Workload_Products const & products,
+                                  window_standards::Optical_Standard const & standard,
+                                  size_t number_of_threads);
+
+    uint64_t peak_memory_bytes();
+}   // namespace wincalc::workload
+
+#endif
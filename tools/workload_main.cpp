@@ -0,0 +1,170 @@
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "workload.h"
+
+// Runs a synthetic workload at each of a list of thread counts and prints one line of results
+// per thread count.  See usage() for the options.
+
+namespace
+{
+    void usage(std::ostream & output)
+    {
+        output << "Usage: wincalc-workload [options]\n"
+               << "  --systems <n>         number of glazing systems (1000)\n"
+               << "  --seed <n>            seed of the generator (1)\n"
+               << "  --max-glazings <n>    most glazings in one system (3)\n"
+               << "  --shade-fraction <x>  fraction of systems with a shade (0.25)\n"
+               << "  --threads <a,b,...>   thread counts to run, 0 is one per core (1,2,4,8)\n"
+               << "  --test-dir <path>     directory with products/ and standards/\n"
+               << "  --list                print the systems instead of running them\n";
+    }
+
+    std::vector<size_t> parse_thread_counts(std::string const & text)
+    {
+        std::vector<size_t> counts;
+        std::stringstream input(text);
+        std::string item;
+        while(std::getline(input, item, ','))
+        {
+            counts.push_back(std::stoul(item));
+        }
+        return counts;
+    }
+
+    char const * shade_name(wincalc::workload::Shade_Type shade)
+    {
+        switch(shade)
+        {
+            case wincalc::workload::Shade_Type::VENETIAN:
+                return "venetian";
+            case wincalc::workload::Shade_Type::WOVEN:
+                return "woven";
+            case wincalc::workload::Shade_Type::PERFORATED:
+                return "perforated";
+            case wincalc::workload::Shade_Type::NONE:
+                break;
+        }
+        return "none";
+    }
+}   // namespace
+
+int main(int argc, char * argv[])
+{
+    wincalc::workload::Workload_Options options;
+    std::vector<size_t> thread_counts{1, 2, 4, 8};
+    char const * environment_dir = std::getenv("WINCALC_TEST_DIR");
+    std::string test_dir = environment_dir ? environment_dir : WINCALC_TEST_DIR;
+    bool list = false;
+
+    try
+    {
+        for(int i = 1; i < argc; ++i)
+        {
+            std::string argument(argv[i]);
+            auto value = [&]() {
+                if(i + 1 >= argc)
+                {
+                    throw std::runtime_error("Missing value for " + argument);
+                }
+                return std::string(argv[++i]);
+            };
+            if(argument == "--systems")
+            {
+                options.number_of_systems = std::stoul(value());
+            }
+            else if(argument == "--seed")
+            {
+                options.seed = std::stoull(value());
+            }
+            else if(argument == "--max-glazings")
+            {
+                options.max_glazings = std::stoul(value());
+            }
+            else if(argument == "--shade-fraction")
+            {
+                options.shade_fraction = std::stod(value());
+            }
+            else if(argument == "--threads")
+            {
+                thread_counts = parse_thread_counts(value());
+            }
+            else if(argument == "--test-dir")
+            {
+                test_dir = value();
+            }
+            else if(argument == "--list")
+            {
+                list = true;
+            }
+            else if(argument == "--help")
+            {
+                usage(std::cout);
+                return 0;
+            }
+            else
+            {
+                throw std::runtime_error("Unknown option " + argument);
+            }
+        }
+
+        auto systems = wincalc::workload::generate_workload(options);
+        if(list)
+        {
+            for(auto const & system : systems)
+            {
+                for(size_t i = 0; i < system.glazings.size(); ++i)
+                {
+                    std::cout << (i == 0 ? "" : " | ") << system.glazings[i];
+                }
+                std::cout << " | shade " << shade_name(system.shade) << " | gaps "
+                          << system.gaps.size() << " | theta " << system.theta << "\n";
+            }
+            return 0;
+        }
+
+        std::filesystem::path directory(test_dir);
+        wincalc::workload::Workload_Products products((directory / "products").string());
+        auto standard = window_standards::load_optical_standard(
+          (directory / "standards" / "W5_NFRC_2003.std").string());
+
+        std::cout << "threads  systems  failures  seconds  systems/s  p50 ms  p90 ms  p99 ms"
+                  << "  max ms  peak MB\n";
+        std::cout << std::fixed << std::setprecision(2);
+        size_t failures = 0;
+        for(auto threads : thread_counts)
+        {
+            auto results = wincalc::workload::run_workload(systems, products, standard, threads);
+            if(results.failures > 0 && failures == 0)
+            {
+                std::cerr << results.failures << " systems failed on " << results.number_of_threads
+                          << " threads, first: " << results.first_error << "\n";
+            }
+            failures += results.failures;
+            std::cout << std::setw(7) << results.number_of_threads << std::setw(9)
+                      << results.number_of_systems << std::setw(10) << results.failures
+                      << std::setw(9) << results.seconds << std::setw(11)
+                      << results.systems_per_second << std::setw(8) << results.latency_p50_ms
+                      << std::setw(8) << results.latency_p90_ms << std::setw(8)
+                      << results.latency_p99_ms << std::setw(8) << results.latency_max_ms
+                      << std::setw(9) << results.peak_memory_bytes / (1024.0 * 1024.0) << "\n";
+        }
+        if(failures > 0)
+        {
+            return 1;
+        }
+    }
+    catch(std::exception const & e)
+    {
+        std::cerr << e.what() << "\n";
+        usage(std::cerr);
+        return 1;
+    }
+    return 0;
+}